@@ -1,4 +1,12 @@
 #include <stdint.h>
+#include <string.h>
+
+#include "sanctum_config.h"
+/*
+  provides:
+  - NUM_HARTS, REGION_SIZE
+  - SM_MEASUREMENT_MODE, SM_MEASUREMENT_LEAF_SIZE
+*/
 
 #include "sha3/sha3.h"
 /*
@@ -11,6 +19,14 @@
   types: sha3_ctx_t
 */
 
+#include "sm_measurement.h"
+/*
+  provides:
+  - sm_measured_manifest, sm_serial_hash
+  - sm_tree_leaf_count, sm_tree_hash_leaf, sm_tree_root
+  types: sm_manifest_t, sm_tree_header_t
+*/
+
 #define ED25519_NO_SEED 1
 #include "ed25519/ed25519.h"
 /* Adopted from https://github.com/orlp/ed25519
@@ -46,9 +62,11 @@ extern uint8_t SM_H[64];
 extern uint8_t PK_SM[32];
 extern uint8_t SK_SM[64];
 extern uint8_t SM_SIG[64];
+extern uint64_t sm_measurement_mode;
 
 extern const void* sm_ptr;
 extern const size_t sm_size;
+extern const sm_manifest_t sm_manifest;
 
 extern volatile uint64_t fromhost;
 extern volatile uint64_t tohost;
@@ -57,7 +75,7 @@ extern volatile uint64_t tohost;
   (((uint64_t)(dev) << 56) | ((uint64_t)(cmd) << 48) | (uint64_t)(payload))
 
 void print_char(char c) {
-  // No synchronization needed, as the bootloader runs solely on core 0
+  // No synchronization needed, as only core 0 prints
 
   while (tohost) {
     // spin
@@ -89,7 +107,90 @@ void print_hex_byte(uint8_t b) {
   print_nibble(b & 0xF);        // low-order nibble
 }
 
-void __attribute__ ((section (".text.bootloader.entry"))) rot_bootloader() {
+// Zeroes the SM's zero-fill segments, which are measured by length only.
+static void zero_fill_sm(const sm_manifest_t* manifest) {
+  uint8_t* segment_ptr = (uint8_t*)&sm_ptr;
+  for (uint64_t i = 0; i < manifest->segment_count; i++) {
+    if (manifest->segments[i].kind == MANIFEST_SEGMENT_ZERO) {
+      memset(segment_ptr, 0, manifest->segments[i].length);
+    }
+    segment_ptr += manifest->segments[i].length;
+  }
+}
+
+#if SM_MEASUREMENT_MODE == SM_MEASUREMENT_TREE
+
+// See sm_measurement.h for the tree layout.
+
+#define SM_MEASUREMENT_MAX_LEAVES \
+  ((REGION_SIZE + SM_MEASUREMENT_LEAF_SIZE - 1) / SM_MEASUREMENT_LEAF_SIZE)
+
+// These live in the bootloader's .bss, which the ROT zeroes before jumping
+// here.
+static volatile uint64_t sm_leaf_next;    // next leaf to be claimed
+static volatile uint64_t sm_leaf_done;    // leaves hashed so far
+static volatile uint64_t sm_harts_parked; // other harts done measuring
+static uint8_t sm_leaf_hash[SM_MEASUREMENT_MAX_LEAVES][64];
+
+// Claims and hashes leaves until none are left.
+static void measure_sm_leaves(const sm_manifest_t* manifest) {
+  const uint64_t leaf_count = sm_tree_leaf_count(
+      sm_manifest_loaded_size(manifest), SM_MEASUREMENT_LEAF_SIZE);
+
+  while (1) {
+    uint64_t leaf = __sync_fetch_and_add(&sm_leaf_next, 1);
+    if (leaf >= leaf_count) {
+      break;
+    }
+    sm_tree_hash_leaf((const uint8_t*)&sm_ptr, manifest,
+        SM_MEASUREMENT_LEAF_SIZE, leaf, sm_leaf_hash[leaf]);
+    __sync_fetch_and_add(&sm_leaf_done, 1);
+  }
+}
+
+// Entry point for harts other than 0, reached via bootloader_entry + 4.
+//
+// The ROT has re-armed the boot IPI before jumping here, so the hart parks
+// without touching its stack again, and hart 0 erases the stacks only after
+// every other hart has parked.
+void __attribute__ ((noreturn)) rot_bootloader_other_hart() {
+  sm_manifest_t manifest;
+  sm_measured_manifest(&manifest, &sm_manifest, sm_size);
+  measure_sm_leaves(&manifest);
+  __sync_fetch_and_add(&sm_harts_parked, 1);
+  while (1) {
+    asm volatile ("wfi");
+  }
+}
+
+// Computes SM_H as the root over the leaf digests, helping with the leaves.
+static void measure_sm() {
+  sm_manifest_t manifest;
+  sm_measured_manifest(&manifest, &sm_manifest, sm_size);
+  zero_fill_sm(&manifest);
+  measure_sm_leaves(&manifest);
+
+  while (sm_leaf_done < sm_tree_leaf_count(sm_manifest_loaded_size(&manifest),
+      SM_MEASUREMENT_LEAF_SIZE)) {
+    // spin
+  }
+
+  sm_tree_root(SM_H, SM_MEASUREMENT_TREE, &manifest,
+      SM_MEASUREMENT_LEAF_SIZE, &sm_leaf_hash[0][0]);
+}
+
+#else  // SM_MEASUREMENT_MODE == SM_MEASUREMENT_SERIAL
+
+static void measure_sm() {
+  sm_manifest_t manifest;
+  sm_measured_manifest(&manifest, &sm_manifest, sm_size);
+  zero_fill_sm(&manifest);
+  sm_serial_hash(SM_H, (const uint8_t*)&sm_ptr, &manifest);
+}
+
+#endif  // SM_MEASUREMENT_MODE
+
+void rot_bootloader() {
   uint8_t scratchpad[64];
   sha3_ctx_t hash_ctx;
   uint8_t SK_D[64];
@@ -117,7 +218,8 @@ void __attribute__ ((section (".text.bootloader.entry"))) rot_bootloader() {
   print_str("\nTrusted manufacturer (host) should endorse this key in order to root the device's attestations.\n\n");
 
   // Measure the SM
-  sha3(&sm_ptr, sm_size, SM_H, 64);
+  measure_sm();
+  sm_measurement_mode = SM_MEASUREMENT_MODE;
 
   // Derive SM keys from H(SK_D, H(SM))
   // scratchpad <-- H(SK_D H(SM))
@@ -130,13 +232,21 @@ void __attribute__ ((section (".text.bootloader.entry"))) rot_bootloader() {
   ed25519_create_keypair(PK_SM, SK_SM, scratchpad);
 
   // Endorse the SM with PK_D
-  // scratchpad <-- H(H(SM), PK_SM)
+  // scratchpad <-- H(H(SM), PK_SM, measurement mode)
   sha3_init(&hash_ctx, 64);
   sha3_update(&hash_ctx, SM_H, 64);
   sha3_update(&hash_ctx, PK_SM, 32);
+  sha3_update(&hash_ctx, &sm_measurement_mode, 8);
   sha3_final(scratchpad, &hash_ctx);
   // Sign scratchpad with SK_D
   ed25519_sign(SM_SIG, scratchpad, 64, PK_D, SK_D);
 
+#if SM_MEASUREMENT_MODE == SM_MEASUREMENT_TREE
+  // The ROT erases every hart's stack once we return
+  while (sm_harts_parked < NUM_HARTS - 1) {
+    // spin
+  }
+#endif
+
   return; // NOTE: stack and hart state will be cleaned before boot
 }
@@ -1,6 +1,6 @@
 /*
 
-This is an implementation of the AES algorithm, specifically ECB, CTR and CBC mode.
+This is an implementation of the AES algorithm, specifically ECB, CTR, CBC and GCM mode.
 Block size can be chosen in aes.h - available choices are AES128, AES192, AES256.
 
 The implementation is verified against the test vectors in:
@@ -29,6 +29,21 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
         You should pad the end of the string with zeros if this is not the case.
         For AES192/256 the key size is proportionally larger.
 
+The portable cipher is bitsliced, after the "ct64" core of BearSSL: four blocks
+are spread over eight 64-bit words, one word per bit of every state byte, and
+each round is a fixed sequence of word operations. There are no table lookups,
+so the running time and the cache footprint do not depend on the key or the
+data, which matters for the monitor since it shares caches with enclaves. CTR
+and CBC decryption run the core on four blocks at a time. CBC encryption can
+only use one of the four, so each block costs about as much as four ECB blocks,
+and it is no faster, on some hosts slower, than the table-driven cipher this
+core replaced.
+
+GCM is checked against test cases 2 to 4 of McGrew and Viega, "The Galois/
+Counter Mode of Operation (GCM)". GHASH multiplies without tables as well,
+after BearSSL's ghash_ctmul64, or with clmul/clmulh on RV64 with Zbc or Zbkc.
+It folds in four blocks per reduction, using H^1 .. H^4 from the context.
+
 */
 
 
@@ -36,7 +51,7 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
 /* Includes:                                                                 */
 /*****************************************************************************/
 #include <stdint.h>
-#include <string.h> // CBC mode, for memset
+#include <string.h> // for memcpy/memset
 #include "aes.h"
 
 /*****************************************************************************/
@@ -56,12 +71,34 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
     #define Nr 10       // The number of rounds in AES Cipher.
 #endif
 
-// jcallan@github points out that declaring Multiply as a function 
-// reduces code size considerably with the Keil ARM compiler.
-// See this link for more information: https://github.com/kokke/tiny-AES-C/pull/3
-#ifndef MULTIPLY_AS_A_FUNCTION
-  #define MULTIPLY_AS_A_FUNCTION 0
+// The number of blocks the cipher core works on in one pass. CTR, CBC
+// decryption and AES_ECB_encrypt_blocks() hand it this many blocks at a time.
+#define AES_PARALLEL_BLOCKS 4
+
+// On RV64 with the scalar crypto extensions, a round of the cipher is a pair of
+// aes64es*/aes64ds* instructions on the two halves of the state. GCC defines
+// __riscv_zkne/__riscv_zknd when they are in the -march string; otherwise the
+// portable bitsliced rounds below are used.
+#if defined(__riscv_zkne) && (__riscv_xlen == 64)
+  #define AES_RISCV_ZKNE 1
+#else
+  #define AES_RISCV_ZKNE 0
+#endif
+#if defined(__riscv_zknd) && (__riscv_xlen == 64)
+  #define AES_RISCV_ZKND 1
+#else
+  #define AES_RISCV_ZKND 0
 #endif
+// GHASH uses the carry-less multiplies of Zbc or Zbkc in the same way.
+#if (defined(__riscv_zbc) || defined(__riscv_zbkc)) && (__riscv_xlen == 64)
+  #define AES_RISCV_CLMUL 1
+#else
+  #define AES_RISCV_CLMUL 0
+#endif
+
+// The compressed bitsliced key schedule takes two words per round key.
+typedef char sliced_key_fits_ctx[
+    (sizeof(((struct AES_ctx*)0)->SlicedKey) == 2 * (Nr + 1) * sizeof(uint64_t)) ? 1 : -1];
 
 
 
@@ -69,52 +106,7 @@ NOTE:   String length must be evenly divisible by 16byte (str_len % 16 == 0)
 /*****************************************************************************/
 /* Private variables:                                                        */
 /*****************************************************************************/
-// state - array holding the intermediate results during decryption.
-typedef uint8_t state_t[4][4];
-
-
-
-// The lookup-tables are marked const so they can be placed in read-only storage instead of RAM
-// The numbers below can be computed dynamically trading ROM for RAM - 
-// This can be useful in (embedded) bootloader applications, where ROM is often limited.
-static const uint8_t sbox[256] = {
-  //0     1    2      3     4    5     6     7      8    9     A      B    C     D     E     F
-  0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
-  0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
-  0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
-  0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
-  0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
-  0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
-  0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
-  0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
-  0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
-  0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
-  0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
-  0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
-  0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
-  0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
-  0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
-  0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 };
-
-static const uint8_t rsbox[256] = {
-  0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
-  0x7c, 0xe3, 0x39, 0x82, 0x9b, 0x2f, 0xff, 0x87, 0x34, 0x8e, 0x43, 0x44, 0xc4, 0xde, 0xe9, 0xcb,
-  0x54, 0x7b, 0x94, 0x32, 0xa6, 0xc2, 0x23, 0x3d, 0xee, 0x4c, 0x95, 0x0b, 0x42, 0xfa, 0xc3, 0x4e,
-  0x08, 0x2e, 0xa1, 0x66, 0x28, 0xd9, 0x24, 0xb2, 0x76, 0x5b, 0xa2, 0x49, 0x6d, 0x8b, 0xd1, 0x25,
-  0x72, 0xf8, 0xf6, 0x64, 0x86, 0x68, 0x98, 0x16, 0xd4, 0xa4, 0x5c, 0xcc, 0x5d, 0x65, 0xb6, 0x92,
-  0x6c, 0x70, 0x48, 0x50, 0xfd, 0xed, 0xb9, 0xda, 0x5e, 0x15, 0x46, 0x57, 0xa7, 0x8d, 0x9d, 0x84,
-  0x90, 0xd8, 0xab, 0x00, 0x8c, 0xbc, 0xd3, 0x0a, 0xf7, 0xe4, 0x58, 0x05, 0xb8, 0xb3, 0x45, 0x06,
-  0xd0, 0x2c, 0x1e, 0x8f, 0xca, 0x3f, 0x0f, 0x02, 0xc1, 0xaf, 0xbd, 0x03, 0x01, 0x13, 0x8a, 0x6b,
-  0x3a, 0x91, 0x11, 0x41, 0x4f, 0x67, 0xdc, 0xea, 0x97, 0xf2, 0xcf, 0xce, 0xf0, 0xb4, 0xe6, 0x73,
-  0x96, 0xac, 0x74, 0x22, 0xe7, 0xad, 0x35, 0x85, 0xe2, 0xf9, 0x37, 0xe8, 0x1c, 0x75, 0xdf, 0x6e,
-  0x47, 0xf1, 0x1a, 0x71, 0x1d, 0x29, 0xc5, 0x89, 0x6f, 0xb7, 0x62, 0x0e, 0xaa, 0x18, 0xbe, 0x1b,
-  0xfc, 0x56, 0x3e, 0x4b, 0xc6, 0xd2, 0x79, 0x20, 0x9a, 0xdb, 0xc0, 0xfe, 0x78, 0xcd, 0x5a, 0xf4,
-  0x1f, 0xdd, 0xa8, 0x33, 0x88, 0x07, 0xc7, 0x31, 0xb1, 0x12, 0x10, 0x59, 0x27, 0x80, 0xec, 0x5f,
-  0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef,
-  0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61,
-  0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d };
-
-// The round constant word array, Rcon[i], contains the values given by 
+// The round constant word array, Rcon[i], contains the values given by
 // x to the power (i-1) being powers of x (x is denoted as {02}) in the field GF(2^8)
 static const uint8_t Rcon[11] = {
   0x8d, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
@@ -124,8 +116,8 @@ static const uint8_t Rcon[11] = {
  * that you can remove most of the elements in the Rcon array, because they are unused.
  *
  * From Wikipedia's article on the Rijndael key schedule @ https://en.wikipedia.org/wiki/Rijndael_key_schedule#Rcon
- * 
- * "Only the first some of these constants are actually used – up to rcon[10] for AES-128 (as 11 round keys are needed), 
+ *
+ * "Only the first some of these constants are actually used – up to rcon[10] for AES-128 (as 11 round keys are needed),
  *  up to rcon[8] for AES-192, up to rcon[7] for AES-256. rcon[0] is not used in AES algorithm."
  */
 
@@ -133,326 +125,847 @@ static const uint8_t Rcon[11] = {
 /*****************************************************************************/
 /* Private functions:                                                        */
 /*****************************************************************************/
-/*
-static uint8_t getSBoxValue(uint8_t num)
+static inline uint32_t LoadWord(const uint8_t* p)
 {
-  return sbox[num];
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+      ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
 }
-*/
-#define getSBoxValue(num) (sbox[(num)])
-/*
-static uint8_t getSBoxInvert(uint8_t num)
+
+static inline void StoreWord(uint8_t* p, uint32_t x)
 {
-  return rsbox[num];
+  p[0] = (uint8_t)x;
+  p[1] = (uint8_t)(x >> 8);
+  p[2] = (uint8_t)(x >> 16);
+  p[3] = (uint8_t)(x >> 24);
 }
-*/
-#define getSBoxInvert(num) (rsbox[(num)])
 
-// This function produces Nb(Nr+1) round keys. The round keys are used in each round to decrypt the states. 
-static void KeyExpansion(uint8_t* RoundKey, const uint8_t* Key)
+static inline uint32_t LoadBigEndian32(const uint8_t* p)
 {
-  unsigned i, j, k;
-  uint8_t tempa[4]; // Used for the column/row operations
-  
-  // The first round key is the key itself.
-  for (i = 0; i < Nk; ++i)
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+      ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline void StoreBigEndian32(uint8_t* p, uint32_t x)
+{
+  p[0] = (uint8_t)(x >> 24);
+  p[1] = (uint8_t)(x >> 16);
+  p[2] = (uint8_t)(x >> 8);
+  p[3] = (uint8_t)x;
+}
+
+static inline uint64_t LoadBigEndian64(const uint8_t* p)
+{
+  return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) |
+      ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+      ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) |
+      ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static inline void StoreBigEndian64(uint8_t* p, uint64_t x)
+{
+  uint8_t i;
+  for (i = 0; i < 8; ++i)
   {
-    RoundKey[(i * 4) + 0] = Key[(i * 4) + 0];
-    RoundKey[(i * 4) + 1] = Key[(i * 4) + 1];
-    RoundKey[(i * 4) + 2] = Key[(i * 4) + 2];
-    RoundKey[(i * 4) + 3] = Key[(i * 4) + 3];
+    p[i] = (uint8_t)(x >> (56 - 8 * i));
   }
+}
 
-  // All other round keys are found from the previous round keys.
-  for (i = Nk; i < Nb * (Nr + 1); ++i)
+// buf ^= pad, a word at a time.
+static void XorBuffer(uint8_t* buf, const uint8_t* pad, uint32_t length)
+{
+  uint64_t x, y;
+  uint32_t i;
+  for (i = 0; i + 8 <= length; i += 8)
   {
-    {
-      k = (i - 1) * 4;
-      tempa[0]=RoundKey[k + 0];
-      tempa[1]=RoundKey[k + 1];
-      tempa[2]=RoundKey[k + 2];
-      tempa[3]=RoundKey[k + 3];
+    memcpy(&x, buf + i, 8);
+    memcpy(&y, pad + i, 8);
+    x ^= y;
+    memcpy(buf + i, &x, 8);
+  }
+  for (; i < length; ++i)
+  {
+    buf[i] ^= pad[i];
+  }
+}
 
-    }
 
-    if (i % Nk == 0)
-    {
-      // This function shifts the 4 bytes in a word to the left once.
-      // [a0,a1,a2,a3] becomes [a1,a2,a3,a0]
+// The bitsliced representation: the bytes of four blocks are interleaved and
+// then transposed, so that q[i] holds bit i of all 64 bytes. Bytes of one row
+// of the state are 16 bits apart in each word, and the four blocks take
+// neighbouring bits, so ShiftRows and MixColumns become shifts and rotations
+// and SubBytes becomes a boolean circuit on the eight words.
 
-      // Function RotWord()
-      {
-        k = tempa[0];
-        tempa[0] = tempa[1];
-        tempa[1] = tempa[2];
-        tempa[2] = tempa[3];
-        tempa[3] = k;
-      }
+// Transposes the 8x8 bit matrices spread over q[0..7]; its own inverse.
+static void Ortho(uint64_t* q)
+{
+#define SWAPN(cl, ch, s, x, y)   do { \
+    uint64_t a, b; \
+    a = (x); \
+    b = (y); \
+    (x) = (a & (uint64_t)cl) | ((b & (uint64_t)cl) << (s)); \
+    (y) = ((a & (uint64_t)ch) >> (s)) | (b & (uint64_t)ch); \
+  } while (0)
+
+#define SWAP2(x, y)    SWAPN(0x5555555555555555, 0xAAAAAAAAAAAAAAAA,  1, x, y)
+#define SWAP4(x, y)    SWAPN(0x3333333333333333, 0xCCCCCCCCCCCCCCCC,  2, x, y)
+#define SWAP8(x, y)    SWAPN(0x0F0F0F0F0F0F0F0F, 0xF0F0F0F0F0F0F0F0,  4, x, y)
+
+  SWAP2(q[0], q[1]);
+  SWAP2(q[2], q[3]);
+  SWAP2(q[4], q[5]);
+  SWAP2(q[6], q[7]);
+
+  SWAP4(q[0], q[2]);
+  SWAP4(q[1], q[3]);
+  SWAP4(q[4], q[6]);
+  SWAP4(q[5], q[7]);
+
+  SWAP8(q[0], q[4]);
+  SWAP8(q[1], q[5]);
+  SWAP8(q[2], q[6]);
+  SWAP8(q[3], q[7]);
+
+#undef SWAP8
+#undef SWAP4
+#undef SWAP2
+#undef SWAPN
+}
 
-      // SubWord() is a function that takes a four-byte input word and 
-      // applies the S-box to each of the four bytes to produce an output word.
+// Spreads the four words of a block over the 16-bit lanes of two words.
+static void InterleaveIn(uint64_t* q0, uint64_t* q1, const uint32_t* w)
+{
+  uint64_t x0, x1, x2, x3;
+
+  x0 = w[0];
+  x1 = w[1];
+  x2 = w[2];
+  x3 = w[3];
+  x0 |= (x0 << 16);
+  x1 |= (x1 << 16);
+  x2 |= (x2 << 16);
+  x3 |= (x3 << 16);
+  x0 &= (uint64_t)0x0000FFFF0000FFFF;
+  x1 &= (uint64_t)0x0000FFFF0000FFFF;
+  x2 &= (uint64_t)0x0000FFFF0000FFFF;
+  x3 &= (uint64_t)0x0000FFFF0000FFFF;
+  x0 |= (x0 << 8);
+  x1 |= (x1 << 8);
+  x2 |= (x2 << 8);
+  x3 |= (x3 << 8);
+  x0 &= (uint64_t)0x00FF00FF00FF00FF;
+  x1 &= (uint64_t)0x00FF00FF00FF00FF;
+  x2 &= (uint64_t)0x00FF00FF00FF00FF;
+  x3 &= (uint64_t)0x00FF00FF00FF00FF;
+  *q0 = x0 | (x2 << 8);
+  *q1 = x1 | (x3 << 8);
+}
 
-      // Function Subword()
-      {
-        tempa[0] = getSBoxValue(tempa[0]);
-        tempa[1] = getSBoxValue(tempa[1]);
-        tempa[2] = getSBoxValue(tempa[2]);
-        tempa[3] = getSBoxValue(tempa[3]);
-      }
+static void InterleaveOut(uint32_t* w, uint64_t q0, uint64_t q1)
+{
+  uint64_t x0, x1, x2, x3;
+
+  x0 = q0 & (uint64_t)0x00FF00FF00FF00FF;
+  x1 = q1 & (uint64_t)0x00FF00FF00FF00FF;
+  x2 = (q0 >> 8) & (uint64_t)0x00FF00FF00FF00FF;
+  x3 = (q1 >> 8) & (uint64_t)0x00FF00FF00FF00FF;
+  x0 |= (x0 >> 8);
+  x1 |= (x1 >> 8);
+  x2 |= (x2 >> 8);
+  x3 |= (x3 >> 8);
+  x0 &= (uint64_t)0x0000FFFF0000FFFF;
+  x1 &= (uint64_t)0x0000FFFF0000FFFF;
+  x2 &= (uint64_t)0x0000FFFF0000FFFF;
+  x3 &= (uint64_t)0x0000FFFF0000FFFF;
+  w[0] = (uint32_t)x0 | (uint32_t)(x0 >> 16);
+  w[1] = (uint32_t)x1 | (uint32_t)(x1 >> 16);
+  w[2] = (uint32_t)x2 | (uint32_t)(x2 >> 16);
+  w[3] = (uint32_t)x3 | (uint32_t)(x3 >> 16);
+}
 
-      tempa[0] = tempa[0] ^ Rcon[i/Nk];
+// The S-box as the 113-gate circuit of Boyar and Peralta: a linear layer, the
+// inversion in GF(2^8) and another linear layer, on all 64 bytes at once.
+static void BitsliceSubBytes(uint64_t* q)
+{
+  uint64_t x0, x1, x2, x3, x4, x5, x6, x7;
+  uint64_t y1, y2, y3, y4, y5, y6, y7, y8, y9;
+  uint64_t y10, y11, y12, y13, y14, y15, y16, y17, y18, y19;
+  uint64_t y20, y21;
+  uint64_t z0, z1, z2, z3, z4, z5, z6, z7, z8, z9;
+  uint64_t z10, z11, z12, z13, z14, z15, z16, z17;
+  uint64_t t0, t1, t2, t3, t4, t5, t6, t7, t8, t9;
+  uint64_t t10, t11, t12, t13, t14, t15, t16, t17, t18, t19;
+  uint64_t t20, t21, t22, t23, t24, t25, t26, t27, t28, t29;
+  uint64_t t30, t31, t32, t33, t34, t35, t36, t37, t38, t39;
+  uint64_t t40, t41, t42, t43, t44, t45, t46, t47, t48, t49;
+  uint64_t t50, t51, t52, t53, t54, t55, t56, t57, t58, t59;
+  uint64_t t60, t61, t62, t63, t64, t65, t66, t67;
+  uint64_t s0, s1, s2, s3, s4, s5, s6, s7;
+
+  x0 = q[7];
+  x1 = q[6];
+  x2 = q[5];
+  x3 = q[4];
+  x4 = q[3];
+  x5 = q[2];
+  x6 = q[1];
+  x7 = q[0];
+
+  // Top linear transformation.
+  y14 = x3 ^ x5;
+  y13 = x0 ^ x6;
+  y9 = x0 ^ x3;
+  y8 = x0 ^ x5;
+  t0 = x1 ^ x2;
+  y1 = t0 ^ x7;
+  y4 = y1 ^ x3;
+  y12 = y13 ^ y14;
+  y2 = y1 ^ x0;
+  y5 = y1 ^ x6;
+  y3 = y5 ^ y8;
+  t1 = x4 ^ y12;
+  y15 = t1 ^ x5;
+  y20 = t1 ^ x1;
+  y6 = y15 ^ x7;
+  y10 = y15 ^ t0;
+  y11 = y20 ^ y9;
+  y7 = x7 ^ y11;
+  y17 = y10 ^ y11;
+  y19 = y10 ^ y8;
+  y16 = t0 ^ y11;
+  y21 = y13 ^ y16;
+  y18 = x0 ^ y16;
+
+  // Non-linear section.
+  t2 = y12 & y15;
+  t3 = y3 & y6;
+  t4 = t3 ^ t2;
+  t5 = y4 & x7;
+  t6 = t5 ^ t2;
+  t7 = y13 & y16;
+  t8 = y5 & y1;
+  t9 = t8 ^ t7;
+  t10 = y2 & y7;
+  t11 = t10 ^ t7;
+  t12 = y9 & y11;
+  t13 = y14 & y17;
+  t14 = t13 ^ t12;
+  t15 = y8 & y10;
+  t16 = t15 ^ t12;
+  t17 = t4 ^ t14;
+  t18 = t6 ^ t16;
+  t19 = t9 ^ t14;
+  t20 = t11 ^ t16;
+  t21 = t17 ^ y20;
+  t22 = t18 ^ y19;
+  t23 = t19 ^ y21;
+  t24 = t20 ^ y18;
+
+  t25 = t21 ^ t22;
+  t26 = t21 & t23;
+  t27 = t24 ^ t26;
+  t28 = t25 & t27;
+  t29 = t28 ^ t22;
+  t30 = t23 ^ t24;
+  t31 = t22 ^ t26;
+  t32 = t31 & t30;
+  t33 = t32 ^ t24;
+  t34 = t23 ^ t33;
+  t35 = t27 ^ t33;
+  t36 = t24 & t35;
+  t37 = t36 ^ t34;
+  t38 = t27 ^ t36;
+  t39 = t29 & t38;
+  t40 = t25 ^ t39;
+
+  t41 = t40 ^ t37;
+  t42 = t29 ^ t33;
+  t43 = t29 ^ t40;
+  t44 = t33 ^ t37;
+  t45 = t42 ^ t41;
+  z0 = t44 & y15;
+  z1 = t37 & y6;
+  z2 = t33 & x7;
+  z3 = t43 & y16;
+  z4 = t40 & y1;
+  z5 = t29 & y7;
+  z6 = t42 & y11;
+  z7 = t45 & y17;
+  z8 = t41 & y10;
+  z9 = t44 & y12;
+  z10 = t37 & y3;
+  z11 = t33 & y4;
+  z12 = t43 & y13;
+  z13 = t40 & y5;
+  z14 = t29 & y2;
+  z15 = t42 & y9;
+  z16 = t45 & y14;
+  z17 = t41 & y8;
+
+  // Bottom linear transformation.
+  t46 = z15 ^ z16;
+  t47 = z10 ^ z11;
+  t48 = z5 ^ z13;
+  t49 = z9 ^ z10;
+  t50 = z2 ^ z12;
+  t51 = z2 ^ z5;
+  t52 = z7 ^ z8;
+  t53 = z0 ^ z3;
+  t54 = z6 ^ z7;
+  t55 = z16 ^ z17;
+  t56 = z12 ^ t48;
+  t57 = t50 ^ t53;
+  t58 = z4 ^ t46;
+  t59 = z3 ^ t54;
+  t60 = t46 ^ t57;
+  t61 = z14 ^ t57;
+  t62 = t52 ^ t58;
+  t63 = t49 ^ t58;
+  t64 = z4 ^ t59;
+  t65 = t61 ^ t62;
+  t66 = z1 ^ t63;
+  s0 = t59 ^ t63;
+  s6 = t56 ^ ~t62;
+  s7 = t48 ^ ~t60;
+  t67 = t64 ^ t65;
+  s3 = t53 ^ t66;
+  s4 = t51 ^ t66;
+  s5 = t47 ^ t65;
+  s1 = t64 ^ ~s3;
+  s2 = t55 ^ ~t67;
+
+  q[7] = s0;
+  q[6] = s1;
+  q[5] = s2;
+  q[4] = s3;
+  q[3] = s4;
+  q[2] = s5;
+  q[1] = s6;
+  q[0] = s7;
+}
+
+// SubWord() of the key schedule, through the same circuit as the rounds so
+// that key expansion does not index a table with key bytes either.
+static uint32_t SubWord(uint32_t x)
+{
+  uint64_t q[8];
+
+  memset(q, 0, sizeof(q));
+  q[0] = x;
+  Ortho(q);
+  BitsliceSubBytes(q);
+  Ortho(q);
+  return (uint32_t)q[0];
+}
+
+// This function produces Nb(Nr+1) round keys. The round keys are used in each round to decrypt the states.
+static void KeyExpansion(uint8_t* RoundKey, const uint8_t* Key)
+{
+  uint32_t w[Nb * (Nr + 1)];
+  uint32_t temp;
+  unsigned i;
+
+  // The first round key is the key itself.
+  for (i = 0; i < Nk; ++i)
+  {
+    w[i] = LoadWord(Key + i * 4);
+  }
+
+  // All other round keys are found from the previous round keys. Words are
+  // little-endian, so RotWord() is a right rotation by a byte.
+  for (i = Nk; i < Nb * (Nr + 1); ++i)
+  {
+    temp = w[i - 1];
+    if (i % Nk == 0)
+    {
+      temp = SubWord((temp >> 8) | (temp << 24)) ^ Rcon[i/Nk];
     }
 #if defined(AES256) && (AES256 == 1)
     if (i % Nk == 4)
     {
-      // Function Subword()
-      {
-        tempa[0] = getSBoxValue(tempa[0]);
-        tempa[1] = getSBoxValue(tempa[1]);
-        tempa[2] = getSBoxValue(tempa[2]);
-        tempa[3] = getSBoxValue(tempa[3]);
-      }
+      temp = SubWord(temp);
     }
 #endif
-    j = i * 4; k=(i - Nk) * 4;
-    RoundKey[j + 0] = RoundKey[k + 0] ^ tempa[0];
-    RoundKey[j + 1] = RoundKey[k + 1] ^ tempa[1];
-    RoundKey[j + 2] = RoundKey[k + 2] ^ tempa[2];
-    RoundKey[j + 3] = RoundKey[k + 3] ^ tempa[3];
+    w[i] = w[i - Nk] ^ temp;
   }
-}
 
-void AES_init_ctx(struct AES_ctx* ctx, const uint8_t* key)
-{
-  KeyExpansion(ctx->RoundKey, key);
+  for (i = 0; i < Nb * (Nr + 1); ++i)
+  {
+    StoreWord(RoundKey + i * 4, w[i]);
+  }
 }
-#if defined(CBC) && (CBC == 1)
-void AES_init_ctx_iv(struct AES_ctx* ctx, const uint8_t* key, const uint8_t* iv)
+
+// Converts the round keys to the bitsliced form. A round key is the same for
+// all four blocks, so every nibble of a sliced word is all zeros or all ones;
+// keeping one bit per nibble packs the eight words of a round key into two.
+static void SliceKey(uint64_t* SlicedKey, const uint8_t* RoundKey)
 {
-  KeyExpansion(ctx->RoundKey, key);
-  memcpy (ctx->Iv, iv, AES_BLOCKLEN);
+  uint64_t q[8];
+  uint32_t w[4];
+  unsigned i, j;
+
+  for (i = 0; i <= Nr; ++i)
+  {
+    for (j = 0; j < 4; ++j)
+    {
+      w[j] = LoadWord(RoundKey + (i * Nb + j) * 4);
+    }
+    InterleaveIn(&q[0], &q[4], w);
+    q[1] = q[0];
+    q[2] = q[0];
+    q[3] = q[0];
+    q[5] = q[4];
+    q[6] = q[4];
+    q[7] = q[4];
+    Ortho(q);
+    for (j = 0; j < 2; ++j)
+    {
+      SlicedKey[i * 2 + j] =
+          (q[j * 4 + 0] & (uint64_t)0x1111111111111111)
+        | (q[j * 4 + 1] & (uint64_t)0x2222222222222222)
+        | (q[j * 4 + 2] & (uint64_t)0x4444444444444444)
+        | (q[j * 4 + 3] & (uint64_t)0x8888888888888888);
+    }
+  }
 }
-void AES_ctx_set_iv(struct AES_ctx* ctx, const uint8_t* iv)
+
+#if !AES_RISCV_ZKNE || !AES_RISCV_ZKND
+// Unpacks the sliced round keys: eight words per round key.
+static void ExpandSlicedKey(uint64_t* skey, const uint64_t* SlicedKey)
 {
-  memcpy (ctx->Iv, iv, AES_BLOCKLEN);
+  uint64_t x0, x1, x2, x3;
+  unsigned i;
+
+  for (i = 0; i < 2 * (Nr + 1); ++i)
+  {
+    x0 = SlicedKey[i] & (uint64_t)0x1111111111111111;
+    x1 = (SlicedKey[i] & (uint64_t)0x2222222222222222) >> 1;
+    x2 = (SlicedKey[i] & (uint64_t)0x4444444444444444) >> 2;
+    x3 = (SlicedKey[i] & (uint64_t)0x8888888888888888) >> 3;
+    skey[i * 4 + 0] = (x0 << 4) - x0;
+    skey[i * 4 + 1] = (x1 << 4) - x1;
+    skey[i * 4 + 2] = (x2 << 4) - x2;
+    skey[i * 4 + 3] = (x3 << 4) - x3;
+  }
 }
-#endif
 
-// This function adds the round key to state.
-// The round key is added to the state by an XOR function.
-static void AddRoundKey(uint8_t round,state_t* state,uint8_t* RoundKey)
+// Loads up to AES_PARALLEL_BLOCKS blocks into the bitsliced state; missing
+// blocks are zero.
+static void BitsliceLoad(uint64_t* q, const uint8_t* buf, size_t blocks)
 {
-  uint8_t i,j;
-  for (i = 0; i < 4; ++i)
+  uint32_t w[Nb];
+  size_t i, j;
+
+  for (i = 0; i < blocks; ++i)
   {
-    for (j = 0; j < 4; ++j)
+    for (j = 0; j < Nb; ++j)
     {
-      (*state)[i][j] ^= RoundKey[(round * Nb * 4) + (i * Nb) + j];
+      w[j] = LoadWord(buf + (i * Nb + j) * 4);
     }
+    InterleaveIn(&q[i], &q[i + 4], w);
+  }
+  for (; i < AES_PARALLEL_BLOCKS; ++i)
+  {
+    q[i] = 0;
+    q[i + 4] = 0;
   }
+  Ortho(q);
 }
 
-// The SubBytes Function Substitutes the values in the
-// state matrix with values in an S-box.
-static void SubBytes(state_t* state)
+static void BitsliceStore(uint8_t* buf, uint64_t* q, size_t blocks)
 {
-  uint8_t i, j;
-  for (i = 0; i < 4; ++i)
+  uint32_t w[Nb];
+  size_t i, j;
+
+  Ortho(q);
+  for (i = 0; i < blocks; ++i)
   {
-    for (j = 0; j < 4; ++j)
+    InterleaveOut(w, q[i], q[i + 4]);
+    for (j = 0; j < Nb; ++j)
     {
-      (*state)[j][i] = getSBoxValue((*state)[j][i]);
+      StoreWord(buf + (i * Nb + j) * 4, w[j]);
     }
   }
 }
 
+// This function adds the round key to state.
+// The round key is added to the state by an XOR function.
+static void AddRoundKey(uint64_t* q, const uint64_t* skey)
+{
+  uint8_t i;
+  for (i = 0; i < 8; ++i)
+  {
+    q[i] ^= skey[i];
+  }
+}
+
+static inline uint64_t Rotr32(uint64_t x)
+{
+  return (x << 32) | (x >> 32);
+}
+
+#endif // !AES_RISCV_ZKNE || !AES_RISCV_ZKND
+#if !AES_RISCV_ZKNE
 // The ShiftRows() function shifts the rows in the state to the left.
 // Each row is shifted with different offset.
 // Offset = Row number. So the first row is not shifted.
-static void ShiftRows(state_t* state)
+static void ShiftRows(uint64_t* q)
 {
-  uint8_t temp;
-
-  // Rotate first row 1 columns to left  
-  temp           = (*state)[0][1];
-  (*state)[0][1] = (*state)[1][1];
-  (*state)[1][1] = (*state)[2][1];
-  (*state)[2][1] = (*state)[3][1];
-  (*state)[3][1] = temp;
-
-  // Rotate second row 2 columns to left  
-  temp           = (*state)[0][2];
-  (*state)[0][2] = (*state)[2][2];
-  (*state)[2][2] = temp;
-
-  temp           = (*state)[1][2];
-  (*state)[1][2] = (*state)[3][2];
-  (*state)[3][2] = temp;
+  uint64_t x;
+  uint8_t i;
+  for (i = 0; i < 8; ++i)
+  {
+    x = q[i];
+    q[i] = (x & (uint64_t)0x000000000000FFFF)
+      | ((x & (uint64_t)0x00000000FFF00000) >> 4)
+      | ((x & (uint64_t)0x00000000000F0000) << 12)
+      | ((x & (uint64_t)0x0000FF0000000000) >> 8)
+      | ((x & (uint64_t)0x000000FF00000000) << 8)
+      | ((x & (uint64_t)0xF000000000000000) >> 12)
+      | ((x & (uint64_t)0x0FFF000000000000) << 4);
+  }
+}
 
-  // Rotate third row 3 columns to left
-  temp           = (*state)[0][3];
-  (*state)[0][3] = (*state)[3][3];
-  (*state)[3][3] = (*state)[2][3];
-  (*state)[2][3] = (*state)[1][3];
-  (*state)[1][3] = temp;
+// MixColumns function mixes the columns of the state matrix. Multiplying by
+// x is a shift from q[i] to q[i + 1], reduced into q[0], q[1], q[3] and q[4].
+static void MixColumns(uint64_t* q)
+{
+  uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+  uint64_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+  q0 = q[0];
+  q1 = q[1];
+  q2 = q[2];
+  q3 = q[3];
+  q4 = q[4];
+  q5 = q[5];
+  q6 = q[6];
+  q7 = q[7];
+  r0 = (q0 >> 16) | (q0 << 48);
+  r1 = (q1 >> 16) | (q1 << 48);
+  r2 = (q2 >> 16) | (q2 << 48);
+  r3 = (q3 >> 16) | (q3 << 48);
+  r4 = (q4 >> 16) | (q4 << 48);
+  r5 = (q5 >> 16) | (q5 << 48);
+  r6 = (q6 >> 16) | (q6 << 48);
+  r7 = (q7 >> 16) | (q7 << 48);
+
+  q[0] = q7 ^ r7 ^ r0 ^ Rotr32(q0 ^ r0);
+  q[1] = q0 ^ r0 ^ q7 ^ r7 ^ r1 ^ Rotr32(q1 ^ r1);
+  q[2] = q1 ^ r1 ^ r2 ^ Rotr32(q2 ^ r2);
+  q[3] = q2 ^ r2 ^ q7 ^ r7 ^ r3 ^ Rotr32(q3 ^ r3);
+  q[4] = q3 ^ r3 ^ q7 ^ r7 ^ r4 ^ Rotr32(q4 ^ r4);
+  q[5] = q4 ^ r4 ^ r5 ^ Rotr32(q5 ^ r5);
+  q[6] = q5 ^ r5 ^ r6 ^ Rotr32(q6 ^ r6);
+  q[7] = q6 ^ r6 ^ r7 ^ Rotr32(q7 ^ r7);
 }
 
-static uint8_t xtime(uint8_t x)
+#endif // !AES_RISCV_ZKNE
+#if !AES_RISCV_ZKND
+// The inverse S-box is the forward one between two copies of the inverse of
+// its affine map.
+static void InvSubBytes(uint64_t* q)
 {
-  return ((x<<1) ^ (((x>>7) & 1) * 0x1b));
+  uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+
+  q0 = ~q[0];
+  q1 = ~q[1];
+  q2 = q[2];
+  q3 = q[3];
+  q4 = q[4];
+  q5 = ~q[5];
+  q6 = ~q[6];
+  q7 = q[7];
+  q[7] = q1 ^ q4 ^ q6;
+  q[6] = q0 ^ q3 ^ q5;
+  q[5] = q7 ^ q2 ^ q4;
+  q[4] = q6 ^ q1 ^ q3;
+  q[3] = q5 ^ q0 ^ q2;
+  q[2] = q4 ^ q7 ^ q1;
+  q[1] = q3 ^ q6 ^ q0;
+  q[0] = q2 ^ q5 ^ q7;
+
+  BitsliceSubBytes(q);
+
+  q0 = ~q[0];
+  q1 = ~q[1];
+  q2 = q[2];
+  q3 = q[3];
+  q4 = q[4];
+  q5 = ~q[5];
+  q6 = ~q[6];
+  q7 = q[7];
+  q[7] = q1 ^ q4 ^ q6;
+  q[6] = q0 ^ q3 ^ q5;
+  q[5] = q7 ^ q2 ^ q4;
+  q[4] = q6 ^ q1 ^ q3;
+  q[3] = q5 ^ q0 ^ q2;
+  q[2] = q4 ^ q7 ^ q1;
+  q[1] = q3 ^ q6 ^ q0;
+  q[0] = q2 ^ q5 ^ q7;
 }
 
-// MixColumns function mixes the columns of the state matrix
-static void MixColumns(state_t* state)
+static void InvShiftRows(uint64_t* q)
 {
+  uint64_t x;
   uint8_t i;
-  uint8_t Tmp, Tm, t;
-  for (i = 0; i < 4; ++i)
-  {  
-    t   = (*state)[i][0];
-    Tmp = (*state)[i][0] ^ (*state)[i][1] ^ (*state)[i][2] ^ (*state)[i][3] ;
-    Tm  = (*state)[i][0] ^ (*state)[i][1] ; Tm = xtime(Tm);  (*state)[i][0] ^= Tm ^ Tmp ;
-    Tm  = (*state)[i][1] ^ (*state)[i][2] ; Tm = xtime(Tm);  (*state)[i][1] ^= Tm ^ Tmp ;
-    Tm  = (*state)[i][2] ^ (*state)[i][3] ; Tm = xtime(Tm);  (*state)[i][2] ^= Tm ^ Tmp ;
-    Tm  = (*state)[i][3] ^ t ;              Tm = xtime(Tm);  (*state)[i][3] ^= Tm ^ Tmp ;
+  for (i = 0; i < 8; ++i)
+  {
+    x = q[i];
+    q[i] = (x & (uint64_t)0x000000000000FFFF)
+      | ((x & (uint64_t)0x000000000FFF0000) << 4)
+      | ((x & (uint64_t)0x00000000F0000000) >> 12)
+      | ((x & (uint64_t)0x000000FF00000000) << 8)
+      | ((x & (uint64_t)0x0000FF0000000000) >> 8)
+      | ((x & (uint64_t)0x000F000000000000) << 12)
+      | ((x & (uint64_t)0xFFF0000000000000) >> 4);
   }
 }
 
-// Multiply is used to multiply numbers in the field GF(2^8)
-#if MULTIPLY_AS_A_FUNCTION
-static uint8_t Multiply(uint8_t x, uint8_t y)
+// InvMixColumns multiplies each column by {0e, 0b, 0d, 09}; the same shifts as
+// MixColumns, just more of them.
+static void InvMixColumns(uint64_t* q)
 {
-  return (((y & 1) * x) ^
-       ((y>>1 & 1) * xtime(x)) ^
-       ((y>>2 & 1) * xtime(xtime(x))) ^
-       ((y>>3 & 1) * xtime(xtime(xtime(x)))) ^
-       ((y>>4 & 1) * xtime(xtime(xtime(xtime(x))))));
-  }
-#else
-#define Multiply(x, y)                                \
-      (  ((y & 1) * x) ^                              \
-      ((y>>1 & 1) * xtime(x)) ^                       \
-      ((y>>2 & 1) * xtime(xtime(x))) ^                \
-      ((y>>3 & 1) * xtime(xtime(xtime(x)))) ^         \
-      ((y>>4 & 1) * xtime(xtime(xtime(xtime(x))))))   \
+  uint64_t q0, q1, q2, q3, q4, q5, q6, q7;
+  uint64_t r0, r1, r2, r3, r4, r5, r6, r7;
+
+  q0 = q[0];
+  q1 = q[1];
+  q2 = q[2];
+  q3 = q[3];
+  q4 = q[4];
+  q5 = q[5];
+  q6 = q[6];
+  q7 = q[7];
+  r0 = (q0 >> 16) | (q0 << 48);
+  r1 = (q1 >> 16) | (q1 << 48);
+  r2 = (q2 >> 16) | (q2 << 48);
+  r3 = (q3 >> 16) | (q3 << 48);
+  r4 = (q4 >> 16) | (q4 << 48);
+  r5 = (q5 >> 16) | (q5 << 48);
+  r6 = (q6 >> 16) | (q6 << 48);
+  r7 = (q7 >> 16) | (q7 << 48);
+
+  q[0] = q5 ^ q6 ^ q7 ^ r0 ^ r5 ^ r7 ^ Rotr32(q0 ^ q5 ^ q6 ^ r0 ^ r5);
+  q[1] = q0 ^ q5 ^ r0 ^ r1 ^ r5 ^ r6 ^ r7 ^ Rotr32(q1 ^ q5 ^ q7 ^ r1 ^ r5 ^ r6);
+  q[2] = q0 ^ q1 ^ q6 ^ r1 ^ r2 ^ r6 ^ r7 ^ Rotr32(q0 ^ q2 ^ q6 ^ r2 ^ r6 ^ r7);
+  q[3] = q0 ^ q1 ^ q2 ^ q5 ^ q6 ^ r0 ^ r2 ^ r3 ^ r5 ^ Rotr32(q0 ^ q1 ^ q3 ^ q5 ^ q6 ^ q7 ^ r0 ^ r3 ^ r5 ^ r7);
+  q[4] = q1 ^ q2 ^ q3 ^ q5 ^ r1 ^ r3 ^ r4 ^ r5 ^ r6 ^ r7 ^ Rotr32(q1 ^ q2 ^ q4 ^ q5 ^ q7 ^ r1 ^ r4 ^ r5 ^ r6);
+  q[5] = q2 ^ q3 ^ q4 ^ q6 ^ r2 ^ r4 ^ r5 ^ r6 ^ r7 ^ Rotr32(q2 ^ q3 ^ q5 ^ q6 ^ r2 ^ r5 ^ r6 ^ r7);
+  q[6] = q3 ^ q4 ^ q5 ^ q7 ^ r3 ^ r5 ^ r6 ^ r7 ^ Rotr32(q3 ^ q4 ^ q6 ^ q7 ^ r3 ^ r6 ^ r7);
+  q[7] = q4 ^ q5 ^ q6 ^ r4 ^ r6 ^ r7 ^ Rotr32(q4 ^ q5 ^ q7 ^ r4 ^ r7);
+}
+#endif // !AES_RISCV_ZKND
+
+
+#if AES_RISCV_ZKNE || AES_RISCV_ZKND
+// Each instruction takes the state as {rs2:rs1} and returns one 64-bit half of
+// the result; swapping the operands gives the other half.
+#define AES64_OP2(name) \
+static inline uint64_t name(uint64_t rs1, uint64_t rs2) \
+{ \
+  uint64_t rd; \
+  __asm__ (#name " %0, %1, %2" : "=r"(rd) : "r"(rs1), "r"(rs2)); \
+  return rd; \
+}
 
-#endif
+// Loads/stores a state or a round key as two little-endian halves.
+static inline void LoadHalves(uint64_t* lo, uint64_t* hi, const uint8_t* p)
+{
+  memcpy(lo, p, 8);
+  memcpy(hi, p + 8, 8);
+}
 
-// MixColumns function mixes the columns of the state matrix.
-// The method used to multiply may be difficult to understand for the inexperienced.
-// Please use the references to gain more information.
-static void InvMixColumns(state_t* state)
-{
-  int i;
-  uint8_t a, b, c, d;
-  for (i = 0; i < 4; ++i)
-  { 
-    a = (*state)[i][0];
-    b = (*state)[i][1];
-    c = (*state)[i][2];
-    d = (*state)[i][3];
-
-    (*state)[i][0] = Multiply(a, 0x0e) ^ Multiply(b, 0x0b) ^ Multiply(c, 0x0d) ^ Multiply(d, 0x09);
-    (*state)[i][1] = Multiply(a, 0x09) ^ Multiply(b, 0x0e) ^ Multiply(c, 0x0b) ^ Multiply(d, 0x0d);
-    (*state)[i][2] = Multiply(a, 0x0d) ^ Multiply(b, 0x09) ^ Multiply(c, 0x0e) ^ Multiply(d, 0x0b);
-    (*state)[i][3] = Multiply(a, 0x0b) ^ Multiply(b, 0x0d) ^ Multiply(c, 0x09) ^ Multiply(d, 0x0e);
-  }
+static inline void StoreHalves(uint8_t* p, uint64_t lo, uint64_t hi)
+{
+  memcpy(p, &lo, 8);
+  memcpy(p + 8, &hi, 8);
 }
+#endif
 
+// CipherBlocks and InvCipherBlocks work in place on 1 to AES_PARALLEL_BLOCKS
+// consecutive blocks.
+#if AES_RISCV_ZKNE
+AES64_OP2(aes64es)
+AES64_OP2(aes64esm)
 
-// The SubBytes Function Substitutes the values in the
-// state matrix with values in an S-box.
-static void InvSubBytes(state_t* state)
+// The blocks go through each round together, so the instructions of one block
+// overlap with those of the next.
+static void CipherBlocks(uint8_t* buf, size_t blocks, const struct AES_ctx* ctx)
 {
-  uint8_t i, j;
-  for (i = 0; i < 4; ++i)
+  uint64_t s[AES_PARALLEL_BLOCKS][2];
+  uint64_t k0, k1, n0;
+  uint8_t round;
+  size_t b;
+
+  LoadHalves(&k0, &k1, ctx->RoundKey);
+  for (b = 0; b < blocks; ++b)
   {
-    for (j = 0; j < 4; ++j)
+    LoadHalves(&s[b][0], &s[b][1], buf + b * AES_BLOCKLEN);
+    s[b][0] ^= k0;
+    s[b][1] ^= k1;
+  }
+
+  // SubBytes, ShiftRows and MixColumns in one instruction per half.
+  for (round = 1; round < Nr; ++round)
+  {
+    LoadHalves(&k0, &k1, ctx->RoundKey + round * Nb * 4);
+    for (b = 0; b < blocks; ++b)
     {
-      (*state)[j][i] = getSBoxInvert((*state)[j][i]);
+      n0 = aes64esm(s[b][0], s[b][1]) ^ k0;
+      s[b][1] = aes64esm(s[b][1], s[b][0]) ^ k1;
+      s[b][0] = n0;
     }
   }
-}
 
-static void InvShiftRows(state_t* state)
-{
-  uint8_t temp;
-
-  // Rotate first row 1 columns to right  
-  temp = (*state)[3][1];
-  (*state)[3][1] = (*state)[2][1];
-  (*state)[2][1] = (*state)[1][1];
-  (*state)[1][1] = (*state)[0][1];
-  (*state)[0][1] = temp;
-
-  // Rotate second row 2 columns to right 
-  temp = (*state)[0][2];
-  (*state)[0][2] = (*state)[2][2];
-  (*state)[2][2] = temp;
-
-  temp = (*state)[1][2];
-  (*state)[1][2] = (*state)[3][2];
-  (*state)[3][2] = temp;
-
-  // Rotate third row 3 columns to right
-  temp = (*state)[0][3];
-  (*state)[0][3] = (*state)[1][3];
-  (*state)[1][3] = (*state)[2][3];
-  (*state)[2][3] = (*state)[3][3];
-  (*state)[3][3] = temp;
+  LoadHalves(&k0, &k1, ctx->RoundKey + Nr * Nb * 4);
+  for (b = 0; b < blocks; ++b)
+  {
+    n0 = aes64es(s[b][0], s[b][1]) ^ k0;
+    s[b][1] = aes64es(s[b][1], s[b][0]) ^ k1;
+    StoreHalves(buf + b * AES_BLOCKLEN, n0, s[b][1]);
+  }
 }
-
-
-// Cipher is the main function that encrypts the PlainText.
-static void Cipher(state_t* state, uint8_t* RoundKey)
+#else
+// The rounds of the cipher, on a bitsliced state and expanded round keys.
+static void CipherSliced(uint64_t* q, const uint64_t* skey)
 {
   uint8_t round = 0;
 
   // Add the First round key to the state before starting the rounds.
-  AddRoundKey(0, state, RoundKey); 
-  
+  AddRoundKey(q, skey);
+
   // There will be Nr rounds.
   // The first Nr-1 rounds are identical.
   // These Nr-1 rounds are executed in the loop below.
   for (round = 1; round < Nr; ++round)
   {
-    SubBytes(state);
-    ShiftRows(state);
-    MixColumns(state);
-    AddRoundKey(round, state, RoundKey);
+    BitsliceSubBytes(q);
+    ShiftRows(q);
+    MixColumns(q);
+    AddRoundKey(q, skey + round * 8);
   }
-  
+
   // The last round is given below.
   // The MixColumns function is not here in the last round.
-  SubBytes(state);
-  ShiftRows(state);
-  AddRoundKey(Nr, state, RoundKey);
+  BitsliceSubBytes(q);
+  ShiftRows(q);
+  AddRoundKey(q, skey + Nr * 8);
+}
+
+// Cipher is the main function that encrypts the PlainText.
+static void CipherBlocks(uint8_t* buf, size_t blocks, const struct AES_ctx* ctx)
+{
+  uint64_t skey[8 * (Nr + 1)];
+  uint64_t q[8];
+
+  ExpandSlicedKey(skey, ctx->SlicedKey);
+  BitsliceLoad(q, buf, blocks);
+  CipherSliced(q, skey);
+  BitsliceStore(buf, q, blocks);
 }
+#endif // AES_RISCV_ZKNE
+
+#if AES_RISCV_ZKND
+AES64_OP2(aes64ds)
+AES64_OP2(aes64dsm)
+
+static inline uint64_t aes64im(uint64_t rs1)
+{
+  uint64_t rd;
+  __asm__ ("aes64im %0, %1" : "=r"(rd) : "r"(rs1));
+  return rd;
+}
+
+// The rounds use the equivalent inverse cipher: aes64dsm applies
+// InvMixColumns after the round key would have been added, so the round keys
+// are passed through InvMixColumns (aes64im) instead, once for all blocks.
+static void InvCipherBlocks(uint8_t* buf, size_t blocks, const struct AES_ctx* ctx)
+{
+  uint64_t s[AES_PARALLEL_BLOCKS][2];
+  uint64_t k0, k1, n0;
+  uint8_t round;
+  size_t b;
+
+  LoadHalves(&k0, &k1, ctx->RoundKey + Nr * Nb * 4);
+  for (b = 0; b < blocks; ++b)
+  {
+    LoadHalves(&s[b][0], &s[b][1], buf + b * AES_BLOCKLEN);
+    s[b][0] ^= k0;
+    s[b][1] ^= k1;
+  }
+
+  for (round = (Nr - 1); round > 0; --round)
+  {
+    LoadHalves(&k0, &k1, ctx->RoundKey + round * Nb * 4);
+    k0 = aes64im(k0);
+    k1 = aes64im(k1);
+    for (b = 0; b < blocks; ++b)
+    {
+      n0 = aes64dsm(s[b][0], s[b][1]) ^ k0;
+      s[b][1] = aes64dsm(s[b][1], s[b][0]) ^ k1;
+      s[b][0] = n0;
+    }
+  }
 
-static void InvCipher(state_t* state,uint8_t* RoundKey)
+  LoadHalves(&k0, &k1, ctx->RoundKey);
+  for (b = 0; b < blocks; ++b)
+  {
+    n0 = aes64ds(s[b][0], s[b][1]) ^ k0;
+    s[b][1] = aes64ds(s[b][1], s[b][0]) ^ k1;
+    StoreHalves(buf + b * AES_BLOCKLEN, n0, s[b][1]);
+  }
+}
+#else
+static void InvCipherBlocks(uint8_t* buf, size_t blocks, const struct AES_ctx* ctx)
 {
+  uint64_t skey[8 * (Nr + 1)];
+  uint64_t q[8];
   uint8_t round = 0;
 
+  ExpandSlicedKey(skey, ctx->SlicedKey);
+  BitsliceLoad(q, buf, blocks);
+
   // Add the First round key to the state before starting the rounds.
-  AddRoundKey(Nr, state, RoundKey); 
+  AddRoundKey(q, skey + Nr * 8);
 
   // There will be Nr rounds.
   // The first Nr-1 rounds are identical.
   // These Nr-1 rounds are executed in the loop below.
   for (round = (Nr - 1); round > 0; --round)
   {
-    InvShiftRows(state);
-    InvSubBytes(state);
-    AddRoundKey(round, state, RoundKey);
-    InvMixColumns(state);
+    InvShiftRows(q);
+    InvSubBytes(q);
+    AddRoundKey(q, skey + round * 8);
+    InvMixColumns(q);
   }
-  
+
   // The last round is given below.
   // The MixColumns function is not here in the last round.
-  InvShiftRows(state);
-  InvSubBytes(state);
-  AddRoundKey(0, state, RoundKey);
+  InvShiftRows(q);
+  InvSubBytes(q);
+  AddRoundKey(q, skey);
+
+  BitsliceStore(buf, q, blocks);
 }
+#endif // AES_RISCV_ZKND
+
+
+void AES_init_ctx(struct AES_ctx* ctx, const uint8_t* key)
+{
+  KeyExpansion(ctx->RoundKey, key);
+  SliceKey(ctx->SlicedKey, ctx->RoundKey);
+}
+#if defined(CBC) && (CBC == 1)
+void AES_init_ctx_iv(struct AES_ctx* ctx, const uint8_t* key, const uint8_t* iv)
+{
+  AES_init_ctx(ctx, key);
+  memcpy (ctx->Iv, iv, AES_BLOCKLEN);
+}
+void AES_ctx_set_iv(struct AES_ctx* ctx, const uint8_t* iv)
+{
+  memcpy (ctx->Iv, iv, AES_BLOCKLEN);
+}
+#endif
 
 
 /*****************************************************************************/
@@ -464,13 +977,24 @@ static void InvCipher(state_t* state,uint8_t* RoundKey)
 void AES_ECB_encrypt(struct AES_ctx *ctx,const uint8_t* buf)
 {
   // The next function call encrypts the PlainText with the Key using AES algorithm.
-  Cipher((state_t*)buf, ctx->RoundKey);
+  CipherBlocks((uint8_t*)buf, 1, ctx);
 }
 
 void AES_ECB_decrypt(struct AES_ctx* ctx,const uint8_t* buf)
 {
   // The next function call decrypts the PlainText with the Key using AES algorithm.
-  InvCipher((state_t*)buf, ctx->RoundKey);
+  InvCipherBlocks((uint8_t*)buf, 1, ctx);
+}
+
+void AES_ECB_encrypt_blocks(struct AES_ctx* ctx, uint8_t* buf, uint32_t length)
+{
+  uint32_t blocks = length / AES_BLOCKLEN;
+  uint32_t n;
+  for (; blocks > 0; blocks -= n, buf += n * AES_BLOCKLEN)
+  {
+    n = (blocks < AES_PARALLEL_BLOCKS) ? blocks : AES_PARALLEL_BLOCKS;
+    CipherBlocks(buf, n, ctx);
+  }
 }
 
 
@@ -483,26 +1007,31 @@ void AES_ECB_decrypt(struct AES_ctx* ctx,const uint8_t* buf)
 #if defined(CBC) && (CBC == 1)
 
 
-static void XorWithIv(uint8_t* buf, uint8_t* Iv)
-{
-  uint8_t i;
-  for (i = 0; i < AES_BLOCKLEN; ++i) // The block in AES is always 128bit no matter the key size
-  {
-    buf[i] ^= Iv[i];
-  }
-}
-
+// Each block depends on the previous ciphertext, so encryption goes one block
+// at a time; decryption has all its inputs up front and runs on whole passes.
 void AES_CBC_encrypt_buffer(struct AES_ctx *ctx,uint8_t* buf, uint32_t length)
 {
   uintptr_t i;
   uint8_t *Iv = ctx->Iv;
+#if !AES_RISCV_ZKNE
+  // The bitsliced core does a single block for the price of four, so the
+  // round keys are at least expanded once per buffer rather than per block.
+  uint64_t skey[8 * (Nr + 1)];
+  uint64_t q[8];
+  ExpandSlicedKey(skey, ctx->SlicedKey);
+#endif
   for (i = 0; i < length; i += AES_BLOCKLEN)
   {
-    XorWithIv(buf, Iv);
-    Cipher((state_t*)buf, ctx->RoundKey);
+    XorBuffer(buf, Iv, AES_BLOCKLEN);
+#if AES_RISCV_ZKNE
+    CipherBlocks(buf, 1, ctx);
+#else
+    BitsliceLoad(q, buf, 1);
+    CipherSliced(q, skey);
+    BitsliceStore(buf, q, 1);
+#endif
     Iv = buf;
     buf += AES_BLOCKLEN;
-    //printf("Step %d - %d", i/16, i);
   }
   /* store Iv in ctx for next call */
   memcpy(ctx->Iv, Iv, AES_BLOCKLEN);
@@ -510,17 +1039,18 @@ void AES_CBC_encrypt_buffer(struct AES_ctx *ctx,uint8_t* buf, uint32_t length)
 
 void AES_CBC_decrypt_buffer(struct AES_ctx* ctx, uint8_t* buf,  uint32_t length)
 {
-  uintptr_t i;
-  uint8_t storeNextIv[AES_BLOCKLEN];
-  for (i = 0; i < length; i += AES_BLOCKLEN)
+  uint8_t storeNextIv[AES_PARALLEL_BLOCKS * AES_BLOCKLEN];
+  uint32_t blocks = length / AES_BLOCKLEN;
+  uint32_t n;
+  for (; blocks > 0; blocks -= n, buf += n * AES_BLOCKLEN)
   {
-    memcpy(storeNextIv, buf, AES_BLOCKLEN);
-    InvCipher((state_t*)buf, ctx->RoundKey);
-    XorWithIv(buf, ctx->Iv);
-    memcpy(ctx->Iv, storeNextIv, AES_BLOCKLEN);
-    buf += AES_BLOCKLEN;
+    n = (blocks < AES_PARALLEL_BLOCKS) ? blocks : AES_PARALLEL_BLOCKS;
+    memcpy(storeNextIv, buf, n * AES_BLOCKLEN);
+    InvCipherBlocks(buf, n, ctx);
+    XorBuffer(buf, ctx->Iv, AES_BLOCKLEN);
+    XorBuffer(buf + AES_BLOCKLEN, storeNextIv, (n - 1) * AES_BLOCKLEN);
+    memcpy(ctx->Iv, storeNextIv + (n - 1) * AES_BLOCKLEN, AES_BLOCKLEN);
   }
-
 }
 
 #endif // #if defined(CBC) && (CBC == 1)
@@ -530,38 +1060,301 @@ void AES_CBC_decrypt_buffer(struct AES_ctx* ctx, uint8_t* buf,  uint32_t length)
 #if defined(CTR) && (CTR == 1)
 
 /* Symmetrical operation: same function for encrypting as for decrypting. Note any IV/nonce should never be reused with the same key */
+/* The counter is the whole 128-bit IV, big-endian. A trailing partial block
+   uses up a counter value, and the rest of its keystream is dropped. */
 void AES_CTR_xcrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, uint32_t length)
 {
-  uint8_t buffer[AES_BLOCKLEN];
-  
-  unsigned i;
-  int bi;
-  for (i = 0, bi = AES_BLOCKLEN; i < length; ++i, ++bi)
+  uint8_t buffer[AES_PARALLEL_BLOCKS * AES_BLOCKLEN];
+  uint64_t hi = LoadBigEndian64(ctx->Iv);
+  uint64_t lo = LoadBigEndian64(ctx->Iv + 8);
+  uint32_t n;
+  uint32_t b;
+
+  for (; length > 0; length -= n, buf += n)
   {
-    if (bi == AES_BLOCKLEN) /* we need to regen xor compliment in buffer */
+    for (b = 0; b < AES_PARALLEL_BLOCKS && b * AES_BLOCKLEN < length; ++b)
     {
-      
-      memcpy(buffer, ctx->Iv, AES_BLOCKLEN);
-      Cipher((state_t*)buffer,ctx->RoundKey);
-
+      StoreBigEndian64(buffer + b * AES_BLOCKLEN, hi);
+      StoreBigEndian64(buffer + b * AES_BLOCKLEN + 8, lo);
       /* Increment Iv and handle overflow */
-      for (bi = (AES_BLOCKLEN - 1); bi >= 0; --bi)
+      hi += (++lo == 0);
+    }
+
+    CipherBlocks(buffer, b, ctx);
+
+    n = (length < b * AES_BLOCKLEN) ? length : b * AES_BLOCKLEN;
+    XorBuffer(buf, buffer, n);
+  }
+
+  StoreBigEndian64(ctx->Iv, hi);
+  StoreBigEndian64(ctx->Iv + 8, lo);
+}
+
+#endif // #if defined(CTR) && (CTR == 1)
+
+
+
+#if defined(GCM) && (GCM == 1)
+
+// GHASH values are kept as two words, {hi, lo}, read big-endian from the
+// block. GCM numbers the bits of a block from the most significant end, so
+// these words hold the field elements bit-reversed. The product of two of
+// them as 128-bit polynomials, shifted left by one bit, is the bit-reversed
+// field product before reduction.
+
+// Bit-reverses a word.
+static inline uint64_t Rev64(uint64_t x)
+{
+  x = ((x & 0x5555555555555555) << 1) | ((x >> 1) & 0x5555555555555555);
+  x = ((x & 0x3333333333333333) << 2) | ((x >> 2) & 0x3333333333333333);
+  x = ((x & 0x0F0F0F0F0F0F0F0F) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0F);
+  x = ((x & 0x00FF00FF00FF00FF) << 8) | ((x >> 8) & 0x00FF00FF00FF00FF);
+  x = ((x & 0x0000FFFF0000FFFF) << 16) | ((x >> 16) & 0x0000FFFF0000FFFF);
+  return (x << 32) | (x >> 32);
+}
+
+#if AES_RISCV_CLMUL
+#define CLMUL_OP2(name) \
+static inline uint64_t name(uint64_t rs1, uint64_t rs2) \
+{ \
+  uint64_t rd; \
+  __asm__ (#name " %0, %1, %2" : "=r"(rd) : "r"(rs1), "r"(rs2)); \
+  return rd; \
+}
+CLMUL_OP2(clmul)
+CLMUL_OP2(clmulh)
+#else
+// The low word of the carry-less product x * y, from integer multiplies of
+// the operands with all but every fourth bit masked off. Each column of such
+// a product adds up at most 15 bits below bit 60, so the carries stay within
+// the holes, and are masked away.
+static inline uint64_t Bmul64(uint64_t x, uint64_t y)
+{
+  uint64_t x0 = x & 0x1111111111111111;
+  uint64_t x1 = x & 0x2222222222222222;
+  uint64_t x2 = x & 0x4444444444444444;
+  uint64_t x3 = x & 0x8888888888888888;
+  uint64_t y0 = y & 0x1111111111111111;
+  uint64_t y1 = y & 0x2222222222222222;
+  uint64_t y2 = y & 0x4444444444444444;
+  uint64_t y3 = y & 0x8888888888888888;
+  uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+  uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+  uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+  uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+  return (z0 & 0x1111111111111111) | (z1 & 0x2222222222222222) |
+      (z2 & 0x4444444444444444) | (z3 & 0x8888888888888888);
+}
+#endif // AES_RISCV_CLMUL
+
+// Expands a power of H into the operands of GhashMulAdd: the low word, the
+// high word and their sum, then the bit-reversals of the three.
+static void GhashPrepareKey(uint64_t* hp, uint64_t hi, uint64_t lo)
+{
+  hp[0] = lo;
+  hp[1] = hi;
+  hp[2] = lo ^ hi;
+  hp[3] = Rev64(hp[0]);
+  hp[4] = Rev64(hp[1]);
+  hp[5] = Rev64(hp[2]);
+}
+
+// z ^= {hi, lo} * H^k, unreduced, for the power prepared in hp. Karatsuba
+// takes three word products; without clmulh, the high word of a product is
+// the bit-reversed low word of the product of the bit-reversed operands.
+static void GhashMulAdd(uint64_t* z, uint64_t hi, uint64_t lo, const uint64_t* hp)
+{
+  uint64_t mid = lo ^ hi;
+#if AES_RISCV_CLMUL
+  uint64_t z0 = clmul(lo, hp[0]);
+  uint64_t z1 = clmul(hi, hp[1]);
+  uint64_t z2 = clmul(mid, hp[2]);
+  uint64_t z0h = clmulh(lo, hp[0]);
+  uint64_t z1h = clmulh(hi, hp[1]);
+  uint64_t z2h = clmulh(mid, hp[2]);
+#else
+  uint64_t z0 = Bmul64(lo, hp[0]);
+  uint64_t z1 = Bmul64(hi, hp[1]);
+  uint64_t z2 = Bmul64(mid, hp[2]);
+  uint64_t z0h = Rev64(Bmul64(Rev64(lo), hp[3])) >> 1;
+  uint64_t z1h = Rev64(Bmul64(Rev64(hi), hp[4])) >> 1;
+  uint64_t z2h = Rev64(Bmul64(Rev64(mid), hp[5])) >> 1;
+#endif
+  z2 ^= z0 ^ z1;
+  z2h ^= z0h ^ z1h;
+  z[0] ^= z0;
+  z[1] ^= z0h ^ z2;
+  z[2] ^= z1 ^ z2h;
+  z[3] ^= z1h;
+}
+
+// y = the sum of products in z, shifted into place and reduced modulo
+// x^128 + x^7 + x^2 + x + 1.
+static void GhashReduce(uint64_t* y, const uint64_t* z)
+{
+  uint64_t v0 = z[0] << 1;
+  uint64_t v1 = (z[1] << 1) | (z[0] >> 63);
+  uint64_t v2 = (z[2] << 1) | (z[1] >> 63);
+  uint64_t v3 = (z[3] << 1) | (z[2] >> 63);
+
+  v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+  v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+  v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+  v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+
+  y[0] = v3;
+  y[1] = v2;
+}
+
+// Folds length bytes into the hash y, zero-padded to a whole block. Runs of
+// AES_GCM_HPOWERS blocks take one reduction:
+//   y = (y ^ X1) * H^n ^ X2 * H^(n-1) ^ ... ^ Xn * H
+static void GhashUpdate(uint64_t* y, const struct AES_gcm_ctx* ctx, const uint8_t* data, uint32_t length)
+{
+  uint8_t padded[AES_GCM_HPOWERS * AES_BLOCKLEN];
+  uint64_t z[4];
+  uint32_t blocks;
+  uint32_t b;
+
+  while (length > 0)
+  {
+    if (length < sizeof(padded))
+    {
+      memset(padded, 0, sizeof(padded));
+      memcpy(padded, data, length);
+      data = padded;
+      blocks = (length + AES_BLOCKLEN - 1) / AES_BLOCKLEN;
+      length = 0;
+    }
+    else
+    {
+      blocks = AES_GCM_HPOWERS;
+      length -= sizeof(padded);
+    }
+
+    z[0] = z[1] = z[2] = z[3] = 0;
+    for (b = 0; b < blocks; ++b, data += AES_BLOCKLEN)
+    {
+      uint64_t hi = LoadBigEndian64(data);
+      uint64_t lo = LoadBigEndian64(data + 8);
+      if (b == 0)
       {
-	/* inc will owerflow */
-        if (ctx->Iv[bi] == 255)
-	{
-          ctx->Iv[bi] = 0;
-          continue;
-        } 
-        ctx->Iv[bi] += 1;
-        break;   
+        hi ^= y[0];
+        lo ^= y[1];
       }
-      bi = 0;
+      GhashMulAdd(z, hi, lo, ctx->HPowers[blocks - 1 - b]);
     }
+    GhashReduce(y, z);
+  }
+}
+
+// CTR with 32-bit counters (inc32) over buf, hashing each run of ciphertext
+// while it is in the cache: before decryption, or after encryption.
+static void GcmCrypt(struct AES_gcm_ctx* ctx, uint8_t* buf, uint32_t length, int decrypt)
+{
+  uint8_t buffer[AES_PARALLEL_BLOCKS * AES_BLOCKLEN];
+  uint32_t counter = LoadBigEndian32(ctx->Counter + AES_GCM_IVLEN);
+  uint32_t n;
+  uint32_t b;
 
-    buf[i] = (buf[i] ^ buffer[bi]);
+  ctx->DataLength += length;
+  for (; length > 0; length -= n, buf += n)
+  {
+    for (b = 0; b < AES_PARALLEL_BLOCKS && b * AES_BLOCKLEN < length; ++b)
+    {
+      memcpy(buffer + b * AES_BLOCKLEN, ctx->Counter, AES_GCM_IVLEN);
+      StoreBigEndian32(buffer + b * AES_BLOCKLEN + AES_GCM_IVLEN, ++counter);
+    }
+
+    CipherBlocks(buffer, b, &ctx->Aes);
+
+    n = (length < b * AES_BLOCKLEN) ? length : b * AES_BLOCKLEN;
+    if (decrypt)
+    {
+      GhashUpdate(ctx->Hash, ctx, buf, n);
+    }
+    XorBuffer(buf, buffer, n);
+    if (!decrypt)
+    {
+      GhashUpdate(ctx->Hash, ctx, buf, n);
+    }
   }
+
+  StoreBigEndian32(ctx->Counter + AES_GCM_IVLEN, counter);
 }
 
-#endif // #if defined(CTR) && (CTR == 1)
+void AES_GCM_init_ctx(struct AES_gcm_ctx* ctx, const uint8_t* key)
+{
+  uint8_t h[AES_BLOCKLEN];
+  uint64_t z[4];
+  uint64_t power[2];
+  uint8_t i;
+
+  AES_init_ctx(&ctx->Aes, key);
+  memset(h, 0, AES_BLOCKLEN);
+  CipherBlocks(h, 1, &ctx->Aes);
+
+  power[0] = LoadBigEndian64(h);
+  power[1] = LoadBigEndian64(h + 8);
+  GhashPrepareKey(ctx->HPowers[0], power[0], power[1]);
+  for (i = 1; i < AES_GCM_HPOWERS; ++i)
+  {
+    z[0] = z[1] = z[2] = z[3] = 0;
+    GhashMulAdd(z, power[0], power[1], ctx->HPowers[0]);
+    GhashReduce(power, z);
+    GhashPrepareKey(ctx->HPowers[i], power[0], power[1]);
+  }
+}
+
+void AES_GCM_start(struct AES_gcm_ctx* ctx, const uint8_t* iv, const uint8_t* aad, uint32_t aad_length)
+{
+  // J0 = IV || 1; the data counters start at inc32(J0)
+  memcpy(ctx->Counter, iv, AES_GCM_IVLEN);
+  StoreBigEndian32(ctx->Counter + AES_GCM_IVLEN, 1);
+  memcpy(ctx->TagMask, ctx->Counter, AES_BLOCKLEN);
+  CipherBlocks(ctx->TagMask, 1, &ctx->Aes);
+
+  ctx->Hash[0] = 0;
+  ctx->Hash[1] = 0;
+  ctx->AadLength = aad_length;
+  ctx->DataLength = 0;
+  GhashUpdate(ctx->Hash, ctx, aad, aad_length);
+}
+
+void AES_GCM_encrypt_buffer(struct AES_gcm_ctx* ctx, uint8_t* buf, uint32_t length)
+{
+  GcmCrypt(ctx, buf, length, 0);
+}
+
+void AES_GCM_decrypt_buffer(struct AES_gcm_ctx* ctx, uint8_t* buf, uint32_t length)
+{
+  GcmCrypt(ctx, buf, length, 1);
+}
+
+void AES_GCM_finish(struct AES_gcm_ctx* ctx, uint8_t* tag)
+{
+  uint8_t lengths[AES_BLOCKLEN];
+  StoreBigEndian64(lengths, ctx->AadLength * 8);
+  StoreBigEndian64(lengths + 8, ctx->DataLength * 8);
+  GhashUpdate(ctx->Hash, ctx, lengths, AES_BLOCKLEN);
+
+  StoreBigEndian64(tag, ctx->Hash[0]);
+  StoreBigEndian64(tag + 8, ctx->Hash[1]);
+  XorBuffer(tag, ctx->TagMask, AES_GCM_TAGLEN);
+}
+
+int AES_GCM_check_tag(struct AES_gcm_ctx* ctx, const uint8_t* tag)
+{
+  uint8_t expected[AES_GCM_TAGLEN];
+  uint8_t diff = 0;
+  uint8_t i;
+
+  AES_GCM_finish(ctx, expected);
+  for (i = 0; i < AES_GCM_TAGLEN; ++i)
+  {
+    diff |= expected[i] ^ tag[i];
+  }
+  return diff == 0;
+}
 
+#endif // #if defined(GCM) && (GCM == 1)
@@ -7,6 +7,7 @@
 //
 // CBC enables AES encryption in CBC-mode of operation.
 // CTR enables encryption in counter-mode.
+// GCM enables authenticated encryption in Galois/counter mode.
 // ECB enables the basic ECB 16-byte block algorithm. All can be enabled simultaneously.
 
 // The #ifndef-guard allows it to be configured before #include'ing or at compile time.
@@ -22,6 +23,11 @@
   #define CTR 1
 #endif
 
+// GCM enables authenticated encryption in Galois/counter mode.
+#ifndef GCM
+  #define GCM 1
+#endif
+
 
 #define AES128 1
 //#define AES192 1
@@ -43,6 +49,9 @@
 struct AES_ctx
 {
   uint8_t RoundKey[AES_keyExpSize];
+  // The round keys in the bitsliced form of the portable cipher, packed into
+  // the same space.
+  uint64_t SlicedKey[AES_keyExpSize / 8];
 #if (defined(CBC) && (CBC == 1)) || (defined(CTR) && (CTR == 1))
   uint8_t Iv[AES_BLOCKLEN];
 #endif
@@ -61,6 +70,10 @@ void AES_ctx_set_iv(struct AES_ctx* ctx, const uint8_t* iv);
 void AES_ECB_encrypt(struct AES_ctx* ctx, const uint8_t* buf);
 void AES_ECB_decrypt(struct AES_ctx* ctx, const uint8_t* buf);
 
+// Encrypts length / AES_BLOCKLEN independent blocks in place, several at a
+// time; for modes that build their own counter blocks.
+void AES_ECB_encrypt_blocks(struct AES_ctx* ctx, uint8_t* buf, uint32_t length);
+
 #endif // #if defined(ECB) && (ECB == !)
 
 
@@ -87,4 +100,46 @@ void AES_CTR_xcrypt_buffer(struct AES_ctx* ctx, uint8_t* buf, uint32_t length);
 #endif // #if defined(CTR) && (CTR == 1)
 
 
+#if defined(GCM) && (GCM == 1)
+
+#define AES_GCM_IVLEN 12  // Only 96-bit IVs are supported
+#define AES_GCM_TAGLEN 16
+
+// The number of powers of the hash key H kept in the context. GHASH folds in
+// this many blocks per reduction.
+#define AES_GCM_HPOWERS 4
+
+struct AES_gcm_ctx
+{
+  struct AES_ctx Aes;
+  // H^1 .. H^AES_GCM_HPOWERS, six words each (see GhashPrepareKey in aes.c)
+  uint64_t HPowers[AES_GCM_HPOWERS][6];
+  // The state of the message being processed
+  uint64_t Hash[2];
+  uint8_t Counter[AES_BLOCKLEN];
+  uint8_t TagMask[AES_BLOCKLEN];
+  uint64_t AadLength;
+  uint64_t DataLength;
+};
+
+// Encryption and decryption each take a single pass over the data: every run
+// of blocks is hashed right before or after it goes through the cipher.
+// Usage, for one message:
+//   AES_GCM_start(), then AES_GCM_encrypt_buffer() or AES_GCM_decrypt_buffer()
+//   any number of times, then AES_GCM_finish() or AES_GCM_check_tag().
+// NOTES: the buffer length MUST be a multiple of AES_BLOCKLEN, except in the
+//        last call for a message
+//        no IV should ever be reused with the same key
+//        decrypted data must not be used before AES_GCM_check_tag() passes
+void AES_GCM_init_ctx(struct AES_gcm_ctx* ctx, const uint8_t* key);
+void AES_GCM_start(struct AES_gcm_ctx* ctx, const uint8_t* iv, const uint8_t* aad, uint32_t aad_length);
+void AES_GCM_encrypt_buffer(struct AES_gcm_ctx* ctx, uint8_t* buf, uint32_t length);
+void AES_GCM_decrypt_buffer(struct AES_gcm_ctx* ctx, uint8_t* buf, uint32_t length);
+void AES_GCM_finish(struct AES_gcm_ctx* ctx, uint8_t* tag);
+// Returns 1 if tag matches the message, and 0 otherwise; compares in constant time.
+int AES_GCM_check_tag(struct AES_gcm_ctx* ctx, const uint8_t* tag);
+
+#endif // #if defined(GCM) && (GCM == 1)
+
+
 #endif //_AES_H_
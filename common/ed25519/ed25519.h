@@ -3,6 +3,8 @@
 
 #include <stddef.h>
 
+#include "sha3/sha3.h"
+
 #if defined(_WIN32)
     #if defined(ED25519_BUILD_DLL)
         #define ED25519_DECLSPEC __declspec(dllexport)
@@ -26,7 +28,48 @@ int ED25519_DECLSPEC ed25519_create_seed(unsigned char *seed);
 
 void ED25519_DECLSPEC ed25519_create_keypair(unsigned char *public_key, unsigned char *private_key, const unsigned char *seed);
 void ED25519_DECLSPEC ed25519_sign(unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key, const unsigned char *private_key);
-//int ED25519_DECLSPEC ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key);
+
+/*
+    A private key prepared for signing many messages: the secret scalar, the
+    public key, and the nonce hash with the prefix already absorbed.
+    ed25519_sign_ctx produces the same signatures as ed25519_sign. The
+    context is key material; clear it with ed25519_sign_ctx_wipe.
+*/
+typedef struct {
+    unsigned char scalar[32];
+    unsigned char public_key[32];
+    sha3_ctx_t prefix_hash;
+} ed25519_sign_ctx_t;
+
+void ED25519_DECLSPEC ed25519_sign_ctx_init(ed25519_sign_ctx_t *ctx, const unsigned char *public_key, const unsigned char *private_key);
+void ED25519_DECLSPEC ed25519_sign_ctx(unsigned char *signature, const unsigned char *message, size_t message_len, const ed25519_sign_ctx_t *ctx);
+void ED25519_DECLSPEC ed25519_sign_ctx_wipe(ed25519_sign_ctx_t *ctx);
+int ED25519_DECLSPEC ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key);
+
+/*
+    Verifies count signatures, sharing one multi-scalar multiplication per
+    batch. valid[i] is set to what ed25519_verify would return for signature
+    i, and the return value is 1 if all of them are valid.
+
+    scratch (8-byte aligned) bounds the batch size to
+    scratch_size / ED25519_BATCH_SCRATCH_BYTES signatures; with room for fewer
+    than two, each signature is verified on its own.
+
+    A batch only differs from ed25519_verify on signatures whose key or R has
+    a small-order component: the batch equation may accept those.
+*/
+#define ED25519_BATCH_SCRATCH_BYTES 3456
+
+int ED25519_DECLSPEC ed25519_verify_batch(const unsigned char *const *signatures, const unsigned char *const *messages, const size_t *message_lens, const unsigned char *const *public_keys, size_t count, int *valid, void *scratch, size_t scratch_size);
+/*
+    X25519 key agreement (RFC 7748), on the same field arithmetic. Private
+    keys are 32 random bytes; x25519_public_key derives the matching public
+    key. x25519 returns 0 if the peer's public key yields an all-zero shared
+    secret, which must then be rejected.
+*/
+int ED25519_DECLSPEC x25519(unsigned char *shared_secret, const unsigned char *private_key, const unsigned char *public_key);
+void ED25519_DECLSPEC x25519_public_key(unsigned char *public_key, const unsigned char *private_key);
+
 //void ED25519_DECLSPEC ed25519_add_scalar(unsigned char *public_key, unsigned char *private_key, const unsigned char *scalar);
 //void ED25519_DECLSPEC ed25519_key_exchange(unsigned char *shared_secret, const unsigned char *public_key, const unsigned char *private_key);
 
@@ -2,6 +2,8 @@
 #include "fe.h"
 
 
+#if !ED25519_64BIT
+
 /*
     helper functions
 */
@@ -359,6 +361,8 @@ void fe_frombytes(fe h, const unsigned char *s) {
     h[9] = (int32_t) h9;
 }
 
+#endif
+
 
 
 void fe_invert(fe out, const fe z) {
@@ -521,6 +525,8 @@ int fe_isnonzero(const fe f) {
 
 
 
+#if !ED25519_64BIT
+
 /*
     h = f * g
     Can overlap h with f or g.
@@ -877,6 +883,9 @@ void fe_neg(fe h, const fe f) {
     h[9] = h9;
 }
 
+#endif
+
+
 
 void fe_pow22523(fe out, const fe z) {
     fe t0;
@@ -964,6 +973,9 @@ void fe_pow22523(fe out, const fe z) {
 }
 
 
+
+#if !ED25519_64BIT
+
 /*
 h = f * f
 Can overlap h with f.
@@ -1489,3 +1501,5 @@ void fe_tobytes(unsigned char *s, const fe h) {
     s[30] = (unsigned char) (h9 >> 10);
     s[31] = (unsigned char) (h9 >> 18);
 }
+
+#endif
@@ -0,0 +1,400 @@
+#include "fixedint.h"
+#include "fe.h"
+
+#if ED25519_64BIT
+
+/*
+    Field arithmetic with five 51-bit limbs, for 64-bit targets.
+
+    fe_invert, fe_pow22523, fe_isnegative and fe_isnonzero are written in
+    terms of the functions below, and are shared with the 32-bit code in fe.c.
+
+    Unless noted otherwise, inputs have limbs below 2^54 and outputs have
+    limbs below 2^51 + 2^15 ("reduced").
+*/
+
+typedef unsigned __int128 uint128_t;
+
+#define FE51_MASK ((((uint64_t) 1) << 51) - 1)
+
+
+/*
+    helper functions
+*/
+static uint64_t load_8(const unsigned char *in) {
+    uint64_t result;
+
+    result = (uint64_t) in[0];
+    result |= ((uint64_t) in[1]) << 8;
+    result |= ((uint64_t) in[2]) << 16;
+    result |= ((uint64_t) in[3]) << 24;
+    result |= ((uint64_t) in[4]) << 32;
+    result |= ((uint64_t) in[5]) << 40;
+    result |= ((uint64_t) in[6]) << 48;
+    result |= ((uint64_t) in[7]) << 56;
+
+    return result;
+}
+
+static void store_8(unsigned char *out, uint64_t in) {
+    int i;
+
+    for (i = 0; i < 8; ++i) {
+        out[i] = (unsigned char) (in >> (8 * i));
+    }
+}
+
+/*
+    Carries the 128-bit column sums t into h.
+*/
+static void fe_carry_wide(fe h, uint128_t t0, uint128_t t1, uint128_t t2, uint128_t t3, uint128_t t4) {
+    t1 += t0 >> 51;
+    t0 &= FE51_MASK;
+    t2 += t1 >> 51;
+    t1 &= FE51_MASK;
+    t3 += t2 >> 51;
+    t2 &= FE51_MASK;
+    t4 += t3 >> 51;
+    t3 &= FE51_MASK;
+    t0 += (t4 >> 51) * 19;
+    t4 &= FE51_MASK;
+    t1 += t0 >> 51;
+    t0 &= FE51_MASK;
+
+    h[0] = (uint64_t) t0;
+    h[1] = (uint64_t) t1;
+    h[2] = (uint64_t) t2;
+    h[3] = (uint64_t) t3;
+    h[4] = (uint64_t) t4;
+}
+
+/*
+    Carries 64-bit limbs below 2^63 into h.
+*/
+static void fe_carry(fe h, uint64_t h0, uint64_t h1, uint64_t h2, uint64_t h3, uint64_t h4) {
+    h1 += h0 >> 51;
+    h0 &= FE51_MASK;
+    h2 += h1 >> 51;
+    h1 &= FE51_MASK;
+    h3 += h2 >> 51;
+    h2 &= FE51_MASK;
+    h4 += h3 >> 51;
+    h3 &= FE51_MASK;
+    h0 += (h4 >> 51) * 19;
+    h4 &= FE51_MASK;
+    h1 += h0 >> 51;
+    h0 &= FE51_MASK;
+
+    h[0] = h0;
+    h[1] = h1;
+    h[2] = h2;
+    h[3] = h3;
+    h[4] = h4;
+}
+
+
+
+/*
+    h = 0
+*/
+
+void fe_0(fe h) {
+    h[0] = 0;
+    h[1] = 0;
+    h[2] = 0;
+    h[3] = 0;
+    h[4] = 0;
+}
+
+
+
+/*
+    h = 1
+*/
+
+void fe_1(fe h) {
+    h[0] = 1;
+    h[1] = 0;
+    h[2] = 0;
+    h[3] = 0;
+    h[4] = 0;
+}
+
+
+
+/*
+    h = f + g
+    Can overlap h with f or g.
+
+    Preconditions:
+       f, g reduced.
+
+    Postconditions:
+       limbs of h below 2^52 + 2^16, not reduced.
+*/
+
+void fe_add(fe h, const fe f, const fe g) {
+    h[0] = f[0] + g[0];
+    h[1] = f[1] + g[1];
+    h[2] = f[2] + g[2];
+    h[3] = f[3] + g[3];
+    h[4] = f[4] + g[4];
+}
+
+
+
+/*
+    Replace (f,g) with (g,g) if b == 1;
+    replace (f,g) with (f,g) if b == 0.
+
+    Preconditions: b in {0,1}.
+*/
+
+void fe_cmov(fe f, const fe g, unsigned int b) {
+    uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+
+    f[0] ^= mask & (f[0] ^ g[0]);
+    f[1] ^= mask & (f[1] ^ g[1]);
+    f[2] ^= mask & (f[2] ^ g[2]);
+    f[3] ^= mask & (f[3] ^ g[3]);
+    f[4] ^= mask & (f[4] ^ g[4]);
+}
+
+
+
+/*
+    Replace (f,g) with (g,f) if b == 1;
+    replace (f,g) with (f,g) if b == 0.
+
+    Preconditions: b in {0,1}.
+*/
+
+void fe_cswap(fe f, fe g, unsigned int b) {
+    uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+    uint64_t x;
+    int i;
+
+    for (i = 0; i < 5; ++i) {
+        x = mask & (f[i] ^ g[i]);
+        f[i] ^= x;
+        g[i] ^= x;
+    }
+}
+
+
+
+/*
+    h = f
+*/
+
+void fe_copy(fe h, const fe f) {
+    h[0] = f[0];
+    h[1] = f[1];
+    h[2] = f[2];
+    h[3] = f[3];
+    h[4] = f[4];
+}
+
+
+
+/*
+    Ignores top bit of s.
+*/
+
+void fe_frombytes(fe h, const unsigned char *s) {
+    h[0] = load_8(s) & FE51_MASK;
+    h[1] = (load_8(s + 6) >> 3) & FE51_MASK;
+    h[2] = (load_8(s + 12) >> 6) & FE51_MASK;
+    h[3] = (load_8(s + 19) >> 1) & FE51_MASK;
+    h[4] = (load_8(s + 24) >> 12) & FE51_MASK;
+}
+
+
+
+/*
+    h = f * g
+    Can overlap h with f or g.
+
+    Using schoolbook multiplication; the 2^255 wraparound is folded in by
+    multiplying the high limbs of g by 19 up front.
+*/
+
+void fe_mul(fe h, const fe f, const fe g) {
+    uint64_t f0 = f[0];
+    uint64_t f1 = f[1];
+    uint64_t f2 = f[2];
+    uint64_t f3 = f[3];
+    uint64_t f4 = f[4];
+    uint64_t g0 = g[0];
+    uint64_t g1 = g[1];
+    uint64_t g2 = g[2];
+    uint64_t g3 = g[3];
+    uint64_t g4 = g[4];
+    uint64_t g1_19 = 19 * g1;
+    uint64_t g2_19 = 19 * g2;
+    uint64_t g3_19 = 19 * g3;
+    uint64_t g4_19 = 19 * g4;
+    uint128_t t0;
+    uint128_t t1;
+    uint128_t t2;
+    uint128_t t3;
+    uint128_t t4;
+
+    t0 = (uint128_t) f0 * g0 + (uint128_t) f1 * g4_19 + (uint128_t) f2 * g3_19 + (uint128_t) f3 * g2_19 + (uint128_t) f4 * g1_19;
+    t1 = (uint128_t) f0 * g1 + (uint128_t) f1 * g0 + (uint128_t) f2 * g4_19 + (uint128_t) f3 * g3_19 + (uint128_t) f4 * g2_19;
+    t2 = (uint128_t) f0 * g2 + (uint128_t) f1 * g1 + (uint128_t) f2 * g0 + (uint128_t) f3 * g4_19 + (uint128_t) f4 * g3_19;
+    t3 = (uint128_t) f0 * g3 + (uint128_t) f1 * g2 + (uint128_t) f2 * g1 + (uint128_t) f3 * g0 + (uint128_t) f4 * g4_19;
+    t4 = (uint128_t) f0 * g4 + (uint128_t) f1 * g3 + (uint128_t) f2 * g2 + (uint128_t) f3 * g1 + (uint128_t) f4 * g0;
+
+    fe_carry_wide(h, t0, t1, t2, t3, t4);
+}
+
+
+
+/*
+    h = f * 121666
+    Can overlap h with f.
+*/
+
+void fe_mul121666(fe h, fe f) {
+    fe_carry_wide(h,
+                  (uint128_t) f[0] * 121666,
+                  (uint128_t) f[1] * 121666,
+                  (uint128_t) f[2] * 121666,
+                  (uint128_t) f[3] * 121666,
+                  (uint128_t) f[4] * 121666);
+}
+
+
+
+/*
+    h = -f
+
+    Preconditions:
+       f reduced.
+*/
+
+void fe_neg(fe h, const fe f) {
+    fe zero;
+
+    fe_0(zero);
+    fe_sub(h, zero, f);
+}
+
+
+
+/*
+    Computes the column sums of f^2.
+*/
+static void fe_sq_wide(uint128_t t[5], const fe f) {
+    uint64_t f0 = f[0];
+    uint64_t f1 = f[1];
+    uint64_t f2 = f[2];
+    uint64_t f3 = f[3];
+    uint64_t f4 = f[4];
+    uint64_t f0_2 = 2 * f0;
+    uint64_t f1_2 = 2 * f1;
+    uint64_t f1_38 = 38 * f1;
+    uint64_t f2_38 = 38 * f2;
+    uint64_t f3_38 = 38 * f3;
+    uint64_t f3_19 = 19 * f3;
+    uint64_t f4_19 = 19 * f4;
+
+    t[0] = (uint128_t) f0 * f0 + (uint128_t) f1_38 * f4 + (uint128_t) f2_38 * f3;
+    t[1] = (uint128_t) f0_2 * f1 + (uint128_t) f2_38 * f4 + (uint128_t) f3_19 * f3;
+    t[2] = (uint128_t) f0_2 * f2 + (uint128_t) f1 * f1 + (uint128_t) f3_38 * f4;
+    t[3] = (uint128_t) f0_2 * f3 + (uint128_t) f1_2 * f2 + (uint128_t) f4_19 * f4;
+    t[4] = (uint128_t) f0_2 * f4 + (uint128_t) f1_2 * f3 + (uint128_t) f2 * f2;
+}
+
+
+
+/*
+    h = f * f
+    Can overlap h with f.
+*/
+
+void fe_sq(fe h, const fe f) {
+    uint128_t t[5];
+
+    fe_sq_wide(t, f);
+    fe_carry_wide(h, t[0], t[1], t[2], t[3], t[4]);
+}
+
+
+
+/*
+    h = 2 * f * f
+    Can overlap h with f.
+*/
+
+void fe_sq2(fe h, const fe f) {
+    uint128_t t[5];
+
+    fe_sq_wide(t, f);
+    fe_carry_wide(h, 2 * t[0], 2 * t[1], 2 * t[2], 2 * t[3], 2 * t[4]);
+}
+
+
+
+/*
+    h = f - g
+    Can overlap h with f or g.
+
+    Preconditions:
+       limbs of f below 2^62, limbs of g below 2^53.
+
+    4p is added before subtracting, so the limbs never go negative.
+*/
+
+void fe_sub(fe h, const fe f, const fe g) {
+    fe_carry(h,
+             (f[0] + 0x1fffffffffffb4) - g[0],
+             (f[1] + 0x1ffffffffffffc) - g[1],
+             (f[2] + 0x1ffffffffffffc) - g[2],
+             (f[3] + 0x1ffffffffffffc) - g[3],
+             (f[4] + 0x1ffffffffffffc) - g[4]);
+}
+
+
+
+/*
+    Preconditions:
+       limbs of h below 2^62.
+
+    Write p=2^255-19; q=floor(h/p).
+    Fully reduces h and packs the 255 bits little-endian.
+*/
+
+void fe_tobytes(unsigned char *s, const fe h) {
+    fe t;
+    uint64_t q;
+
+    fe_carry(t, h[0], h[1], h[2], h[3], h[4]);
+
+    /* t < 2p, so q is 0 or 1 */
+    q = (t[0] + 19) >> 51;
+    q = (t[1] + q) >> 51;
+    q = (t[2] + q) >> 51;
+    q = (t[3] + q) >> 51;
+    q = (t[4] + q) >> 51;
+
+    /* Goal: Output t-(2^255-19)q, which is between 0 and 2^255-20. */
+    t[0] += 19 * q;
+    t[1] += t[0] >> 51;
+    t[0] &= FE51_MASK;
+    t[2] += t[1] >> 51;
+    t[1] &= FE51_MASK;
+    t[3] += t[2] >> 51;
+    t[2] &= FE51_MASK;
+    t[4] += t[3] >> 51;
+    t[3] &= FE51_MASK;
+    t[4] &= FE51_MASK;
+
+    store_8(s, t[0] | (t[1] << 51));
+    store_8(s + 8, (t[1] >> 13) | (t[2] << 38));
+    store_8(s + 16, (t[2] >> 26) | (t[3] << 25));
+    store_8(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+#endif
@@ -70,3 +70,19 @@
         #define INT64_C(v) v ##I64
     #endif
 #endif
+
+
+/*
+    ED25519_64BIT selects the field and scalar arithmetic:
+      1: 51-bit field limbs and 52-bit scalar limbs with unsigned __int128
+         products (fe51.c, sc52.c)
+      0: the 32-bit ref10 code (fe.c, sc.c)
+    It defaults to 1 wherever the compiler provides unsigned __int128.
+*/
+#ifndef ED25519_64BIT
+    #if defined(__SIZEOF_INT128__)
+        #define ED25519_64BIT 1
+    #else
+        #define ED25519_64BIT 0
+    #endif
+#endif
@@ -1,5 +1,21 @@
 #include "ge.h"
+
+/*
+    ED25519_PRECOMP_HEADER names a table generated by tools/ed25519_precomp.py
+    with a different geometry for ge_scalarmult_base; see the Makefile.
+*/
+#ifdef ED25519_PRECOMP_HEADER
+#include ED25519_PRECOMP_HEADER
+#else
 #include "precomp_data.h"
+#endif
+
+/* signed digits of the scalar, and the points per table row */
+#define ED25519_BASE_DIGITS ((256 + ED25519_BASE_WINDOW - 1) / ED25519_BASE_WINDOW)
+#define ED25519_BASE_ROWS ((ED25519_BASE_DIGITS + ED25519_BASE_SPACING - 1) / ED25519_BASE_SPACING)
+#define ED25519_BASE_POINTS (1 << (ED25519_BASE_WINDOW - 1))
+
+typedef char base_table_matches_geometry[(sizeof(base) == sizeof(ge_precomp) * ED25519_BASE_ROWS * ED25519_BASE_POINTS) ? 1 : -1];
 
 
 /*
@@ -57,6 +73,26 @@ static void slide(signed char *r, const unsigned char *a) {
         }
 }
 
+/*
+Ai = A,3A,5A,7A,9A,11A,13A,15A
+*/
+
+static void odd_multiples(ge_cached *Ai, const ge_p3 *A) {
+    ge_p1p1 t;
+    ge_p3 u;
+    ge_p3 A2;
+    int i;
+    ge_p3_to_cached(&Ai[0], A);
+    ge_p3_dbl(&t, A);
+    ge_p1p1_to_p3(&A2, &t);
+
+    for (i = 1; i < 8; ++i) {
+        ge_add(&t, &A2, &Ai[i - 1]);
+        ge_p1p1_to_p3(&u, &t);
+        ge_p3_to_cached(&Ai[i], &u);
+    }
+}
+
 /*
 r = a * A + b * B
 where a = a[0]+256*a[1]+...+256^31 a[31].
@@ -70,34 +106,10 @@ void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3
     ge_cached Ai[8]; /* A,3A,5A,7A,9A,11A,13A,15A */
     ge_p1p1 t;
     ge_p3 u;
-    ge_p3 A2;
     int i;
     slide(aslide, a);
     slide(bslide, b);
-    ge_p3_to_cached(&Ai[0], A);
-    ge_p3_dbl(&t, A);
-    ge_p1p1_to_p3(&A2, &t);
-    ge_add(&t, &A2, &Ai[0]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[1], &u);
-    ge_add(&t, &A2, &Ai[1]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[2], &u);
-    ge_add(&t, &A2, &Ai[2]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[3], &u);
-    ge_add(&t, &A2, &Ai[3]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[4], &u);
-    ge_add(&t, &A2, &Ai[4]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[5], &u);
-    ge_add(&t, &A2, &Ai[5]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[6], &u);
-    ge_add(&t, &A2, &Ai[6]);
-    ge_p1p1_to_p3(&u, &t);
-    ge_p3_to_cached(&Ai[7], &u);
+    odd_multiples(Ai, A);
     ge_p2_0(r);
 
     for (i = 255; i >= 0; --i) {
@@ -130,6 +142,79 @@ void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3
 }
 
 
+/*
+r = b * B + terms[0].scalar * terms[0].point + ... (count terms)
+where the scalars are 32-byte little-endian like a and b above.
+The table and slide of each term are used as scratch space.
+This is Straus's method: all the terms share one chain of doublings.
+*/
+
+void ge_multi_scalarmult_vartime(ge_p2 *r, const unsigned char *b, ge_msm_term *terms, size_t count) {
+    signed char bslide[256];
+    ge_p1p1 t;
+    ge_p3 u;
+    size_t j;
+    int top;
+    int i;
+    slide(bslide, b);
+
+    top = 255;
+
+    while (top >= 0 && !bslide[top]) {
+        --top;
+    }
+
+    for (j = 0; j < count; ++j) {
+        slide(terms[j].slide, terms[j].scalar);
+        odd_multiples(terms[j].table, &terms[j].point);
+
+        for (i = 255; i > top; --i) {
+            if (terms[j].slide[i]) {
+                top = i;
+                break;
+            }
+        }
+    }
+
+    ge_p2_0(r);
+
+    for (i = top; i >= 0; --i) {
+        ge_p2_dbl(&t, r);
+
+        for (j = 0; j < count; ++j) {
+            signed char c = terms[j].slide[i];
+
+            if (c > 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_add(&t, &u, &terms[j].table[c / 2]);
+            } else if (c < 0) {
+                ge_p1p1_to_p3(&u, &t);
+                ge_sub(&t, &u, &terms[j].table[(-c) / 2]);
+            }
+        }
+
+        if (bslide[i] > 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_madd(&t, &u, &Bi[bslide[i] / 2]);
+        } else if (bslide[i] < 0) {
+            ge_p1p1_to_p3(&u, &t);
+            ge_msub(&t, &u, &Bi[(-bslide[i]) / 2]);
+        }
+
+        ge_p1p1_to_p2(r, &t);
+    }
+}
+
+
+#if ED25519_64BIT
+static const fe d = {
+    0x34dca135978a3, 0x1a8283b156ebd, 0x5e7a26001c029, 0x739c663a03cbb, 0x52036cee2b6ff
+};
+
+static const fe sqrtm1 = {
+    0x61b274a0ea0b0, 0x0d5a5fc8f189d, 0x7ef5e9cbd0c60, 0x78595a6804c9e, 0x2b8324804fc1d
+};
+#else
 static const fe d = {
     -10913610, 13857413, -15372611, 6949391, 114729, -8787816, -6275908, -3247719, -18696448, -12055116
 };
@@ -137,6 +222,7 @@ static const fe d = {
 static const fe sqrtm1 = {
     -32595792, -7943725, 9377950, 3500415, 12389472, -272473, -25146209, -2005654, 326686, 11406482
 };
+#endif
 
 int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s) {
     fe u;
@@ -295,9 +381,15 @@ void ge_p3_dbl(ge_p1p1 *r, const ge_p3 *p) {
 r = p
 */
 
+#if ED25519_64BIT
+static const fe d2 = {
+    0x69b9426b2f159, 0x35050762add7a, 0x3cf44c0038052, 0x6738cc7407977, 0x2406d9dc56dff
+};
+#else
 static const fe d2 = {
     -21827239, -5839606, -30745221, 13898782, 229458, 15978800, -12551817, -6495438, 29715968, 9444199
 };
+#endif
 
 void ge_p3_to_cached(ge_cached *r, const ge_p3 *p) {
     fe_add(r->YplusX, p->Y, p->X);
@@ -357,17 +449,16 @@ static void select(ge_precomp *t, int pos, signed char b) {
     ge_precomp minust;
     unsigned char bnegative = negative(b);
     unsigned char babs = b - (((-bnegative) & b) << 1);
+    int j;
+
     fe_1(t->yplusx);
     fe_1(t->yminusx);
     fe_0(t->xy2d);
-    cmov(t, &base[pos][0], equal(babs, 1));
-    cmov(t, &base[pos][1], equal(babs, 2));
-    cmov(t, &base[pos][2], equal(babs, 3));
-    cmov(t, &base[pos][3], equal(babs, 4));
-    cmov(t, &base[pos][4], equal(babs, 5));
-    cmov(t, &base[pos][5], equal(babs, 6));
-    cmov(t, &base[pos][6], equal(babs, 7));
-    cmov(t, &base[pos][7], equal(babs, 8));
+
+    for (j = 0; j < ED25519_BASE_POINTS; ++j) {
+        cmov(t, &base[pos][j], equal(babs, j + 1));
+    }
+
     fe_copy(minust.yplusx, t->yminusx);
     fe_copy(minust.yminusx, t->yplusx);
     fe_neg(minust.xy2d, t->xy2d);
@@ -381,54 +472,74 @@ B is the Ed25519 base point (x,4/5) with x positive.
 
 Preconditions:
   a[31] <= 127
+
+a is written as signed digits e[i] of ED25519_BASE_WINDOW bits. Row k of the
+table holds the multiples of 2^(ED25519_BASE_WINDOW*ED25519_BASE_SPACING*k) B,
+so the digits i = k*ED25519_BASE_SPACING + p for a fixed p are added straight
+from the table. The passes for each p are separated by ED25519_BASE_WINDOW
+doublings.
 */
 
 void ge_scalarmult_base(ge_p3 *h, const unsigned char *a) {
-    signed char e[64];
-    signed char carry;
+    signed char e[ED25519_BASE_DIGITS];
+    int window;
+    int carry;
+    int bit;
     ge_p1p1 r;
     ge_p2 s;
     ge_precomp t;
     int i;
+    int k;
+    int p;
+
+    for (i = 0; i < ED25519_BASE_DIGITS; ++i) {
+        bit = i * ED25519_BASE_WINDOW;
+        window = a[bit >> 3] >> (bit & 7);
+
+        if ((bit & 7) + ED25519_BASE_WINDOW > 8 && (bit >> 3) < 31) {
+            window |= a[(bit >> 3) + 1] << (8 - (bit & 7));
+        }
 
-    for (i = 0; i < 32; ++i) {
-        e[2 * i + 0] = (a[i] >> 0) & 15;
-        e[2 * i + 1] = (a[i] >> 4) & 15;
+        e[i] = window & ((1 << ED25519_BASE_WINDOW) - 1);
     }
 
-    /* each e[i] is between 0 and 15 */
-    /* e[63] is between 0 and 7 */
+    /* each e[i] is between 0 and 2^w - 1 */
+    /* a < 2^255, so the top digit is below 2^(w-1) */
     carry = 0;
 
-    for (i = 0; i < 63; ++i) {
-        e[i] += carry;
-        carry = e[i] + 8;
-        carry >>= 4;
-        e[i] -= carry << 4;
+    for (i = 0; i < ED25519_BASE_DIGITS - 1; ++i) {
+        window = e[i] + carry;
+        carry = window + (1 << (ED25519_BASE_WINDOW - 1));
+        carry >>= ED25519_BASE_WINDOW;
+        e[i] = window - (carry << ED25519_BASE_WINDOW);
     }
 
-    e[63] += carry;
-    /* each e[i] is between -8 and 8 */
+    e[ED25519_BASE_DIGITS - 1] += carry;
+    /* each e[i] is between -2^(w-1) and 2^(w-1) */
     ge_p3_0(h);
 
-    for (i = 1; i < 64; i += 2) {
-        select(&t, i / 2, e[i]);
-        ge_madd(&r, h, &t);
-        ge_p1p1_to_p3(h, &r);
-    }
+    for (p = ED25519_BASE_SPACING - 1; p >= 0; --p) {
+        for (k = 0; k < ED25519_BASE_ROWS; ++k) {
+            i = k * ED25519_BASE_SPACING + p;
+
+            if (i < ED25519_BASE_DIGITS) {
+                select(&t, k, e[i]);
+                ge_madd(&r, h, &t);
+                ge_p1p1_to_p3(h, &r);
+            }
+        }
+
+        if (p == 0) {
+            break;
+        }
+
+        ge_p3_dbl(&r, h);
+
+        for (i = 1; i < ED25519_BASE_WINDOW; ++i) {
+            ge_p1p1_to_p2(&s, &r);
+            ge_p2_dbl(&r, &s);
+        }
 
-    ge_p3_dbl(&r, h);
-    ge_p1p1_to_p2(&s, &r);
-    ge_p2_dbl(&r, &s);
-    ge_p1p1_to_p2(&s, &r);
-    ge_p2_dbl(&r, &s);
-    ge_p1p1_to_p2(&s, &r);
-    ge_p2_dbl(&r, &s);
-    ge_p1p1_to_p3(h, &r);
-
-    for (i = 0; i < 64; i += 2) {
-        select(&t, i / 2, e[i]);
-        ge_madd(&r, h, &t);
         ge_p1p1_to_p3(h, &r);
     }
 }
@@ -1,6 +1,8 @@
 #ifndef GE_H
 #define GE_H
 
+#include <stddef.h>
+
 #include "fe.h"
 
 
@@ -51,6 +53,17 @@ typedef struct {
   fe T2d;
 } ge_cached;
 
+/*
+One term of ge_multi_scalarmult_vartime: the caller sets point and scalar,
+table and slide are scratch space.
+*/
+typedef struct {
+  ge_p3 point;
+  unsigned char scalar[32];
+  ge_cached table[8];
+  signed char slide[256];
+} ge_msm_term;
+
 void ge_p3_tobytes(unsigned char *s, const ge_p3 *h);
 void ge_tobytes(unsigned char *s, const ge_p2 *h);
 int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s);
@@ -58,6 +71,7 @@ int ge_frombytes_negate_vartime(ge_p3 *h, const unsigned char *s);
 void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q);
 void ge_sub(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q);
 void ge_double_scalarmult_vartime(ge_p2 *r, const unsigned char *a, const ge_p3 *A, const unsigned char *b);
+void ge_multi_scalarmult_vartime(ge_p2 *r, const unsigned char *b, ge_msm_term *terms, size_t count);
 void ge_madd(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q);
 void ge_msub(ge_p1p1 *r, const ge_p3 *p, const ge_precomp *q);
 void ge_scalarmult_base(ge_p3 *h, const unsigned char *a);
@@ -1,6 +1,8 @@
 #include "fixedint.h"
 #include "sc.h"
 
+#if !ED25519_64BIT
+
 static uint64_t load_3(const unsigned char *in) {
     uint64_t result;
 
@@ -807,3 +809,5 @@ void sc_muladd(unsigned char *s, const unsigned char *a, const unsigned char *b,
     s[30] = (unsigned char) (s11 >> 9);
     s[31] = (unsigned char) (s11 >> 17);
 }
+
+#endif
@@ -0,0 +1,314 @@
+#include "fixedint.h"
+#include "sc.h"
+
+#if ED25519_64BIT
+
+/*
+    Scalar arithmetic with five 52-bit limbs, for 64-bit targets.
+
+    Reductions mod l use Montgomery multiplication with R = 2^260: a 512-bit
+    value lo + 2^260 hi is reduced as (lo * R) / R + (hi * R^2) / R.
+*/
+
+typedef unsigned __int128 uint128_t;
+
+typedef uint64_t sc52[5];
+
+#define SC52_MASK ((((uint64_t) 1) << 52) - 1)
+
+/* l = 2^252 + 27742317777372353535851937790883648493 */
+static const sc52 L = {
+    0x2631a5cf5d3ed, 0xdea2f79cd6581, 0x000000014def9, 0x0000000000000, 0x0100000000000
+};
+
+/* -1/l mod 2^52 */
+static const uint64_t LFACTOR = 0x51da312547e1b;
+
+/* R = 2^260 mod l */
+static const sc52 R = {
+    0xf48bd6721e6ed, 0x3bab5ac67e45a, 0xfffffeb35e51b, 0xfffffffffffff, 0x00fffffffffff
+};
+
+/* R^2 = 2^520 mod l */
+static const sc52 RR = {
+    0x9d265e952d13b, 0xd63c715bea69f, 0x5be65cb687604, 0x3dceec73d217f, 0x009411b7c309a
+};
+
+
+/*
+    helper functions
+*/
+static uint64_t load_8(const unsigned char *in) {
+    uint64_t result;
+
+    result = (uint64_t) in[0];
+    result |= ((uint64_t) in[1]) << 8;
+    result |= ((uint64_t) in[2]) << 16;
+    result |= ((uint64_t) in[3]) << 24;
+    result |= ((uint64_t) in[4]) << 32;
+    result |= ((uint64_t) in[5]) << 40;
+    result |= ((uint64_t) in[6]) << 48;
+    result |= ((uint64_t) in[7]) << 56;
+
+    return result;
+}
+
+static void store_8(unsigned char *out, uint64_t in) {
+    int i;
+
+    for (i = 0; i < 8; ++i) {
+        out[i] = (unsigned char) (in >> (8 * i));
+    }
+}
+
+/*
+    Unpacks 32 bytes into 52-bit limbs; the top limb has 48 bits.
+*/
+static void sc52_frombytes(sc52 h, const unsigned char *s) {
+    uint64_t w0 = load_8(s);
+    uint64_t w1 = load_8(s + 8);
+    uint64_t w2 = load_8(s + 16);
+    uint64_t w3 = load_8(s + 24);
+
+    h[0] = w0 & SC52_MASK;
+    h[1] = ((w0 >> 52) | (w1 << 12)) & SC52_MASK;
+    h[2] = ((w1 >> 40) | (w2 << 24)) & SC52_MASK;
+    h[3] = ((w2 >> 28) | (w3 << 36)) & SC52_MASK;
+    h[4] = w3 >> 16;
+}
+
+/*
+    Preconditions:
+       h < 2^256
+*/
+static void sc52_tobytes(unsigned char *s, const sc52 h) {
+    store_8(s, h[0] | (h[1] << 52));
+    store_8(s + 8, (h[1] >> 12) | (h[2] << 40));
+    store_8(s + 16, (h[2] >> 24) | (h[3] << 28));
+    store_8(s + 24, (h[3] >> 36) | (h[4] << 16));
+}
+
+/*
+    h = f - g mod l
+
+    Preconditions:
+       f, g < 2^260; -l <= f - g < l
+*/
+static void sc52_sub(sc52 h, const sc52 f, const sc52 g) {
+    uint64_t borrow = 0;
+    uint64_t carry = 0;
+    uint64_t underflow_mask;
+    int i;
+
+    for (i = 0; i < 5; ++i) {
+        borrow = f[i] - (g[i] + (borrow >> 63));
+        h[i] = borrow & SC52_MASK;
+    }
+
+    /* add l back if the difference is negative */
+    underflow_mask = ((borrow >> 63) ^ 1) - 1;
+
+    for (i = 0; i < 5; ++i) {
+        carry = (carry >> 52) + h[i] + (L[i] & underflow_mask);
+        h[i] = carry & SC52_MASK;
+    }
+}
+
+/*
+    h = f + g mod l
+
+    Preconditions:
+       f, g < l
+*/
+static void sc52_add(sc52 h, const sc52 f, const sc52 g) {
+    sc52 sum;
+    uint64_t carry = 0;
+    int i;
+
+    for (i = 0; i < 5; ++i) {
+        carry = f[i] + g[i] + (carry >> 52);
+        sum[i] = carry & SC52_MASK;
+    }
+
+    sc52_sub(h, sum, L);
+}
+
+/*
+    z = f * g, as unreduced column sums.
+*/
+static void sc52_mul_wide(uint128_t z[9], const sc52 f, const sc52 g) {
+    int i;
+    int j;
+
+    for (i = 0; i < 9; ++i) {
+        z[i] = 0;
+    }
+
+    for (i = 0; i < 5; ++i) {
+        for (j = 0; j < 5; ++j) {
+            z[i + j] += (uint128_t) f[i] * g[j];
+        }
+    }
+}
+
+/*
+    Montgomery reduction steps: part1 picks the multiple of l that clears the
+    low 52 bits, part2 just splits off a limb.
+*/
+static uint128_t part1(uint128_t sum, uint64_t *n) {
+    uint64_t p = ((uint64_t) sum * LFACTOR) & SC52_MASK;
+
+    *n = p;
+    return (sum + (uint128_t) p * L[0]) >> 52;
+}
+
+static uint128_t part2(uint128_t sum, uint64_t *r) {
+    *r = (uint64_t) sum & SC52_MASK;
+    return sum >> 52;
+}
+
+/*
+    h = z / R mod l
+
+    Preconditions:
+       z is the column sums of a product of two values below 2^260
+       z / R < 2l
+*/
+static void sc52_montgomery_reduce(sc52 h, const uint128_t z[9]) {
+    uint128_t carry;
+    uint64_t n0, n1, n2, n3, n4;
+    sc52 r;
+
+    /* l[3] is zero, so its terms are left out */
+    carry = part1(z[0], &n0);
+    carry = part1(carry + z[1] + (uint128_t) n0 * L[1], &n1);
+    carry = part1(carry + z[2] + (uint128_t) n0 * L[2] + (uint128_t) n1 * L[1], &n2);
+    carry = part1(carry + z[3] + (uint128_t) n1 * L[2] + (uint128_t) n2 * L[1], &n3);
+    carry = part1(carry + z[4] + (uint128_t) n0 * L[4] + (uint128_t) n2 * L[2] + (uint128_t) n3 * L[1], &n4);
+
+    /* z + n l is now divisible by R; keep the upper half */
+    carry = part2(carry + z[5] + (uint128_t) n1 * L[4] + (uint128_t) n3 * L[2] + (uint128_t) n4 * L[1], &r[0]);
+    carry = part2(carry + z[6] + (uint128_t) n2 * L[4] + (uint128_t) n4 * L[2], &r[1]);
+    carry = part2(carry + z[7] + (uint128_t) n3 * L[4], &r[2]);
+    carry = part2(carry + z[8] + (uint128_t) n4 * L[4], &r[3]);
+    r[4] = (uint64_t) carry;
+
+    sc52_sub(h, r, L);
+}
+
+/*
+    h = f * g / R mod l
+*/
+static void sc52_montgomery_mul(sc52 h, const sc52 f, const sc52 g) {
+    uint128_t z[9];
+
+    sc52_mul_wide(z, f, g);
+    sc52_montgomery_reduce(h, z);
+}
+
+/*
+    h = lo + 2^260 hi mod l, where lo and hi are the low and high five limbs
+    of a 512-bit value.
+*/
+static void sc52_reduce_wide(sc52 h, const sc52 lo, const sc52 hi) {
+    sc52 t0;
+    sc52 t1;
+
+    sc52_montgomery_mul(t0, lo, R);     /* lo mod l */
+    sc52_montgomery_mul(t1, hi, RR);    /* hi R mod l */
+    sc52_add(h, t1, t0);
+}
+
+
+
+/*
+Input:
+  s[0]+256*s[1]+...+256^63*s[63] = s
+
+Output:
+  s[0]+256*s[1]+...+256^31*s[31] = s mod l
+  where l = 2^252 + 27742317777372353535851937790883648493.
+  Overwrites s in place.
+*/
+
+void sc_reduce(unsigned char *s) {
+    uint64_t w[8];
+    sc52 lo;
+    sc52 hi;
+    sc52 h;
+    int i;
+
+    for (i = 0; i < 8; ++i) {
+        w[i] = load_8(s + 8 * i);
+    }
+
+    lo[0] = w[0] & SC52_MASK;
+    lo[1] = ((w[0] >> 52) | (w[1] << 12)) & SC52_MASK;
+    lo[2] = ((w[1] >> 40) | (w[2] << 24)) & SC52_MASK;
+    lo[3] = ((w[2] >> 28) | (w[3] << 36)) & SC52_MASK;
+    lo[4] = ((w[3] >> 16) | (w[4] << 48)) & SC52_MASK;
+    hi[0] = (w[4] >> 4) & SC52_MASK;
+    hi[1] = ((w[4] >> 56) | (w[5] << 8)) & SC52_MASK;
+    hi[2] = ((w[5] >> 44) | (w[6] << 20)) & SC52_MASK;
+    hi[3] = ((w[6] >> 32) | (w[7] << 32)) & SC52_MASK;
+    hi[4] = w[7] >> 20;
+
+    sc52_reduce_wide(h, lo, hi);
+    sc52_tobytes(s, h);
+}
+
+
+
+/*
+Input:
+  a[0]+256*a[1]+...+256^31*a[31] = a
+  b[0]+256*b[1]+...+256^31*b[31] = b
+  c[0]+256*c[1]+...+256^31*c[31] = c
+
+Output:
+  s[0]+256*s[1]+...+256^31*s[31] = (ab+c) mod l
+  where l = 2^252 + 27742317777372353535851937790883648493.
+*/
+
+void sc_muladd(unsigned char *s, const unsigned char *a, const unsigned char *b, const unsigned char *c) {
+    sc52 fa;
+    sc52 fb;
+    sc52 fc;
+    sc52 lo;
+    sc52 hi;
+    sc52 h;
+    uint128_t z[9];
+    int i;
+
+    sc52_frombytes(fa, a);
+    sc52_frombytes(fb, b);
+    sc52_frombytes(fc, c);
+
+    /* ab + c < 2^512 */
+    sc52_mul_wide(z, fa, fb);
+
+    for (i = 0; i < 5; ++i) {
+        z[i] += fc[i];
+    }
+
+    /* carry into ten 52-bit limbs; the last one is z[8] >> 52 */
+    for (i = 0; i < 8; ++i) {
+        z[i + 1] += z[i] >> 52;
+        z[i] &= SC52_MASK;
+    }
+
+    for (i = 0; i < 5; ++i) {
+        lo[i] = (uint64_t) z[i];
+    }
+
+    for (i = 0; i < 4; ++i) {
+        hi[i] = (uint64_t) z[i + 5] & SC52_MASK;
+    }
+
+    hi[4] = (uint64_t) (z[8] >> 52);
+
+    sc52_reduce_wide(h, lo, hi);
+    sc52_tobytes(s, h);
+}
+
+#endif
@@ -4,15 +4,39 @@
 #include "sc.h"
 
 
-void ed25519_sign(unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key, const unsigned char *private_key) {
+/*
+    Clears secrets; the volatile stores are not optimized away.
+*/
+static void wipe(void *p, size_t len) {
+    volatile unsigned char *b = (volatile unsigned char *) p;
+
+    while (len--) {
+        *b++ = 0;
+    }
+}
+
+
+void ed25519_sign_ctx_init(ed25519_sign_ctx_t *ctx, const unsigned char *public_key, const unsigned char *private_key) {
+    int i;
+
+    for (i = 0; i < 32; ++i) {
+        ctx->scalar[i] = private_key[i];
+        ctx->public_key[i] = public_key[i];
+    }
+
+    sha3_init(&ctx->prefix_hash, 64);
+    sha3_update(&ctx->prefix_hash, private_key + 32, 32);
+}
+
+
+void ed25519_sign_ctx(unsigned char *signature, const unsigned char *message, size_t message_len, const ed25519_sign_ctx_t *ctx) {
     sha3_ctx_t hash;
     unsigned char hram[64];
     unsigned char r[64];
     ge_p3 R;
 
 
-    sha3_init(&hash, 64);
-    sha3_update(&hash, private_key + 32, 32);
+    sha3_copy(&hash, &ctx->prefix_hash);
     sha3_update(&hash, message, message_len);
     sha3_final(r, &hash);
 
@@ -22,10 +46,27 @@ void ed25519_sign(unsigned char *signature, const unsigned char *message, size_t
 
     sha3_init(&hash, 64);
     sha3_update(&hash, signature, 32);
-    sha3_update(&hash, public_key, 32);
+    sha3_update(&hash, ctx->public_key, 32);
     sha3_update(&hash, message, message_len);
     sha3_final(hram, &hash);
 
     sc_reduce(hram);
-    sc_muladd(signature + 32, hram, private_key, r);
+    sc_muladd(signature + 32, hram, ctx->scalar, r);
+
+    /* the nonce reveals the secret scalar */
+    wipe(r, sizeof(r));
+}
+
+
+void ed25519_sign_ctx_wipe(ed25519_sign_ctx_t *ctx) {
+    wipe(ctx, sizeof(*ctx));
+}
+
+
+void ed25519_sign(unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key, const unsigned char *private_key) {
+    ed25519_sign_ctx_t ctx;
+
+    ed25519_sign_ctx_init(&ctx, public_key, private_key);
+    ed25519_sign_ctx(signature, message, message_len, &ctx);
+    ed25519_sign_ctx_wipe(&ctx);
 }
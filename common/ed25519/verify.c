@@ -0,0 +1,236 @@
+#include "ed25519.h"
+#include "sha3/sha3.h"
+#include "ge.h"
+#include "sc.h"
+
+
+/* l = 2^252 + 27742317777372353535851937790883648493, little-endian */
+static const unsigned char group_order[32] = {
+    0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+    0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+/* each signature in a batch has two terms: -A times z h, and -R times z */
+typedef char batch_terms_fit_scratch[(2 * sizeof(ge_msm_term) <= ED25519_BATCH_SCRATCH_BYTES) ? 1 : -1];
+
+/* valid[] marker for signatures that are part of the current batch */
+#define BATCH_PENDING -1
+
+
+static int consttime_equal(const unsigned char *x, const unsigned char *y) {
+    unsigned char r = 0;
+    int i;
+
+    for (i = 0; i < 32; ++i) {
+        r |= x[i] ^ y[i];
+    }
+
+    return !r;
+}
+
+/*
+    returns 1 if s < l, so that S has a single valid encoding
+*/
+static int scalar_is_canonical(const unsigned char *s) {
+    int i;
+
+    for (i = 31; i >= 0; --i) {
+        if (s[i] != group_order[i]) {
+            return s[i] < group_order[i];
+        }
+    }
+
+    return 0;
+}
+
+/*
+    h = H(R || A || M) mod l, as in ed25519_sign
+*/
+static void hram(unsigned char *h, const unsigned char *signature, const unsigned char *public_key, const unsigned char *message, size_t message_len) {
+    sha3_ctx_t hash;
+
+    sha3_init(&hash, 64);
+    sha3_update(&hash, signature, 32);
+    sha3_update(&hash, public_key, 32);
+    sha3_update(&hash, message, message_len);
+    sha3_final(h, &hash);
+
+    sc_reduce(h);
+}
+
+static int p2_is_identity(const ge_p2 *p) {
+    fe t;
+
+    fe_sub(t, p->Y, p->Z);
+    return !fe_isnonzero(p->X) && !fe_isnonzero(t);
+}
+
+
+int ed25519_verify(const unsigned char *signature, const unsigned char *message, size_t message_len, const unsigned char *public_key) {
+    unsigned char h[64];
+    unsigned char checker[32];
+    ge_p3 A;
+    ge_p2 R;
+
+    if (!scalar_is_canonical(signature + 32)) {
+        return 0;
+    }
+
+    if (ge_frombytes_negate_vartime(&A, public_key) != 0) {
+        return 0;
+    }
+
+    hram(h, signature, public_key, message, message_len);
+    ge_double_scalarmult_vartime(&R, h, &A, signature + 32);
+    ge_tobytes(checker, &R);
+
+    return consttime_equal(checker, signature);
+}
+
+
+/*
+    Verifies up to one scratch-full of signatures with a single multi-scalar
+    multiplication:
+
+      [sum z_i S_i] B + sum [z_i h_i] (-A_i) + sum [z_i] (-R_i) == 0
+
+    The z_i are 128-bit and odd, derived by hashing every signature, key and
+    h_i in the batch, so they are fixed only once all the inputs are. If the
+    batch does not check out, its signatures are verified one by one.
+*/
+static int verify_batch_chunk(const unsigned char *const *signatures, const unsigned char *const *messages, const size_t *message_lens, const unsigned char *const *public_keys, size_t count, int *valid, ge_msm_term *terms) {
+    static const unsigned char zero[32] = { 0 };
+    sha3_ctx_t hash;
+    unsigned char seed[64];
+    unsigned char h[64];
+    unsigned char z[64];
+    unsigned char b[32] = { 0 };
+    unsigned char encoding[32];
+    uint64_t index;
+    ge_p2 check;
+    size_t batched = 0;
+    size_t i;
+    int j;
+    int batch_valid;
+    int all_valid = 1;
+
+    sha3_init(&hash, 64);
+
+    for (i = 0; i < count; ++i) {
+        ge_msm_term *a_term = &terms[2 * batched];
+        ge_msm_term *r_term = &terms[2 * batched + 1];
+        const unsigned char *signature = signatures[i];
+
+        valid[i] = 0;
+
+        if (!scalar_is_canonical(signature + 32)) {
+            continue;
+        }
+
+        if (ge_frombytes_negate_vartime(&a_term->point, public_keys[i]) != 0) {
+            continue;
+        }
+
+        /* ed25519_verify only matches the canonical encoding of R */
+        if (ge_frombytes_negate_vartime(&r_term->point, signature) != 0) {
+            continue;
+        }
+
+        ge_p3_tobytes(encoding, &r_term->point);
+
+        if (fe_isnonzero(r_term->point.X)) {
+            encoding[31] ^= 0x80;
+        }
+
+        if (!consttime_equal(encoding, signature)) {
+            continue;
+        }
+
+        hram(h, signature, public_keys[i], messages[i], message_lens[i]);
+
+        for (j = 0; j < 32; ++j) {
+            a_term->scalar[j] = h[j];
+        }
+
+        sha3_update(&hash, signature, 64);
+        sha3_update(&hash, public_keys[i], 32);
+        sha3_update(&hash, h, 32);
+
+        valid[i] = BATCH_PENDING;
+        ++batched;
+    }
+
+    if (batched == 0) {
+        return 0;
+    }
+
+    sha3_final(seed, &hash);
+
+    for (i = 0, index = 0; i < count; ++i) {
+        ge_msm_term *a_term = &terms[2 * index];
+        ge_msm_term *r_term = &terms[2 * index + 1];
+
+        if (valid[i] != BATCH_PENDING) {
+            continue;
+        }
+
+        sha3_init(&hash, 64);
+        sha3_update(&hash, seed, 64);
+        sha3_update(&hash, &index, sizeof(index));
+        sha3_final(z, &hash);
+        z[0] |= 1;
+
+        for (j = 16; j < 32; ++j) {
+            z[j] = 0;
+        }
+
+        sc_muladd(a_term->scalar, z, a_term->scalar, zero);
+
+        for (j = 0; j < 32; ++j) {
+            r_term->scalar[j] = z[j];
+        }
+
+        sc_muladd(b, z, signatures[i] + 32, b);
+        ++index;
+    }
+
+    ge_multi_scalarmult_vartime(&check, b, terms, 2 * batched);
+    batch_valid = p2_is_identity(&check);
+
+    for (i = 0; i < count; ++i) {
+        if (valid[i] == BATCH_PENDING) {
+            valid[i] = batch_valid || ed25519_verify(signatures[i], messages[i], message_lens[i], public_keys[i]);
+        }
+
+        all_valid &= valid[i];
+    }
+
+    return all_valid;
+}
+
+
+int ed25519_verify_batch(const unsigned char *const *signatures, const unsigned char *const *messages, const size_t *message_lens, const unsigned char *const *public_keys, size_t count, int *valid, void *scratch, size_t scratch_size) {
+    size_t chunk = scratch_size / ED25519_BATCH_SCRATCH_BYTES;
+    size_t start;
+    size_t n;
+    int all_valid = 1;
+
+    /* a batch of one is no faster than ed25519_verify */
+    if (chunk < 2) {
+        for (start = 0; start < count; ++start) {
+            valid[start] = ed25519_verify(signatures[start], messages[start], message_lens[start], public_keys[start]);
+            all_valid &= valid[start];
+        }
+
+        return all_valid;
+    }
+
+    for (start = 0; start < count; start += n) {
+        n = (count - start < chunk) ? count - start : chunk;
+        all_valid &= verify_batch_chunk(signatures + start, messages + start, message_lens + start, public_keys + start, n, valid + start, (ge_msm_term *) scratch);
+    }
+
+    return all_valid;
+}
@@ -0,0 +1,140 @@
+#include "ed25519.h"
+#include "fe.h"
+#include "ge.h"
+
+
+/*
+    The clamped scalar of RFC 7748, as in ed25519_create_keypair.
+*/
+static void clamp(unsigned char *e, const unsigned char *private_key) {
+    int i;
+
+    for (i = 0; i < 32; ++i) {
+        e[i] = private_key[i];
+    }
+
+    e[0] &= 248;
+    e[31] &= 127;
+    e[31] |= 64;
+}
+
+static void wipe(void *buf, size_t len) {
+    volatile unsigned char *p = (volatile unsigned char *) buf;
+
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+/*
+    returns 1 unless all 32 bytes are zero
+*/
+static int is_nonzero(const unsigned char *s) {
+    unsigned char r = 0;
+    int i;
+
+    for (i = 0; i < 32; ++i) {
+        r |= s[i];
+    }
+
+    return r != 0;
+}
+
+
+/*
+    shared_secret = X25519(private_key, public_key), with the Montgomery ladder
+    of RFC 7748. The top bit of public_key is ignored.
+
+    Returns 0 if the result is all zeros, which happens when public_key has
+    small order; the caller must not use such a shared secret.
+*/
+
+int x25519(unsigned char *shared_secret, const unsigned char *private_key, const unsigned char *public_key) {
+    unsigned char e[32];
+    unsigned int swap;
+    unsigned int b;
+    int pos;
+    fe x1;
+    fe x2;
+    fe z2;
+    fe x3;
+    fe z3;
+    fe tmp0;
+    fe tmp1;
+
+    clamp(e, private_key);
+    fe_frombytes(x1, public_key);
+    fe_1(x2);
+    fe_0(z2);
+    fe_copy(x3, x1);
+    fe_1(z3);
+
+    swap = 0;
+
+    for (pos = 254; pos >= 0; --pos) {
+        b = e[pos / 8] >> (pos & 7);
+        b &= 1;
+        swap ^= b;
+        fe_cswap(x2, x3, swap);
+        fe_cswap(z2, z3, swap);
+        swap = b;
+
+        fe_sub(tmp0, x3, z3);
+        fe_sub(tmp1, x2, z2);
+        fe_add(x2, x2, z2);
+        fe_add(z2, x3, z3);
+        fe_mul(z3, tmp0, x2);
+        fe_mul(z2, z2, tmp1);
+        fe_sq(tmp0, tmp1);
+        fe_sq(tmp1, x2);
+        fe_add(x3, z3, z2);
+        fe_sub(z2, z3, z2);
+        fe_mul(x2, tmp1, tmp0);
+        fe_sub(tmp1, tmp1, tmp0);
+        fe_sq(z2, z2);
+        fe_mul121666(z3, tmp1);
+        fe_sq(x3, x3);
+        fe_add(tmp0, tmp0, z3);
+        fe_mul(z3, x1, z2);
+        fe_mul(z2, tmp1, tmp0);
+    }
+
+    fe_cswap(x2, x3, swap);
+    fe_cswap(z2, z3, swap);
+
+    fe_invert(z2, z2);
+    fe_mul(x2, x2, z2);
+    fe_tobytes(shared_secret, x2);
+
+    wipe(e, sizeof(e));
+    wipe(x2, sizeof(fe));
+    wipe(x3, sizeof(fe));
+
+    return is_nonzero(shared_secret);
+}
+
+
+/*
+    public_key = X25519(private_key, 9)
+
+    This uses the Edwards fixed-base table: the Montgomery u coordinate of the
+    Edwards point (x, y) is (1 + y) / (1 - y).
+*/
+
+void x25519_public_key(unsigned char *public_key, const unsigned char *private_key) {
+    unsigned char e[32];
+    ge_p3 A;
+    fe u;
+    fe t;
+
+    clamp(e, private_key);
+    ge_scalarmult_base(&A, e);
+
+    fe_add(u, A.Z, A.Y);
+    fe_sub(t, A.Z, A.Y);
+    fe_invert(t, t);
+    fe_mul(u, u, t);
+    fe_tobytes(public_key, u);
+
+    wipe(e, sizeof(e));
+}
@@ -0,0 +1,82 @@
+#ifndef IMAGE_MANIFEST_H
+#define IMAGE_MANIFEST_H
+
+#include <stdint.h>
+
+// Manifests describe which bytes of a boot image are measured.
+//
+// A boot image is made of loaded segments, whose bytes are hashed, and
+// zero-fill segments (.bss), which are measured by length only: the manifest
+// is part of the measurement, and the measuring stage zeroes them instead of
+// hashing them. Manifests are emitted by the linker scripts.
+//
+// This is shared by the ROT, the bootloader and the host measurement tool.
+
+// The bootloader's manifest (see bootloader/bootloader.lds.in).
+//
+// It lives at bootloader_ptr + BOOTLOADER_MANIFEST_OFFSET, right after the
+// entry jump table, so it is inside the loaded bytes it describes. The ROT
+// hashes the first loaded_size bytes of the bootloader segment and zeroes the
+// zero_size bytes that follow.
+#define BOOTLOADER_MANIFEST_OFFSET 8
+
+typedef struct {
+  uint64_t loaded_size;
+  uint64_t zero_size;
+} bootloader_manifest_t;
+
+// The SM's manifest (the .sm_manifest section in sm/sm.lds.in).
+//
+// The segments tile the SM image in order, starting at sm_ptr.
+
+#define MANIFEST_SEGMENT_LOADED 0
+#define MANIFEST_SEGMENT_ZERO   1
+
+#define SM_MANIFEST_MAX_SEGMENTS 8
+
+typedef struct {
+  uint64_t length;
+  uint64_t kind;        // MANIFEST_SEGMENT_*
+} manifest_segment_t;
+
+typedef struct {
+  uint64_t segment_count;
+  manifest_segment_t segments[SM_MANIFEST_MAX_SEGMENTS];
+} sm_manifest_t;
+
+// Returns non-zero if the manifest tiles exactly image_size bytes.
+static inline int sm_manifest_is_valid(const sm_manifest_t* manifest,
+    uint64_t image_size) {
+  uint64_t total = 0;
+
+  if (manifest->segment_count == 0 ||
+      manifest->segment_count > SM_MANIFEST_MAX_SEGMENTS) {
+    return 0;
+  }
+  for (uint64_t i = 0; i < manifest->segment_count; i++) {
+    const manifest_segment_t* segment = &manifest->segments[i];
+    if (segment->kind != MANIFEST_SEGMENT_LOADED &&
+        segment->kind != MANIFEST_SEGMENT_ZERO) {
+      return 0;
+    }
+    if (segment->length > image_size - total) {
+      return 0;
+    }
+    total += segment->length;
+  }
+  return total == image_size;
+}
+
+// Builds the manifest that measures a whole image as one loaded segment.
+static inline void sm_manifest_whole_image(sm_manifest_t* manifest,
+    uint64_t image_size) {
+  manifest->segment_count = 1;
+  manifest->segments[0].length = image_size;
+  manifest->segments[0].kind = MANIFEST_SEGMENT_LOADED;
+  for (int i = 1; i < SM_MANIFEST_MAX_SEGMENTS; i++) {
+    manifest->segments[i].length = 0;
+    manifest->segments[i].kind = 0;
+  }
+}
+
+#endif
@@ -6,36 +6,163 @@
 
 #include "sha3.h"
 
+#if KECCAKF_ROUNDS % 2 != 0
+#error "sha3_keccakf runs two rounds per iteration; KECCAKF_ROUNDS must be even"
+#endif
+
+// round constants
+
+static const uint64_t keccakf_rndc[24] = {
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+    0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+    0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+    0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+    0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+    0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+    0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+};
+
+// With the Zbb or Zbkb extension, andn computes ~x & y in one instruction and
+// rotations compile to rori, so Chi is evaluated as specified. Without them,
+// the state is kept in the "lane complementing" representation: lanes be, bi,
+// go, ki, mi and sa are stored inverted, which removes most of the NOTs from
+// Chi.
+
+#ifndef KECCAKF_LANE_COMPLEMENTING
+#if defined(__riscv_zbb) || defined(__riscv_zbkb)
+#define KECCAKF_LANE_COMPLEMENTING 0
+#else
+#define KECCAKF_LANE_COMPLEMENTING 1
+#endif
+#endif
+
+#if KECCAKF_LANE_COMPLEMENTING
+
+#define KECCAKF_CHI_B(E, rc) \
+    E##ba = B0 ^ (B1 | B2) ^ (rc); \
+    E##be = B1 ^ (~B2 | B3); \
+    E##bi = B2 ^ (B3 & B4); \
+    E##bo = B3 ^ (B4 | B0); \
+    E##bu = B4 ^ (B0 & B1);
+#define KECCAKF_CHI_G(E) \
+    E##ga = B0 ^ (B1 | B2); \
+    E##ge = B1 ^ (B2 & B3); \
+    E##gi = B2 ^ (B3 | ~B4); \
+    E##go = B3 ^ (B4 | B0); \
+    E##gu = B4 ^ (B0 & B1);
+#define KECCAKF_CHI_K(E) \
+    E##ka = B0 ^ (B1 | B2); \
+    E##ke = B1 ^ (B2 & B3); \
+    E##ki = B2 ^ (~B3 & B4); \
+    E##ko = ~B3 ^ (B4 | B0); \
+    E##ku = B4 ^ (B0 & B1);
+#define KECCAKF_CHI_M(E) \
+    E##ma = B0 ^ (B1 & B2); \
+    E##me = B1 ^ (B2 | B3); \
+    E##mi = B2 ^ (~B3 | B4); \
+    E##mo = ~B3 ^ (B4 & B0); \
+    E##mu = B4 ^ (B0 | B1);
+#define KECCAKF_CHI_S(E) \
+    E##sa = B0 ^ (~B1 & B2); \
+    E##se = ~B1 ^ (B2 | B3); \
+    E##si = B2 ^ (B3 & B4); \
+    E##so = B3 ^ (B4 | B0); \
+    E##su = B4 ^ (B0 & B1);
+
+// lanes stored inverted
+#define LC(x) (~(x))
+
+#else
+
+// one andn per lane
+#define KECCAKF_CHI(E, row, rc) \
+    E##row##a = B0 ^ (~B1 & B2) ^ (rc); \
+    E##row##e = B1 ^ (~B2 & B3); \
+    E##row##i = B2 ^ (~B3 & B4); \
+    E##row##o = B3 ^ (~B4 & B0); \
+    E##row##u = B4 ^ (~B0 & B1);
+#define KECCAKF_CHI_B(E, rc)    KECCAKF_CHI(E, b, rc)
+#define KECCAKF_CHI_G(E)        KECCAKF_CHI(E, g, 0)
+#define KECCAKF_CHI_K(E)        KECCAKF_CHI(E, k, 0)
+#define KECCAKF_CHI_M(E)        KECCAKF_CHI(E, m, 0)
+#define KECCAKF_CHI_S(E)        KECCAKF_CHI(E, s, 0)
+
+#define LC(x) (x)
+
+#endif
+
+// One unrolled round, reading lanes A## and writing lanes E##.
+//
+// Lanes are named by row (b, g, k, m, s) and column (a, e, i, o, u), so that
+// st[x + 5 * y] is the lane in row y, column x.
+
+#define KECCAKF_ROUND(A, E, rc) \
+    Ca = A##ba ^ A##ga ^ A##ka ^ A##ma ^ A##sa; \
+    Ce = A##be ^ A##ge ^ A##ke ^ A##me ^ A##se; \
+    Ci = A##bi ^ A##gi ^ A##ki ^ A##mi ^ A##si; \
+    Co = A##bo ^ A##go ^ A##ko ^ A##mo ^ A##so; \
+    Cu = A##bu ^ A##gu ^ A##ku ^ A##mu ^ A##su; \
+    Da = Cu ^ ROTL64(Ce, 1); \
+    De = Ca ^ ROTL64(Ci, 1); \
+    Di = Ce ^ ROTL64(Co, 1); \
+    Do = Ci ^ ROTL64(Cu, 1); \
+    Du = Co ^ ROTL64(Ca, 1); \
+    \
+    B0 = A##ba ^ Da; \
+    B1 = ROTL64(A##ge ^ De, 44); \
+    B2 = ROTL64(A##ki ^ Di, 43); \
+    B3 = ROTL64(A##mo ^ Do, 21); \
+    B4 = ROTL64(A##su ^ Du, 14); \
+    KECCAKF_CHI_B(E, rc) \
+    \
+    B0 = ROTL64(A##bo ^ Do, 28); \
+    B1 = ROTL64(A##gu ^ Du, 20); \
+    B2 = ROTL64(A##ka ^ Da, 3); \
+    B3 = ROTL64(A##me ^ De, 45); \
+    B4 = ROTL64(A##si ^ Di, 61); \
+    KECCAKF_CHI_G(E) \
+    \
+    B0 = ROTL64(A##be ^ De, 1); \
+    B1 = ROTL64(A##gi ^ Di, 6); \
+    B2 = ROTL64(A##ko ^ Do, 25); \
+    B3 = ROTL64(A##mu ^ Du, 8); \
+    B4 = ROTL64(A##sa ^ Da, 18); \
+    KECCAKF_CHI_K(E) \
+    \
+    B0 = ROTL64(A##bu ^ Du, 27); \
+    B1 = ROTL64(A##ga ^ Da, 36); \
+    B2 = ROTL64(A##ke ^ De, 10); \
+    B3 = ROTL64(A##mi ^ Di, 15); \
+    B4 = ROTL64(A##so ^ Do, 56); \
+    KECCAKF_CHI_M(E) \
+    \
+    B0 = ROTL64(A##bi ^ Di, 62); \
+    B1 = ROTL64(A##go ^ Do, 55); \
+    B2 = ROTL64(A##ku ^ Du, 39); \
+    B3 = ROTL64(A##ma ^ Da, 41); \
+    B4 = ROTL64(A##se ^ De, 2); \
+    KECCAKF_CHI_S(E)
+
 // update the state with given number of rounds
 
 void sha3_keccakf(uint64_t st[25])
 {
-    // constants
-    const uint64_t keccakf_rndc[24] = {
-        0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
-        0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
-        0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
-        0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
-        0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
-        0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
-        0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
-        0x8000000000008080, 0x0000000080000001, 0x8000000080008008
-    };
-    const int keccakf_rotc[24] = {
-        1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14,
-        27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44
-    };
-    const int keccakf_piln[24] = {
-        10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4,
-        15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1
-    };
-
     // variables
-    int i, j, r;
-    uint64_t t, bc[5];
+    int r;
+    uint64_t Aba, Abe, Abi, Abo, Abu, Aga, Age, Agi, Ago, Agu,
+        Aka, Ake, Aki, Ako, Aku, Ama, Ame, Ami, Amo, Amu,
+        Asa, Ase, Asi, Aso, Asu;
+    uint64_t Eba, Ebe, Ebi, Ebo, Ebu, Ega, Ege, Egi, Ego, Egu,
+        Eka, Eke, Eki, Eko, Eku, Ema, Eme, Emi, Emo, Emu,
+        Esa, Ese, Esi, Eso, Esu;
+    uint64_t Ca, Ce, Ci, Co, Cu, Da, De, Di, Do, Du;
+    uint64_t B0, B1, B2, B3, B4;
 
 #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    int i;
     uint8_t *v;
+    uint64_t t;
 
     // endianess conversion. this is redundant on little-endian targets
     for (i = 0; i < 25; i++) {
@@ -47,40 +174,31 @@ void sha3_keccakf(uint64_t st[25])
     }
 #endif
 
-    // actual iteration
-    for (r = 0; r < KECCAKF_ROUNDS; r++) {
-
-        // Theta
-        for (i = 0; i < 5; i++)
-            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
-
-        for (i = 0; i < 5; i++) {
-            t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
-            for (j = 0; j < 25; j += 5)
-                st[j + i] ^= t;
-        }
-
-        // Rho Pi
-        t = st[1];
-        for (i = 0; i < 24; i++) {
-            j = keccakf_piln[i];
-            bc[0] = st[j];
-            st[j] = ROTL64(t, keccakf_rotc[i]);
-            t = bc[0];
-        }
-
-        //  Chi
-        for (j = 0; j < 25; j += 5) {
-            for (i = 0; i < 5; i++)
-                bc[i] = st[j + i];
-            for (i = 0; i < 5; i++)
-                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
-        }
-
-        //  Iota
-        st[0] ^= keccakf_rndc[r];
+    // load the state, complementing lanes on the way in
+    Aba = st[0];      Abe = LC(st[1]);  Abi = LC(st[2]);  Abo = st[3];
+    Abu = st[4];      Aga = st[5];      Age = st[6];      Agi = st[7];
+    Ago = LC(st[8]);  Agu = st[9];      Aka = st[10];     Ake = st[11];
+    Aki = LC(st[12]); Ako = st[13];     Aku = st[14];     Ama = st[15];
+    Ame = st[16];     Ami = LC(st[17]); Amo = st[18];     Amu = st[19];
+    Asa = LC(st[20]); Ase = st[21];     Asi = st[22];     Aso = st[23];
+    Asu = st[24];
+
+    // actual iteration, two rounds at a time so the lanes ping-pong between
+    // the A and E register sets without copies
+    for (r = 0; r < KECCAKF_ROUNDS; r += 2) {
+        KECCAKF_ROUND(A, E, keccakf_rndc[r])
+        KECCAKF_ROUND(E, A, keccakf_rndc[r + 1])
     }
 
+    // store the state, undoing the lane complementing
+    st[0]  = Aba;     st[1]  = LC(Abe); st[2]  = LC(Abi); st[3]  = Abo;
+    st[4]  = Abu;     st[5]  = Aga;     st[6]  = Age;     st[7]  = Agi;
+    st[8]  = LC(Ago); st[9]  = Agu;     st[10] = Aka;     st[11] = Ake;
+    st[12] = LC(Aki); st[13] = Ako;     st[14] = Aku;     st[15] = Ama;
+    st[16] = Ame;     st[17] = LC(Ami); st[18] = Amo;     st[19] = Amu;
+    st[20] = LC(Asa); st[21] = Ase;     st[22] = Asi;     st[23] = Aso;
+    st[24] = Asu;
+
 #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
     // endianess conversion. this is redundant on little-endian targets
     for (i = 0; i < 25; i++) {
@@ -118,10 +236,36 @@ int sha3_init(sha3_ctx_t *c, int mdlen)
 int sha3_update(sha3_ctx_t *c, const void *data, size_t len)
 {
     size_t i;
-    int j;
+    int j, k;
+    const uint64_t *q;
 
+    i = 0;
     j = c->pt;
-    for (i = 0; i < len; i++) {
+
+    // top up a partially absorbed block
+    for (; j != 0 && i < len; i++) {
+        c->st.b[j++] ^= ((const uint8_t *) data)[i];
+        if (j >= c->rsiz) {
+            sha3_keccakf(c->st.q);
+            j = 0;
+        }
+    }
+
+    // fast path: whole rate blocks of 64-bit aligned input are absorbed a
+    // lane at a time. XOR commutes with byte order, so this is also correct
+    // on big-endian targets.
+    if ((((uintptr_t) data + i) & 7) == 0) {
+        while (len - i >= (size_t) c->rsiz) {
+            q = (const uint64_t *) ((const uint8_t *) data + i);
+            for (k = 0; k < c->rsiz / 8; k++)
+                c->st.q[k] ^= q[k];
+            sha3_keccakf(c->st.q);
+            i += c->rsiz;
+        }
+    }
+
+    // buffer the tail
+    for (; i < len; i++) {
         c->st.b[j++] ^= ((const uint8_t *) data)[i];
         if (j >= c->rsiz) {
             sha3_keccakf(c->st.q);
@@ -133,6 +277,19 @@ int sha3_update(sha3_ctx_t *c, const void *data, size_t len)
     return 1;
 }
 
+// copy a context: the copy can be updated and finalized independently
+
+void sha3_copy(sha3_ctx_t *dst, const sha3_ctx_t *src)
+{
+    int i;
+
+    for (i = 0; i < 25; i++)
+        dst->st.q[i] = src->st.q[i];
+    dst->pt = src->pt;
+    dst->rsiz = src->rsiz;
+    dst->mdlen = src->mdlen;
+}
+
 // finalize and output a hash
 
 int sha3_final(void *md, sha3_ctx_t *c)
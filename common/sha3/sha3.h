@@ -32,8 +32,40 @@ int sha3_init(sha3_ctx_t *c, int mdlen);    // mdlen = hash output in bytes
 int sha3_update(sha3_ctx_t *c, const void *data, size_t len);
 int sha3_final(void *md, sha3_ctx_t *c);    // digest goes to md
 
+// snapshot a context, e.g. after a common prefix; both copies stay usable
+void sha3_copy(sha3_ctx_t *dst, const sha3_ctx_t *src);
+
 // compute a sha3 hash (md) of given byte length from "in"
 void *sha3(const void *in, size_t inlen, void *md, int mdlen);
 
+// Multi-buffer interface: up to SHA3_MULTI_WAYS independent streams share
+// one interleaved permutation whenever several of them fill a rate block at
+// the same time. Digests are identical to hashing each stream with sha3().
+
+#ifndef SHA3_MULTI_WAYS
+#define SHA3_MULTI_WAYS 4
+#endif
+
+typedef struct {
+    sha3_ctx_t ctx[SHA3_MULTI_WAYS];        // one context per stream
+    int n;                                  // number of streams in use
+} sha3_multi_ctx_t;
+
+// Compression function for 2 and 4 interleaved states.
+void sha3_keccakf_x2(uint64_t *st0, uint64_t *st1);
+void sha3_keccakf_x4(uint64_t *st0, uint64_t *st1, uint64_t *st2,
+    uint64_t *st3);
+
+// n = number of streams (1 .. SHA3_MULTI_WAYS), all with the same mdlen
+int sha3_multi_init(sha3_multi_ctx_t *c, int n, int mdlen);
+// data[i], len[i] are appended to stream i; len[i] may be 0
+int sha3_multi_update(sha3_multi_ctx_t *c, const void *const data[],
+    const size_t len[]);
+int sha3_multi_final(void *const md[], sha3_multi_ctx_t *c);
+
+// compute n sha3 hashes (md[i]) of given byte length from "in[i]"
+void sha3_multi(const void *const in[], const size_t inlen[],
+    void *const md[], int n, int mdlen);
+
 #endif
 
@@ -0,0 +1,264 @@
+// sha3_multi.c
+// Multi-buffer SHA-3 built on top of sha3.c
+
+// Keccak-f[1600] has a long serial dependency chain per round, so a single
+// stream leaves most of an in-order RV64 pipeline idle. Here several
+// independent states are permuted together, with the state stored lane-major
+// (lane, then stream) so that every step issues one independent operation
+// per stream back to back.
+
+#include "sha3.h"
+
+static const int keccakf_rotc[25] = {
+    0,  1,  62, 28, 27,
+    36, 44, 6,  55, 20,
+    3,  10, 43, 25, 39,
+    41, 45, 15, 21, 8,
+    18, 2,  61, 56, 14
+};
+
+// destination of lane i under Pi: (x, y) -> (y, 2x + 3y)
+static const int keccakf_pidst[25] = {
+    0,  10, 20, 5,  15,
+    16, 1,  11, 21, 6,
+    7,  17, 2,  12, 22,
+    23, 8,  18, 3,  13,
+    14, 24, 9,  19, 4
+};
+
+static const int keccakf_next[5] = { 1, 2, 3, 4, 0 };
+static const int keccakf_prev[5] = { 4, 0, 1, 2, 3 };
+
+static const uint64_t keccakf_rndc[24] = {
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808a,
+    0x8000000080008000, 0x000000000000808b, 0x0000000080000001,
+    0x8000000080008081, 0x8000000000008009, 0x000000000000008a,
+    0x0000000000000088, 0x0000000080008009, 0x000000008000000a,
+    0x000000008000808b, 0x800000000000008b, 0x8000000000008089,
+    0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800a, 0x800000008000000a, 0x8000000080008081,
+    0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+};
+
+// permute "ways" interleaved states; callers pass a constant so that the
+// inner loops are fully unrolled
+
+static inline void keccakf_interleaved(uint64_t st[25][SHA3_MULTI_WAYS],
+    const int ways)
+{
+    int i, j, r, w;
+    uint64_t bc[25][SHA3_MULTI_WAYS], t;
+
+    for (r = 0; r < KECCAKF_ROUNDS; r++) {
+
+        // Theta
+        for (i = 0; i < 5; i++)
+            for (w = 0; w < ways; w++)
+                bc[i][w] = st[i][w] ^ st[i + 5][w] ^ st[i + 10][w] ^
+                    st[i + 15][w] ^ st[i + 20][w];
+
+        for (i = 0; i < 5; i++) {
+            for (w = 0; w < ways; w++) {
+                t = bc[keccakf_prev[i]][w] ^
+                    ROTL64(bc[keccakf_next[i]][w], 1);
+                for (j = 0; j < 25; j += 5)
+                    st[j + i][w] ^= t;
+            }
+        }
+
+        // Rho Pi
+        for (w = 0; w < ways; w++)
+            bc[0][w] = st[0][w];
+        for (i = 1; i < 25; i++)
+            for (w = 0; w < ways; w++)
+                bc[keccakf_pidst[i]][w] = ROTL64(st[i][w], keccakf_rotc[i]);
+
+        //  Chi
+        for (j = 0; j < 25; j += 5)
+            for (i = 0; i < 5; i++)
+                for (w = 0; w < ways; w++)
+                    st[j + i][w] = bc[j + i][w] ^
+                        ((~bc[j + keccakf_next[i]][w]) &
+                        bc[j + keccakf_next[keccakf_next[i]]][w]);
+
+        //  Iota
+        for (w = 0; w < ways; w++)
+            st[0][w] ^= keccakf_rndc[r];
+    }
+}
+
+// gather / scatter between per-stream states and the interleaved layout
+
+static inline void keccakf_gather(uint64_t st[25][SHA3_MULTI_WAYS],
+    uint64_t *const s[], const int ways)
+{
+    int i, w;
+
+    for (i = 0; i < 25; i++)
+        for (w = 0; w < ways; w++)
+            st[i][w] = s[w][i];
+}
+
+static inline void keccakf_scatter(uint64_t *const s[],
+    uint64_t st[25][SHA3_MULTI_WAYS], const int ways)
+{
+    int i, w;
+
+    for (i = 0; i < 25; i++)
+        for (w = 0; w < ways; w++)
+            s[w][i] = st[i][w];
+}
+
+void sha3_keccakf_x2(uint64_t *st0, uint64_t *st1)
+{
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    // lanes are stored little-endian; let sha3_keccakf() convert them
+    sha3_keccakf(st0);
+    sha3_keccakf(st1);
+#else
+    uint64_t *const s[2] = { st0, st1 };
+    uint64_t st[25][SHA3_MULTI_WAYS];
+
+    keccakf_gather(st, s, 2);
+    keccakf_interleaved(st, 2);
+    keccakf_scatter(s, st, 2);
+#endif
+}
+
+void sha3_keccakf_x4(uint64_t *st0, uint64_t *st1, uint64_t *st2,
+    uint64_t *st3)
+{
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__ || SHA3_MULTI_WAYS < 4
+    sha3_keccakf_x2(st0, st1);
+    sha3_keccakf_x2(st2, st3);
+#else
+    uint64_t *const s[4] = { st0, st1, st2, st3 };
+    uint64_t st[25][SHA3_MULTI_WAYS];
+
+    keccakf_gather(st, s, 4);
+    keccakf_interleaved(st, 4);
+    keccakf_scatter(s, st, 4);
+#endif
+}
+
+// permute the states of the streams whose bit is set in "mask", sharing
+// interleaved permutations as much as possible
+
+static void sha3_multi_permute(sha3_multi_ctx_t *c, unsigned mask)
+{
+    uint64_t *s[SHA3_MULTI_WAYS];
+    int i, k;
+
+    k = 0;
+    for (i = 0; i < c->n; i++) {
+        if (mask & (1u << i)) {
+            s[k++] = c->ctx[i].st.q;
+            c->ctx[i].pt = 0;
+        }
+    }
+
+    i = 0;
+    for (; k - i >= 4; i += 4)
+        sha3_keccakf_x4(s[i], s[i + 1], s[i + 2], s[i + 3]);
+    for (; k - i >= 2; i += 2)
+        sha3_keccakf_x2(s[i], s[i + 1]);
+    if (i < k)
+        sha3_keccakf(s[i]);
+}
+
+// Initialize the contexts for n streams
+
+int sha3_multi_init(sha3_multi_ctx_t *c, int n, int mdlen)
+{
+    int i;
+
+    if (n < 1 || n > SHA3_MULTI_WAYS)
+        return 0;
+
+    for (i = 0; i < n; i++)
+        sha3_init(&c->ctx[i], mdlen);
+    c->n = n;
+
+    return 1;
+}
+
+// update the states with more data. A stream whose rate block fills up waits
+// (with pt == rsiz) until every other stream has either filled its own block
+// or run out of input, and then all full blocks are permuted together.
+
+int sha3_multi_update(sha3_multi_ctx_t *c, const void *const data[],
+    const size_t len[])
+{
+    size_t pos[SHA3_MULTI_WAYS];
+    const uint8_t *in;
+    const uint64_t *q;
+    sha3_ctx_t *s;
+    unsigned mask;
+    int i, k;
+
+    for (i = 0; i < c->n; i++)
+        pos[i] = 0;
+
+    do {
+        mask = 0;
+        for (i = 0; i < c->n; i++) {
+            s = &c->ctx[i];
+            in = (const uint8_t *) data[i];
+
+            if (s->pt == 0 && len[i] - pos[i] >= (size_t) s->rsiz &&
+                (((uintptr_t) in + pos[i]) & 7) == 0) {
+                // whole aligned block, absorbed a lane at a time
+                q = (const uint64_t *) (in + pos[i]);
+                for (k = 0; k < s->rsiz / 8; k++)
+                    s->st.q[k] ^= q[k];
+                s->pt = s->rsiz;
+                pos[i] += s->rsiz;
+            } else {
+                while (s->pt < s->rsiz && pos[i] < len[i])
+                    s->st.b[s->pt++] ^= in[pos[i]++];
+            }
+
+            if (s->pt == s->rsiz)
+                mask |= 1u << i;
+        }
+        if (mask != 0)
+            sha3_multi_permute(c, mask);
+    } while (mask != 0);
+
+    return 1;
+}
+
+// finalize and output the hashes
+
+int sha3_multi_final(void *const md[], sha3_multi_ctx_t *c)
+{
+    sha3_ctx_t *s;
+    int i, j;
+
+    for (i = 0; i < c->n; i++) {
+        s = &c->ctx[i];
+        s->st.b[s->pt] ^= 0x06;
+        s->st.b[s->rsiz - 1] ^= 0x80;
+    }
+    sha3_multi_permute(c, (1u << c->n) - 1);
+
+    for (i = 0; i < c->n; i++) {
+        s = &c->ctx[i];
+        for (j = 0; j < s->mdlen; j++)
+            ((uint8_t *) md[i])[j] = s->st.b[j];
+    }
+
+    return 1;
+}
+
+// compute n SHA-3 hashes (md[i]) of given byte length from "in[i]"
+
+void sha3_multi(const void *const in[], const size_t inlen[],
+    void *const md[], int n, int mdlen)
+{
+    sha3_multi_ctx_t c;
+
+    sha3_multi_init(&c, n, mdlen);
+    sha3_multi_update(&c, in, inlen);
+    sha3_multi_final(md, &c);
+}
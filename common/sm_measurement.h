@@ -0,0 +1,133 @@
+#ifndef SM_MEASUREMENT_H
+#define SM_MEASUREMENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "image_manifest.h"
+#include "sha3/sha3.h"
+
+// Measurement of the SM.
+//
+// Only the loaded segments listed in the SM's manifest are hashed; zero-fill
+// segments are covered by the manifest itself, and zeroed by the bootloader.
+// The loaded segments, concatenated in order, form the measured stream.
+//
+// SM_MEASUREMENT_SERIAL: SM_H is the SHA3-512 of the manifest followed by the
+// measured stream.
+//
+// SM_MEASUREMENT_TREE: the measured stream is split into leaf_size-byte leaves
+// (the last one may be short), and each leaf is hashed with SHA3-512. SM_H is
+// the SHA3-512 of a sm_tree_header_t, the manifest, and the leaf digests in
+// stream order.
+//
+// A manifest that does not tile the SM image exactly is replaced by one that
+// covers the whole image with a single loaded segment.
+//
+// This is shared by the bootloader and the host measurement tool.
+
+typedef struct {
+  uint64_t mode;        // SM_MEASUREMENT_TREE
+  uint64_t leaf_size;
+  uint64_t loaded_size; // size of the measured stream
+  uint64_t leaf_count;
+} sm_tree_header_t;
+
+// Copies the manifest used to measure an image of image_size bytes.
+static inline void sm_measured_manifest(sm_manifest_t* measured,
+    const sm_manifest_t* manifest, uint64_t image_size) {
+  if (sm_manifest_is_valid(manifest, image_size)) {
+    *measured = *manifest;
+  } else {
+    sm_manifest_whole_image(measured, image_size);
+  }
+}
+
+// Returns the size of the measured stream.
+static inline uint64_t sm_manifest_loaded_size(const sm_manifest_t* manifest) {
+  uint64_t total = 0;
+  for (uint64_t i = 0; i < manifest->segment_count; i++) {
+    if (manifest->segments[i].kind == MANIFEST_SEGMENT_LOADED) {
+      total += manifest->segments[i].length;
+    }
+  }
+  return total;
+}
+
+// Hashes len bytes of the measured stream, starting at offset.
+static inline void sm_manifest_absorb(sha3_ctx_t* hash_ctx,
+    const uint8_t* image, const sm_manifest_t* manifest, uint64_t offset,
+    uint64_t len) {
+  uint64_t image_offset = 0;
+  for (uint64_t i = 0; i < manifest->segment_count && len != 0; i++) {
+    const manifest_segment_t* segment = &manifest->segments[i];
+    if (segment->kind == MANIFEST_SEGMENT_LOADED) {
+      if (offset < segment->length) {
+        uint64_t chunk = segment->length - offset;
+        if (chunk > len) {
+          chunk = len;
+        }
+        sha3_update(hash_ctx, image + image_offset + offset, chunk);
+        len -= chunk;
+        offset = 0;
+      } else {
+        offset -= segment->length;
+      }
+    }
+    image_offset += segment->length;
+  }
+}
+
+// Computes SM_H (64 bytes) in serial mode.
+static inline void sm_serial_hash(uint8_t* hash, const uint8_t* image,
+    const sm_manifest_t* manifest) {
+  sha3_ctx_t hash_ctx;
+
+  sha3_init(&hash_ctx, 64);
+  sha3_update(&hash_ctx, manifest, sizeof(*manifest));
+  sm_manifest_absorb(&hash_ctx, image, manifest, 0,
+      sm_manifest_loaded_size(manifest));
+  sha3_final(hash, &hash_ctx);
+}
+
+static inline uint64_t sm_tree_leaf_count(uint64_t loaded_size,
+    uint64_t leaf_size) {
+  return (loaded_size + leaf_size - 1) / leaf_size;
+}
+
+// Hashes one leaf of the measured stream into leaf_hash (64 bytes).
+static inline void sm_tree_hash_leaf(const uint8_t* image,
+    const sm_manifest_t* manifest, uint64_t leaf_size, uint64_t leaf,
+    uint8_t* leaf_hash) {
+  sha3_ctx_t hash_ctx;
+  uint64_t offset = leaf * leaf_size;
+  uint64_t len = sm_manifest_loaded_size(manifest) - offset;
+  if (len > leaf_size) {
+    len = leaf_size;
+  }
+
+  sha3_init(&hash_ctx, 64);
+  sm_manifest_absorb(&hash_ctx, image, manifest, offset, len);
+  sha3_final(leaf_hash, &hash_ctx);
+}
+
+// Computes the root (64 bytes) over all the leaf digests.
+static inline void sm_tree_root(uint8_t* root, uint64_t mode,
+    const sm_manifest_t* manifest, uint64_t leaf_size,
+    const uint8_t* leaf_hashes) {
+  sm_tree_header_t header;
+  sha3_ctx_t hash_ctx;
+
+  header.mode = mode;
+  header.leaf_size = leaf_size;
+  header.loaded_size = sm_manifest_loaded_size(manifest);
+  header.leaf_count = sm_tree_leaf_count(header.loaded_size, leaf_size);
+
+  sha3_init(&hash_ctx, 64);
+  sha3_update(&hash_ctx, &header, sizeof(header));
+  sha3_update(&hash_ctx, manifest, sizeof(*manifest));
+  sha3_update(&hash_ctx, leaf_hashes, header.leaf_count * 64);
+  sha3_final(root, &hash_ctx);
+}
+
+#endif
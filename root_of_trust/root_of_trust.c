@@ -1,5 +1,6 @@
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "sha3/sha3.h"
 /*
@@ -12,7 +13,15 @@
   types: sha3_ctx_t
 */
 
+#include "image_manifest.h"
+/*
+  provides:
+  - BOOTLOADER_MANIFEST_OFFSET
+  types: bootloader_manifest_t
+*/
+
 extern const void * bootloader_ptr;
+extern const bootloader_manifest_t bootloader_manifest;
 extern const size_t bootloader_size;
 extern const uint64_t bootloader_expected_hash[8];
 
@@ -41,8 +50,18 @@ bool __attribute__ ((section (".text.rot"))) rot_hash_and_verify() {
 
   //print_char('@');
 
-  // Compute hash of the trusted bootloader DRAM
-  sha3(&bootloader_ptr, bootloader_size, bootloader_hash, 64);
+  // The manifest is in DRAM, and is only trusted once the hash matches (it is
+  // part of the hashed bytes), so first make sure it stays within the segment
+  uint64_t loaded_size = bootloader_manifest.loaded_size;
+  uint64_t zero_size = bootloader_manifest.zero_size;
+  if (loaded_size < BOOTLOADER_MANIFEST_OFFSET + sizeof(bootloader_manifest_t) ||
+      loaded_size > bootloader_size ||
+      zero_size > bootloader_size - loaded_size) {
+    return false;
+  }
+
+  // Compute hash of the loaded part of the trusted bootloader DRAM
+  sha3(&bootloader_ptr, loaded_size, bootloader_hash, 64);
 
   // Compare the root of trust hash againt an expected value
   // (there are no secrets to clean up);
@@ -51,6 +70,9 @@ bool __attribute__ ((section (".text.rot"))) rot_hash_and_verify() {
       return false;
     }
   }
+
+  // The bootloader's .bss is measured by length only
+  memset((uint8_t*)&bootloader_ptr + loaded_size, 0, zero_size);
   return true;
 }
 
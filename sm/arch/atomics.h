@@ -16,12 +16,12 @@ typedef struct {
   int flag;
 } atomic_flag;
 
-static inline bool atomic_flag_test_and_set(atomic_flag f) {
-  return __sync_lock_test_and_set(&(f.flag), true);
+static inline bool atomic_flag_test_and_set(atomic_flag* f) {
+  return __sync_lock_test_and_set(&(f->flag), true);
 }
 
-static inline void atomic_flag_clear(atomic_flag f) {
-  f.flag = false;
+static inline void atomic_flag_clear(atomic_flag* f) {
+  __sync_lock_release(&(f->flag));
 }
 
 //private:
@@ -45,5 +45,18 @@ static inline uintptr_t atomic_fetch_add(uintptr_t* object, uintptr_t value) {
 static inline uintptr_t atomic_fetch_sub(uintptr_t* object, uintptr_t value) {
   return __sync_fetch_and_sub(object, value);
 }
+static inline uintptr_t atomic_fetch_or(uintptr_t* object, uintptr_t value) {
+  return __sync_fetch_and_or(object, value);
+}
+static inline uintptr_t atomic_fetch_and(uintptr_t* object, uintptr_t value) {
+  return __sync_fetch_and_and(object, value);
+}
+
+// C++11 fences.
+//
+// Only sequentially consistent fences are implemented.
+static inline void atomic_thread_fence() {
+  __sync_synchronize();
+}
 
 #endif  // !definded(BARE_ATOMIC_H_INCLUDED)
@@ -53,7 +53,7 @@ static inline size_t address_bits_for(size_t memory_size) {
 
 // The smallest power of two that is greater or equal to a quantity.
 static inline size_t ceil_power_of_two(size_t memory_size) {
-  return 1 << address_bits_for(memory_size);
+  return (size_t)1 << address_bits_for(memory_size);
 }
 
 // True if the argument is a power of two.
@@ -61,6 +61,37 @@ static inline const bool is_power_of_two(size_t memory_size) {
   return memory_size > 0 && is_valid_range_mask(memory_size - 1);
 }
 
+// The number of trailing 0 bits in a non-zero word.
+static inline size_t count_trailing_zeros(size_t word) {
+#if defined(__riscv_zbb)
+  return __builtin_ctzl(word);
+#else
+  // NOTE: The monitor is not linked with libgcc, so __builtin_ctzl() can only
+  //       be used when it compiles down to an instruction.
+  size_t count = 0;
+  for (size_t shift = sizeof(size_t) * 4; shift > 0; shift >>= 1) {
+    if ((word & (((size_t)1 << shift) - 1)) == 0) {
+      word >>= shift;
+      count += shift;
+    }
+  }
+  return count;
+#endif  // defined(__riscv_zbb)
+}
+
+// The number of 1 bits in a word.
+static inline size_t count_ones(size_t word) {
+#if defined(__riscv_zbb)
+  return __builtin_popcountl(word);
+#else
+  const size_t ones = ~(size_t)0;
+  word -= (word >> 1) & (ones / 3);
+  word = (word & (ones / 5)) + ((word >> 2) & (ones / 5));
+  word = (word + (word >> 4)) & (ones / 17);
+  return (word * (ones / 255)) >> ((sizeof(size_t) - 1) * 8);
+#endif  // defined(__riscv_zbb)
+}
+
 // Sets or clears a bit in a bitmap.
 //
 // `value` is true for setting the bit, or false for clearing the bit.
@@ -69,7 +100,7 @@ static inline void set_bitmap_bit(size_t* bitmap, size_t bit, bool value) {
 
   // NOTE: relying on the compiler to optimize division to bitwise shift
   const size_t offset = bit / bits_in_size_t;
-  const size_t mask = 1 << (bit % bits_in_size_t);
+  const size_t mask = (size_t)1 << (bit % bits_in_size_t);
 
   if (value)
     *(bitmap + offset) |= mask;
@@ -82,11 +113,93 @@ static inline bool read_bitmap_bit(size_t* bitmap, size_t bit) {
 
   // NOTE: relying on the compiler to optimize division to bitwise shift
   const size_t offset = bit / bits_in_size_t;
-  const size_t mask = 1 << (bit % bits_in_size_t);
+  const size_t mask = (size_t)1 << (bit % bits_in_size_t);
 
   return (*(bitmap + offset) & mask) != 0;
 }
 
+// Sets or clears the first `bit_count` bits in a bitmap.
+//
+// The other bits in the last word are cleared.
+static inline void fill_bitmap(size_t* bitmap, size_t bit_count, bool value) {
+  const size_t bits_in_size_t = sizeof(size_t) * 8;
+
+  // NOTE: relying on the compiler to optimize division to bitwise shift
+  const size_t full_words = bit_count / bits_in_size_t;
+  const size_t tail_bits = bit_count % bits_in_size_t;
+  const size_t fill = value ? ~(size_t)0 : 0;
+
+  for (size_t i = 0; i < full_words; ++i)
+    bitmap[i] = fill;
+  if (tail_bits != 0)
+    bitmap[full_words] = fill & (((size_t)1 << tail_bits) - 1);
+}
+
+// The number of set bits among the first `bit_count` bits of a bitmap.
+static inline size_t count_bitmap_bits(size_t* bitmap, size_t bit_count) {
+  const size_t bits_in_size_t = sizeof(size_t) * 8;
+
+  // NOTE: relying on the compiler to optimize division to bitwise shift
+  const size_t full_words = bit_count / bits_in_size_t;
+  const size_t tail_bits = bit_count % bits_in_size_t;
+
+  size_t count = 0;
+  for (size_t i = 0; i < full_words; ++i)
+    count += count_ones(bitmap[i]);
+  if (tail_bits != 0)
+    count += count_ones(bitmap[full_words] & (((size_t)1 << tail_bits) - 1));
+  return count;
+}
+
+// The first bit at or after `bit` whose value is `value`.
+//
+// Only the first `bit_count` bits of the bitmap are considered. Returns
+// `bit_count` if there is no such bit.
+//
+// Whole words that don't match are skipped, so this takes time proportional
+// to the number of words searched, not the number of bits.
+static inline size_t find_bitmap_bit(size_t* bitmap, size_t bit_count,
+    size_t bit, bool value) {
+  const size_t bits_in_size_t = sizeof(size_t) * 8;
+  if (bit >= bit_count)
+    return bit_count;
+
+  // NOTE: relying on the compiler to optimize division to bitwise shift
+  const size_t word_count = (bit_count + bits_in_size_t - 1) / bits_in_size_t;
+  const size_t flip = value ? 0 : ~(size_t)0;
+  size_t offset = bit / bits_in_size_t;
+  size_t word = (bitmap[offset] ^ flip) &
+      (~(size_t)0 << (bit % bits_in_size_t));
+  while (word == 0) {
+    if (++offset == word_count)
+      return bit_count;
+    word = bitmap[offset] ^ flip;
+  }
+
+  const size_t found = offset * bits_in_size_t + count_trailing_zeros(word);
+  return (found < bit_count) ? found : bit_count;
+}
+
+// The first set bit at or after `bit`, or `bit_count` if there is none.
+static inline size_t next_set_bitmap_bit(size_t* bitmap, size_t bit_count,
+    size_t bit) {
+  return find_bitmap_bit(bitmap, bit_count, bit, true);
+}
+
+// The first clear bit in a bitmap, or `bit_count` if all bits are set.
+static inline size_t first_clear_bitmap_bit(size_t* bitmap, size_t bit_count) {
+  return find_bitmap_bit(bitmap, bit_count, 0, false);
+}
+
+// Iterates over the set bits among the first `bit_count` bits of a bitmap.
+//
+// `bit` is declared by the loop, and takes the indices of the set bits in
+// increasing order.
+#define for_each_set_bitmap_bit(bit, bitmap, bit_count) \
+  for (size_t bit = next_set_bitmap_bit((bitmap), (bit_count), 0); \
+       bit < (bit_count); \
+       bit = next_set_bitmap_bit((bitmap), (bit_count), bit + 1))
+
 // True if this is a big-endian architecture.
 #define is_big_endian() false
 
@@ -18,6 +18,28 @@ static inline size_t current_core() {
   return read_csr(mhartid);
 }
 
+// Reads the platform's real-time counter.
+//
+// The counter is shared by all cores, so readings taken on different cores can
+// be compared.
+static inline uint64_t read_real_time() {
+  extern volatile uint64_t* mtime;
+  return *mtime;
+}
+
+// Reads a word from the platform's true random number generator.
+//
+// Reads are slow, so the TRNG should only be used to seed generators.
+static inline uintptr_t read_trng() {
+  return read_csr(0xCC0);  // CSR_TRNG
+}
+
+// Interrupts a core, and has it call help_scrub_dram_regions() in machine mode.
+//
+// This returns right away. The interrupt is taken once the core is not in
+// machine mode.
+void send_scrub_ipi(size_t core);
+
 // Flush all TLBs on the current core.
 //
 // This does not flush any cache.
@@ -76,13 +76,36 @@ static inline size_t read_max_cache_index_shift() {
   return 0; // TODO: this is irrelevant for this prototype
 }
 
+// The number of bytes cleared at a time by bzero().
+//
+// Sanctum's cache lines are 64 bytes. Platforms built with Zicboz must also
+// have 64-byte cache blocks.
+#define bzero_block_size 64
+
 // Fills a buffer in physical memory with zeros.
 //
 // In order to allow for optimized assembly implementations, both the starting
 // address and buffer size must be a multiple of the cache line size.
 static inline void bzero(void* start, size_t bytes) {
-  // Note: this is basically memset zero at 64b granularity
-  memset(start, 0, bytes);
+  const uintptr_t end = (uintptr_t)start + bytes;
+#if defined(__riscv_zicboz)
+  // cbo.zero allocates zeroed lines without reading them from DRAM first.
+  for (uintptr_t block = (uintptr_t)start; block < end;
+      block += bzero_block_size) {
+    asm volatile ("cbo.zero (%0)" : : "r"(block) : "memory");
+  }
+#else
+  for (uint64_t* word = (uint64_t*)start; (uintptr_t)word < end; word += 8) {
+    word[0] = 0;
+    word[1] = 0;
+    word[2] = 0;
+    word[3] = 0;
+    word[4] = 0;
+    word[5] = 0;
+    word[6] = 0;
+    word[7] = 0;
+  }
+#endif  // defined(__riscv_zicboz)
 }
 
 // Copies data between two non-overlaping buffers in physical memory.
@@ -52,6 +52,24 @@ inline uintptr_t page_table_entry_target(uintptr_t entry_addr, size_t level) {
   return *((uintptr_t*)entry_addr) & target_mask;
 }
 
+// Reads the access control flags in a page table entry.
+//
+// The result has the same format as the `acl` argument to
+// write_page_table_entry(). The flags are also kept in invalid entries written
+// by invalidate_page_table_entry().
+inline uintptr_t page_table_entry_acl(uintptr_t entry_addr, size_t level) {
+  uintptr_t acl_mask = (1 << page_shift()) - 2;  // Masks off the valid bit.
+  return *((uintptr_t*)entry_addr) & acl_mask;
+}
+
+// Clears the valid bit and the destination pointer in a page table entry.
+//
+// The access control flags are kept, so write_page_table_entry() can restore
+// the entry with a new destination pointer.
+inline void invalidate_page_table_entry(uintptr_t entry_addr, size_t level) {
+  *((uintptr_t*)entry_addr) = page_table_entry_acl(entry_addr, level);
+}
+
 // Writes a page table entry.
 //
 // `target` points to the next level page table, or has the physical address
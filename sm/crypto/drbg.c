@@ -0,0 +1,50 @@
+#include "drbg.h"
+
+#include <string.h>
+#include "sha3/sha3.h"
+
+// The domain separation byte for seeds, in SHAKE's padding position.
+#define drbg_seed_domain 0x1F
+
+void drbg_seed(drbg_state_t* drbg, const void* seed, size_t seed_size,
+    size_t reseed_bytes) {
+  const uint8_t* bytes = (const uint8_t*)seed;
+
+  // NOTE: The seed is padded like a SHAKE message, so seeds of different sizes
+  //       never leave the rate in the same state.
+  size_t offset = 0;
+  for (; seed_size - offset >= drbg_rate; offset += drbg_rate) {
+    for (size_t i = 0; i < drbg_rate; ++i)
+      drbg->st.b[i] ^= bytes[offset + i];
+    sha3_keccakf(drbg->st.q);
+  }
+  for (size_t i = 0; offset + i < seed_size; ++i)
+    drbg->st.b[i] ^= bytes[offset + i];
+  drbg->st.b[seed_size - offset] ^= drbg_seed_domain;
+  drbg->st.b[drbg_rate - 1] ^= 0x80;
+  sha3_keccakf(drbg->st.q);
+
+  drbg->reseed_countdown = reseed_bytes;
+}
+
+void drbg_generate(drbg_state_t* drbg, void* output, size_t size) {
+  uint8_t* bytes = (uint8_t*)output;
+
+  // NOTE: Each block is squeezed right after a permutation, so the rate cleared
+  //       at the end of the previous request is never output.
+  for (size_t offset = 0; offset < size; offset += drbg_rate) {
+    size_t block_size = size - offset;
+    if (block_size > drbg_rate)
+      block_size = drbg_rate;
+    sha3_keccakf(drbg->st.q);
+    memcpy(bytes + offset, drbg->st.b, block_size);
+  }
+
+  // Forget the rate. Inverting the last permutation needs the cleared bytes.
+  volatile uint8_t* rate = drbg->st.b;
+  for (size_t i = 0; i < drbg_rate; ++i)
+    rate[i] = 0;
+
+  drbg->reseed_countdown = (size < drbg->reseed_countdown) ?
+      drbg->reseed_countdown - size : 0;
+}
@@ -0,0 +1,54 @@
+#ifndef CRYPTO_DRBG_H_INCLUDED
+#define CRYPTO_DRBG_H_INCLUDED
+
+#include <arch/base_types.h>
+
+// A deterministic random bit generator built on the Keccak-f[1600] duplex.
+//
+// Seeds are absorbed into the sponge at the SHAKE256 rate (136 bytes, for a
+// 512-bit capacity), and output is squeezed from the rate. After each request
+// the rate is cleared, so the state left behind cannot be run backwards to
+// recover output that was already handed out.
+//
+// Each state is used by a single core, so there is no locking.
+
+// The number of bytes absorbed or squeezed per Keccak-f permutation.
+#define drbg_rate 136
+
+// The number of seed bytes that a reseed should supply, at least.
+#define drbg_seed_size 32
+
+// The state of a generator.
+//
+// An all-zero state is unseeded. drbg_needs_seed() is true for it.
+typedef struct {
+  union {
+    uint8_t b[200];
+    uint64_t q[25];
+  } st;
+
+  // The number of bytes that may be generated before the next reseed.
+  size_t reseed_countdown;
+} drbg_state_t;
+
+// Mixes a seed into a generator's state.
+//
+// Earlier seeds keep contributing to the state, so a weak seed never makes
+// the generator weaker than it was. `reseed_bytes` becomes the generator's
+// reseed countdown.
+void drbg_seed(drbg_state_t* drbg, const void* seed, size_t seed_size,
+    size_t reseed_bytes);
+
+// True if the generator must be reseeded before it generates more output.
+static inline bool drbg_needs_seed(const drbg_state_t* drbg) {
+  return drbg->reseed_countdown == 0;
+}
+
+// Writes `size` random bytes to `output`.
+//
+// The caller must reseed the generator first if drbg_needs_seed() is true.
+// Requests larger than the reseed countdown are served in full, and leave the
+// countdown at zero.
+void drbg_generate(drbg_state_t* drbg, void* output, size_t size);
+
+#endif  // !defined(CRYPTO_DRBG_H_INCLUDED)
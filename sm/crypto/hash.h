@@ -2,6 +2,13 @@
 #define CRYPTO_HASH_H_INCLUDED
 
 #include <arch/base_types.h>
+#include <sanctum_config.h>
+
+// The hashing engine used for enclave measurements.
+//
+// The engine is selected at compile time by SM_HASH_ENGINE. Both engines take
+// their input in hash_block_size-byte blocks, so the measurement code does
+// not depend on the engine.
 
 // The block size for the hashing algorithm, in bytes.
 //
@@ -16,6 +23,13 @@
 //static_assert(hash_block_size % sizeof(uintptr_t) == 0,
 //    "hash_block_size not a multiple of uintptr_t");
 
+// The page size used by extend_hash_pages(), in bytes.
+//
+// This must match page_size() in arch/page_tables.h.
+#define hash_page_size 4096
+
+#if SM_HASH_ENGINE == SM_HASH_SHA256
+
 // The size of the result of a hashing operation.
 #define hash_result_size 32
 // 256 bits
@@ -25,8 +39,27 @@ typedef struct {
   uint32_t h[8];  // Stores the final hash.
   uint32_t work_area[16];  // Stores the message schedule.
   size_t padding[hash_block_size / sizeof(size_t)];  // The padding block.
+  size_t block_count;  // Number of blocks hashed so far.
+} hash_state_t;
+
+#elif SM_HASH_ENGINE == SM_HASH_SHA3_512
+
+#include "sha3/sha3.h"
+
+// The size of the result of a hashing operation.
+#define hash_result_size 64
+// 512 bits
+
+// The data structure used by the SHA3-512 functions.
+typedef struct {
+  // Stores the Keccak state, and the final hash once the hash is finalized.
+  sha3_ctx_t ctx;
 } hash_state_t;
 
+#else
+#error "Unknown SM_HASH_ENGINE"
+#endif  // SM_HASH_ENGINE
+
 // Initializes a hashing data structure.
 //
 // This must be called before extend_hash() is used.
@@ -38,6 +71,32 @@ void init_hash(hash_state_t* state);
 // set up the hashing data structure before this function is used.
 void extend_hash(hash_state_t* state, uint32_t* block);
 
+// Extends a crypto hash by whole pages.
+//
+// This has the same effect as calling extend_hash() on each block of the
+// `page_count` pages starting at `pages`, which must be size_t-aligned.
+void extend_hash_pages(hash_state_t* state, const void* pages,
+    size_t page_count);
+
+// Copies a buffer and extends a crypto hash by its contents, in one pass.
+//
+// This has the same effect as copying the buffer with bcopy() and then calling
+// extend_hash() on each block of the copy, but each block is read from
+// `source` exactly once, so the data only crosses the memory hierarchy once.
+// The hash covers the bytes written to `dest`, even if `source` changes while
+// it is being copied.
+//
+// Both addresses must be size_t-aligned, and the buffer size must be a
+// multiple of hash_block_size.
+void extend_hash_with_copy(hash_state_t* state, void* dest,
+    const void* source, size_t bytes);
+
+// Copies a hashing data structure.
+//
+// This snapshots a hash after a common prefix. Both structures can then be
+// extended and finalized independently.
+void copy_hash(hash_state_t* dest, const hash_state_t* source);
+
 // Finalizes the value in a hashing data structure.
 //
 // After this is called, extend_hash() must not be called again. The final hash
@@ -46,4 +105,3 @@ void extend_hash(hash_state_t* state, uint32_t* block);
 void finalize_hash(hash_state_t* state);
 
 #endif  // !defined(CRYPTO_HASH_H_INCLUDED)
-
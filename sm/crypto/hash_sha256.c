@@ -0,0 +1,190 @@
+#include "hash.h"
+
+#if SM_HASH_ENGINE == SM_HASH_SHA256
+
+// SHA-256, as specified in FIPS 180-4.
+//
+// The monitor only ever hashes whole blocks, so the engine does not buffer
+// partial input. The message length is tracked in blocks, and the padding
+// block is assembled in the state's padding area by finalize_hash().
+
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr32(uint32_t x, int n) {
+  return (x >> n) | (x << (32 - n));
+}
+
+// The SHA-256 sigma functions. With the Zknh extension, each one is a single
+// instruction; otherwise they are built out of rotations.
+#if defined(__riscv_zknh)
+
+#define SHA256_ZKNH_OP(name) \
+  static inline uint32_t name(uint32_t x) { \
+    unsigned long result; \
+    asm (#name " %0, %1" : "=r"(result) : "r"((unsigned long)x)); \
+    return (uint32_t)result; \
+  }
+SHA256_ZKNH_OP(sha256sig0)
+SHA256_ZKNH_OP(sha256sig1)
+SHA256_ZKNH_OP(sha256sum0)
+SHA256_ZKNH_OP(sha256sum1)
+#undef SHA256_ZKNH_OP
+
+#else
+
+static inline uint32_t sha256sig0(uint32_t x) {
+  return rotr32(x, 7) ^ rotr32(x, 18) ^ (x >> 3);
+}
+static inline uint32_t sha256sig1(uint32_t x) {
+  return rotr32(x, 17) ^ rotr32(x, 19) ^ (x >> 10);
+}
+static inline uint32_t sha256sum0(uint32_t x) {
+  return rotr32(x, 2) ^ rotr32(x, 13) ^ rotr32(x, 22);
+}
+static inline uint32_t sha256sum1(uint32_t x) {
+  return rotr32(x, 6) ^ rotr32(x, 11) ^ rotr32(x, 25);
+}
+
+#endif  // defined(__riscv_zknh)
+
+// Reads a big-endian 32-bit word.
+static inline uint32_t load_be32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+      ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+// Writes a big-endian 32-bit word.
+static inline void store_be32(uint8_t* p, uint32_t x) {
+  p[0] = x >> 24;
+  p[1] = x >> 16;
+  p[2] = x >> 8;
+  p[3] = x;
+}
+
+// Runs the SHA-256 compression function on one block.
+static void sha256_compress(hash_state_t* state, const uint8_t* block) {
+  uint32_t* w = state->work_area;
+  for (size_t i = 0; i < 16; ++i)
+    w[i] = load_be32(block + 4 * i);
+
+  uint32_t a = state->h[0], b = state->h[1], c = state->h[2],
+      d = state->h[3], e = state->h[4], f = state->h[5], g = state->h[6],
+      h = state->h[7];
+
+  for (size_t i = 0; i < 64; ++i) {
+    // The message schedule is kept as a 16-word ring in the work area.
+    if (i >= 16) {
+      w[i & 15] += sha256sig0(w[(i - 15) & 15]) + w[(i - 7) & 15] +
+          sha256sig1(w[(i - 2) & 15]);
+    }
+
+    uint32_t t1 = h + sha256sum1(e) + ((e & f) ^ (~e & g)) + sha256_k[i] +
+        w[i & 15];
+    uint32_t t2 = sha256sum0(a) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  state->h[0] += a;
+  state->h[1] += b;
+  state->h[2] += c;
+  state->h[3] += d;
+  state->h[4] += e;
+  state->h[5] += f;
+  state->h[6] += g;
+  state->h[7] += h;
+}
+
+void init_hash(hash_state_t* state) {
+  state->h[0] = 0x6a09e667;
+  state->h[1] = 0xbb67ae85;
+  state->h[2] = 0x3c6ef372;
+  state->h[3] = 0xa54ff53a;
+  state->h[4] = 0x510e527f;
+  state->h[5] = 0x9b05688c;
+  state->h[6] = 0x1f83d9ab;
+  state->h[7] = 0x5be0cd19;
+  state->block_count = 0;
+}
+
+void extend_hash(hash_state_t* state, uint32_t* block) {
+  sha256_compress(state, (const uint8_t*)block);
+  state->block_count += 1;
+}
+
+void extend_hash_pages(hash_state_t* state, const void* pages,
+    size_t page_count) {
+  const uint8_t* block = (const uint8_t*)pages;
+  const uint8_t* end = block + page_count * hash_page_size;
+  for (; block != end; block += hash_block_size)
+    sha256_compress(state, block);
+  state->block_count += page_count * (hash_page_size / hash_block_size);
+}
+
+void extend_hash_with_copy(hash_state_t* state, void* dest,
+    const void* source, size_t bytes) {
+  size_t* dest_ptr = (size_t*)dest;
+  const size_t* source_ptr = (const size_t*)source;
+  size_t block[hash_block_size / sizeof(size_t)];
+  for (size_t offset = 0; offset < bytes; offset += hash_block_size) {
+    for (size_t i = 0; i < hash_block_size / sizeof(size_t); ++i) {
+      block[i] = source_ptr[i];
+      dest_ptr[i] = block[i];
+    }
+    sha256_compress(state, (const uint8_t*)block);
+    state->block_count += 1;
+    source_ptr += hash_block_size / sizeof(size_t);
+    dest_ptr += hash_block_size / sizeof(size_t);
+  }
+}
+
+void copy_hash(hash_state_t* dest, const hash_state_t* source) {
+  // The work area and the padding block are scratch space, so they are not
+  // part of the snapshot.
+  for (size_t i = 0; i < 8; ++i)
+    dest->h[i] = source->h[i];
+  dest->block_count = source->block_count;
+}
+
+void finalize_hash(hash_state_t* state) {
+  // The message is a whole number of blocks, so the padding always takes up
+  // an entire block: 0x80, zeroes, and the big-endian message length in bits.
+  uint8_t* padding = (uint8_t*)state->padding;
+  for (size_t i = 0; i < hash_block_size; ++i)
+    padding[i] = 0;
+  padding[0] = 0x80;
+  uint64_t bit_count = (uint64_t)state->block_count * hash_block_size * 8;
+  store_be32(padding + hash_block_size - 8, bit_count >> 32);
+  store_be32(padding + hash_block_size - 4, bit_count);
+  sha256_compress(state, padding);
+
+  // The digest is stored in big-endian order over h.
+  uint8_t* result = (uint8_t*)state->h;
+  for (size_t i = 0; i < 8; ++i)
+    store_be32(result + 4 * i, state->h[i]);
+}
+
+#endif  // SM_HASH_ENGINE == SM_HASH_SHA256
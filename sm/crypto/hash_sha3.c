@@ -0,0 +1,77 @@
+#include "hash.h"
+
+#if SM_HASH_ENGINE == SM_HASH_SHA3_512
+
+// SHA3-512, using the Keccak implementation in common/sha3.
+//
+// The measurement blocks are simply absorbed as a byte stream. Whole pages are
+// passed to sha3_update() in one call, which absorbs aligned input a lane at a
+// time.
+
+void init_hash(hash_state_t* state) {
+  sha3_init(&(state->ctx), hash_result_size);
+}
+
+void extend_hash(hash_state_t* state, uint32_t* block) {
+  sha3_update(&(state->ctx), block, hash_block_size);
+}
+
+void extend_hash_pages(hash_state_t* state, const void* pages,
+    size_t page_count) {
+  sha3_update(&(state->ctx), pages, page_count * hash_page_size);
+}
+
+// NOTE: The measurement blocks and pages are whole lanes, so the input is
+//       copied and XORed into the Keccak state a lane at a time, in whole rate
+//       blocks, without a bounce buffer.
+void extend_hash_with_copy(hash_state_t* state, void* dest,
+    const void* source, size_t bytes) {
+  sha3_ctx_t* ctx = &(state->ctx);
+  uint64_t* dest_ptr = (uint64_t*)dest;
+  const uint64_t* source_ptr = (const uint64_t*)source;
+
+  if (((ctx->pt | bytes | (uintptr_t)dest | (uintptr_t)source) & 7) != 0) {
+    for (size_t i = 0; i < bytes; ++i)
+      ((uint8_t*)dest)[i] = ((const uint8_t*)source)[i];
+    sha3_update(ctx, dest, bytes);
+    return;
+  }
+
+  const size_t rate_lanes = ctx->rsiz / sizeof(uint64_t);
+  size_t lane = ctx->pt / sizeof(uint64_t);
+  size_t lanes_left = bytes / sizeof(uint64_t);
+  while (lanes_left != 0) {
+    size_t lane_count = rate_lanes - lane;
+    if (lane_count > lanes_left)
+      lane_count = lanes_left;
+    for (size_t i = 0; i < lane_count; ++i) {
+      uint64_t word = source_ptr[i];
+      dest_ptr[i] = word;
+      ctx->st.q[lane + i] ^= word;
+    }
+    source_ptr += lane_count;
+    dest_ptr += lane_count;
+    lanes_left -= lane_count;
+    lane += lane_count;
+    if (lane == rate_lanes) {
+      sha3_keccakf(ctx->st.q);
+      lane = 0;
+    }
+  }
+  ctx->pt = lane * sizeof(uint64_t);
+}
+
+void copy_hash(hash_state_t* dest, const hash_state_t* source) {
+  sha3_copy(&(dest->ctx), &(source->ctx));
+}
+
+void finalize_hash(hash_state_t* state) {
+  // The digest is stored over the start of the Keccak state.
+  uint8_t result[hash_result_size];
+  sha3_final(result, &(state->ctx));
+  uint8_t* state_bytes = (uint8_t*)state;
+  for (size_t i = 0; i < hash_result_size; ++i)
+    state_bytes[i] = result[i];
+}
+
+#endif  // SM_HASH_ENGINE == SM_HASH_SHA3_512
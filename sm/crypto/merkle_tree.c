@@ -0,0 +1,57 @@
+#include "merkle_tree.h"
+#include "sha3/sha3.h"
+
+static const uint8_t merkle_leaf_tag = 0;
+static const uint8_t merkle_node_tag = 1;
+
+void merkle_hash_leaf(uint8_t* leaf_hash, const void* leaf, size_t leaf_size) {
+  sha3_ctx_t ctx;
+  sha3_init(&ctx, merkle_hash_size);
+  sha3_update(&ctx, &merkle_leaf_tag, 1);
+  sha3_update(&ctx, leaf, leaf_size);
+  sha3_final(leaf_hash, &ctx);
+}
+
+void merkle_compute_tree(uint8_t (*nodes)[merkle_hash_size], size_t depth) {
+  // The nodes at one level only depend on the level below, so each level is
+  // hashed SHA3_MULTI_WAYS nodes at a time, with interleaved permutations.
+  for (size_t level = depth; level != 0; --level) {
+    const size_t level_start = (size_t)1 << (level - 1);
+    const size_t level_end = level_start << 1;
+    for (size_t node = level_start; node < level_end;
+         node += SHA3_MULTI_WAYS) {
+      size_t count = level_end - node;
+      if (count > SHA3_MULTI_WAYS)
+        count = SHA3_MULTI_WAYS;
+
+      const void* tags[SHA3_MULTI_WAYS];
+      const void* children[SHA3_MULTI_WAYS];
+      size_t tag_sizes[SHA3_MULTI_WAYS];
+      size_t children_sizes[SHA3_MULTI_WAYS];
+      void* digests[SHA3_MULTI_WAYS];
+      for (size_t i = 0; i < count; ++i) {
+        tags[i] = &merkle_node_tag;
+        tag_sizes[i] = 1;
+        children[i] = nodes[2 * (node + i)];
+        children_sizes[i] = 2 * merkle_hash_size;
+        digests[i] = nodes[node + i];
+      }
+
+      sha3_multi_ctx_t ctx;
+      sha3_multi_init(&ctx, count, merkle_hash_size);
+      sha3_multi_update(&ctx, tags, tag_sizes);
+      sha3_multi_update(&ctx, children, children_sizes);
+      sha3_multi_final(digests, &ctx);
+    }
+  }
+}
+
+void merkle_read_path(uint8_t (*path)[merkle_hash_size],
+    uint8_t (*nodes)[merkle_hash_size], size_t depth, size_t leaf_index) {
+  size_t node = ((size_t)1 << depth) + leaf_index;
+  for (size_t height = 0; height < depth; ++height, node >>= 1) {
+    uint8_t* sibling = nodes[node ^ 1];
+    for (size_t i = 0; i < merkle_hash_size; ++i)
+      path[height][i] = sibling[i];
+  }
+}
@@ -0,0 +1,34 @@
+#ifndef CRYPTO_MERKLE_TREE_H_INCLUDED
+#define CRYPTO_MERKLE_TREE_H_INCLUDED
+
+#include <arch/base_types.h>
+
+// SHA3-512 Merkle trees with a fixed number of leaves.
+//
+// A tree of depth d has 2^d leaves and is stored as an implicit binary heap of
+// 2^(d+1) node hashes: node 1 is the root, node n has children 2n and 2n + 1,
+// and leaf i is node 2^d + i. Node 0 is unused.
+//
+// Leaf and interior hashes are domain-separated:
+//
+//   leaf = SHA3-512(0x00 || leaf data)
+//   node = SHA3-512(0x01 || left child || right child)
+
+// The size of a node hash, in bytes.
+#define merkle_hash_size 64
+
+// Hashes a leaf's data into its node hash.
+void merkle_hash_leaf(uint8_t* leaf_hash, const void* leaf, size_t leaf_size);
+
+// Computes the interior nodes of a tree, given its leaf hashes.
+void merkle_compute_tree(uint8_t (*nodes)[merkle_hash_size], size_t depth);
+
+// Reads the inclusion path of a leaf from a computed tree.
+//
+// path[i] is the sibling of the leaf's ancestor at height i, so path[0] is the
+// leaf's own sibling. Bit i of the leaf index is set if that sibling is the
+// left child.
+void merkle_read_path(uint8_t (*path)[merkle_hash_size],
+    uint8_t (*nodes)[merkle_hash_size], size_t depth, size_t leaf_index);
+
+#endif  // !defined(CRYPTO_MERKLE_TREE_H_INCLUDED)
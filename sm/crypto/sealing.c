@@ -0,0 +1,63 @@
+#include "sealing.h"
+
+#include <string.h>
+
+// The number of bytes that go through the cipher at a time.
+//
+// This must be a multiple of AES_BLOCKLEN.
+#define sealing_chunk_size 256
+
+// Clears the key schedule and data left on the stack.
+static void wipe_sealing_state(struct AES_gcm_ctx* gcm, uint8_t* chunk) {
+  volatile uint8_t* secrets[2] = { (volatile uint8_t*)gcm, chunk };
+  size_t sizes[2] = { sizeof(*gcm), sealing_chunk_size };
+  for (size_t j = 0; j < 2; ++j) {
+    for (size_t i = 0; i < sizes[j]; ++i)
+      secrets[j][i] = 0;
+  }
+}
+
+void seal_copy(void* dest, const void* source, size_t size,
+    const uint8_t* key, const uint8_t* iv, const void* aad, size_t aad_size,
+    uint8_t* tag) {
+  struct AES_gcm_ctx gcm;
+  uint8_t chunk[sealing_chunk_size];
+  AES_GCM_init_ctx(&gcm, key);
+  AES_GCM_start(&gcm, iv, (const uint8_t*)aad, aad_size);
+
+  for (size_t offset = 0; offset < size; offset += sealing_chunk_size) {
+    size_t chunk_size = size - offset;
+    if (chunk_size > sealing_chunk_size)
+      chunk_size = sealing_chunk_size;
+    memcpy(chunk, (const uint8_t*)source + offset, chunk_size);
+    AES_GCM_encrypt_buffer(&gcm, chunk, chunk_size);
+    memcpy((uint8_t*)dest + offset, chunk, chunk_size);
+  }
+  AES_GCM_finish(&gcm, tag);
+
+  wipe_sealing_state(&gcm, chunk);
+}
+
+bool unseal_copy(void* dest, const void* source, size_t size,
+    const uint8_t* key, const uint8_t* iv, const void* aad, size_t aad_size,
+    const uint8_t* tag) {
+  struct AES_gcm_ctx gcm;
+  uint8_t chunk[sealing_chunk_size];
+  AES_GCM_init_ctx(&gcm, key);
+  AES_GCM_start(&gcm, iv, (const uint8_t*)aad, aad_size);
+
+  for (size_t offset = 0; offset < size; offset += sealing_chunk_size) {
+    size_t chunk_size = size - offset;
+    if (chunk_size > sealing_chunk_size)
+      chunk_size = sealing_chunk_size;
+    memcpy(chunk, (const uint8_t*)source + offset, chunk_size);
+    AES_GCM_decrypt_buffer(&gcm, chunk, chunk_size);
+    memcpy((uint8_t*)dest + offset, chunk, chunk_size);
+  }
+  bool authentic = AES_GCM_check_tag(&gcm, tag);
+  if (!authentic)
+    memset(dest, 0, size);
+
+  wipe_sealing_state(&gcm, chunk);
+  return authentic;
+}
@@ -0,0 +1,37 @@
+#ifndef CRYPTO_SEALING_H_INCLUDED
+#define CRYPTO_SEALING_H_INCLUDED
+
+#include <arch/base_types.h>
+#include "aes/aes.h"
+
+// Authenticated encryption for data that the monitor hands to untrusted
+// memory, such as evicted enclave pages.
+//
+// Data is sealed with AES-GCM in a single pass. It moves from the source to
+// the destination through a stack buffer, and each run of blocks is hashed
+// while it is in the buffer. Every byte of the source and of the destination
+// is accessed once, so an untrusted source cannot make the tag cover other
+// data than what was decrypted.
+
+// The sizes of sealing keys, IVs and tags, in bytes.
+#define sealing_key_size AES_KEYLEN
+#define sealing_iv_size AES_GCM_IVLEN
+#define sealing_tag_size AES_GCM_TAGLEN
+
+// Encrypts `size` bytes from `source` to `dest`, and writes the tag that
+// authenticates them together with `aad`.
+//
+// An IV must never be used twice with the same key.
+void seal_copy(void* dest, const void* source, size_t size,
+    const uint8_t* key, const uint8_t* iv, const void* aad, size_t aad_size,
+    uint8_t* tag);
+
+// Decrypts `size` bytes sealed by seal_copy() from `source` to `dest`.
+//
+// Returns true if `tag` authenticates the data and `aad`. Otherwise, returns
+// false and clears `dest`.
+bool unseal_copy(void* dest, const void* source, size_t size,
+    const uint8_t* key, const uint8_t* iv, const void* aad, size_t aad_size,
+    const uint8_t* tag);
+
+#endif  // !defined(CRYPTO_SEALING_H_INCLUDED)
@@ -0,0 +1,63 @@
+#include "signing_key.h"
+#include "ed25519/ed25519.h"
+#include "sha3/sha3.h"
+
+extern uint8_t PK_SM[32];
+extern uint8_t SK_SM[64];
+
+static ed25519_sign_ctx_t g_monitor_sign_ctx;
+
+// The root of derive_monitor_key(). This is a hash of SK_SM, so it tells
+// nothing about the signing key.
+static uint8_t g_monitor_derivation_secret[monitor_derived_key_max_size];
+
+// Separates the derivation secret from other hashes of SK_SM.
+static const char g_derivation_secret_label[] =
+    "sanctum monitor key derivation";
+
+void init_monitor_signing_key() {
+  ed25519_sign_ctx_init(&g_monitor_sign_ctx, PK_SM, SK_SM);
+
+  sha3_ctx_t hash;
+  sha3_init(&hash, sizeof(g_monitor_derivation_secret));
+  sha3_update(&hash, g_derivation_secret_label,
+      sizeof(g_derivation_secret_label));
+  sha3_update(&hash, SK_SM, sizeof(SK_SM));
+  sha3_final(g_monitor_derivation_secret, &hash);
+
+  volatile uint8_t* secret_key = SK_SM;
+  for (size_t i = 0; i < sizeof(SK_SM); ++i)
+    secret_key[i] = 0;
+}
+
+void sign_with_monitor_key(uint8_t* signature, const void* message,
+    size_t message_size) {
+  ed25519_sign_ctx(signature, (const unsigned char*)message, message_size,
+      &g_monitor_sign_ctx);
+}
+
+void derive_monitor_key(uint8_t* key, size_t key_size, const void* label,
+    size_t label_size) {
+  uint8_t digest[monitor_derived_key_max_size];
+  sha3_ctx_t hash;
+  sha3_init(&hash, sizeof(digest));
+  sha3_update(&hash, g_monitor_derivation_secret,
+      sizeof(g_monitor_derivation_secret));
+  sha3_update(&hash, label, label_size);
+  sha3_final(digest, &hash);
+
+  volatile uint8_t* secret = digest;
+  for (size_t i = 0; i < sizeof(digest); ++i) {
+    if (i < key_size)
+      key[i] = secret[i];
+    secret[i] = 0;
+  }
+}
+
+void wipe_monitor_signing_key() {
+  ed25519_sign_ctx_wipe(&g_monitor_sign_ctx);
+
+  volatile uint8_t* secret = g_monitor_derivation_secret;
+  for (size_t i = 0; i < sizeof(g_monitor_derivation_secret); ++i)
+    secret[i] = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef CRYPTO_SIGNING_KEY_H_INCLUDED
+#define CRYPTO_SIGNING_KEY_H_INCLUDED
+
+#include <arch/base_types.h>
+
+// The monitor's attestation signing key.
+//
+// The bootloader leaves SK_SM and PK_SM in the monitor's header. At boot, the
+// key is prepared once into a signing context in monitor memory, and SK_SM is
+// cleared, so the context is the only copy of the secret key afterwards.
+//
+// Before SK_SM is cleared, a hash of it is also kept as the root of the keys
+// that the monitor derives for its own use, such as the keys that protect
+// evicted enclave pages.
+
+// The size of a signature produced by sign_with_monitor_key(), in bytes.
+#define monitor_signature_size 64
+
+// The maximum size of a key produced by derive_monitor_key(), in bytes.
+#define monitor_derived_key_max_size 64
+
+// Prepares the signing context and the key derivation secret from SK_SM and
+// PK_SM, and clears SK_SM.
+//
+// This must be called once, on a single hart, before any other hart can call
+// sign_with_monitor_key().
+void init_monitor_signing_key();
+
+// Signs a message with SK_SM.
+//
+// The context is read-only after init_monitor_signing_key(), so this can run
+// on several harts at once.
+void sign_with_monitor_key(uint8_t* signature, const void* message,
+    size_t message_size);
+
+// Derives a secret key from SK_SM.
+//
+// The key is SHA3-512 over the derivation secret followed by `label`,
+// truncated to `key_size` bytes, which cannot exceed
+// monitor_derived_key_max_size. Each use of a derived key must have its own
+// label, and the label must include everything that tells apart the instances
+// of that use.
+//
+// Like signing, this only reads state set up by init_monitor_signing_key(), so
+// it can run on several harts at once.
+void derive_monitor_key(uint8_t* key, size_t key_size, const void* label,
+    size_t label_size);
+
+// Clears the signing context and the key derivation secret.
+//
+// No signatures or derived keys can be produced afterwards. poweroff() calls
+// this, so the keys are gone whichever way the monitor stops.
+void wipe_monitor_signing_key();
+
+#endif  // !defined(CRYPTO_SIGNING_KEY_H_INCLUDED)
@@ -51,6 +51,18 @@ void ecall_from_enclave_trap(uintptr_t* regs, uintptr_t mcause, uintptr_t mepc)
       retval = send_message((enclave_id_t)arg0, (mailbox_id_t)arg1,
           (uintptr_t)arg2);
       break;
+    case UBI_SM_ENCLAVE_ATTEST_ENCLAVE:
+      retval = attest_enclave((uintptr_t)arg0);
+      break;
+    case UBI_SM_ENCLAVE_X25519_KEY_AGREEMENT:
+      retval = x25519_key_agreement((uintptr_t)arg0);
+      break;
+    case UBI_SM_ENCLAVE_GET_RANDOM:
+      retval = get_random((uintptr_t)arg0, (size_t)arg1);
+      break;
+    case UBI_SM_ENCLAVE_BLOCK_DRAM_REGIONS:
+      retval = block_dram_regions((uintptr_t)arg0);
+      break;
     default:
       retval = -ENOSYS;
       break;
@@ -1,4 +1,5 @@
 #include "logo.h"
+#include <crypto/signing_key.h>
 #include <machine/mtrap.h>
 #include <machine/atomic.h>
 #include <machine/vm.h>
@@ -45,6 +46,7 @@ void boot_loader(uintptr_t dtb)
 {
   extern char _payload_start;
   filter_dtb(dtb);
+  init_monitor_signing_key();
   print_logo();
   mb();
   entry_point = &_payload_start;
@@ -28,6 +28,14 @@
 #define UBI_SM_ENCLAVE_READ_MESSAGE           1006
 #define UBI_SM_ENCLAVE_SEND_MESSAGE           1007
 
+#define UBI_SM_ENCLAVE_ATTEST_ENCLAVE         1008
+
+#define UBI_SM_ENCLAVE_X25519_KEY_AGREEMENT   1009
+
+#define UBI_SM_ENCLAVE_GET_RANDOM             1010
+
+#define UBI_SM_ENCLAVE_BLOCK_DRAM_REGIONS     1011
+
 // SM CALLS FROM OS (these come from S-mode)
 #define SBI_SM_OS_BLOCK_DRAM_REGION           2000
 
@@ -60,4 +68,17 @@
 
 #define SBI_SM_OS_COPY_DEBUG_ENCLAVE_PAGE     2021
 
+#define SBI_SM_OS_ASSIGN_PAGING_PAGE          2022
+#define SBI_SM_OS_FREE_PAGING_PAGE            2023
+#define SBI_SM_OS_EVICT_ENCLAVE_PAGE          2024
+#define SBI_SM_OS_RELOAD_ENCLAVE_PAGE         2025
+
+#define SBI_SM_OS_GET_RANDOM                  2026
+
+#define SBI_SM_OS_CLEAN_DRAM_REGION           2027
+
+#define SBI_SM_OS_ASSIGN_DRAM_REGIONS         2028
+#define SBI_SM_OS_BLOCK_DRAM_REGIONS          2029
+#define SBI_SM_OS_FREE_DRAM_REGIONS           2030
+
 #endif
@@ -0,0 +1,156 @@
+#include "attestation.h"
+
+#include <arch/cpu_context.h>
+#include "cpu_core_inl.h"
+#include "dram_regions_inl.h"
+#include "enclave.h"
+#include "metadata_inl.h"
+
+static attestation_batches_t g_attestation;
+
+// Copies the bytes of a leaf or a report field.
+//
+// NOTE: arch/memory.h's bzero() and bcopy() collide with <string.h>, so the
+//       small copies in this file are plain byte loops.
+static void copy_attestation_bytes(void* dest, const void* source,
+    size_t size) {
+  uint8_t* dest_bytes = (uint8_t*)dest;
+  const uint8_t* source_bytes = (const uint8_t*)source;
+  for (size_t i = 0; i < size; ++i)
+    dest_bytes[i] = source_bytes[i];
+}
+
+// Zeroes the bytes of a leaf or a tree node.
+static void zero_attestation_bytes(void* dest, size_t size) {
+  uint8_t* dest_bytes = (uint8_t*)dest;
+  for (size_t i = 0; i < size; ++i)
+    dest_bytes[i] = 0;
+}
+
+// Finds a leaf in a batch.
+//
+// Returns true and sets `leaf_index` if the batch has a leaf with the given
+// hash.
+static bool find_attestation_leaf(attestation_batch_t* batch,
+    const uint8_t* leaf_hash, size_t* leaf_index) {
+  for (size_t i = 0; i < batch->leaf_count; ++i) {
+    const uint8_t* node = batch->nodes[attestation_batch_size + i];
+    size_t byte = 0;
+    while (byte < merkle_hash_size && node[byte] == leaf_hash[byte])
+      ++byte;
+    if (byte == merkle_hash_size) {
+      *leaf_index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Signs the open batch, which becomes the signed batch.
+//
+// The caller must hold the attestation lock.
+static void sign_open_attestation_batch() {
+  attestation_batch_t* batch = &g_attestation.batch[g_attestation.open_batch];
+
+  // Unused leaves are all zeros, which no leaf hash is.
+  for (size_t i = batch->leaf_count; i < attestation_batch_size; ++i)
+    zero_attestation_bytes(batch->nodes[attestation_batch_size + i],
+        merkle_hash_size);
+
+  merkle_compute_tree(batch->nodes, attestation_batch_depth);
+  sign_with_monitor_key(batch->root_signature, batch->nodes[1],
+      merkle_hash_size);
+
+  g_attestation.open_batch ^= 1;
+  g_attestation.batch[g_attestation.open_batch].leaf_count = 0;
+}
+
+// Finds the report with the given leaf hash in the signed batch, submitting
+// it if necessary.
+//
+// Returns monitor_concurrent_call if the report is waiting for its batch to
+// be signed. The caller must hold the attestation lock.
+static api_result_t find_signed_attestation(const uint8_t* leaf_hash,
+    attestation_batch_t** signed_batch, size_t* leaf_index) {
+  *signed_batch = &g_attestation.batch[g_attestation.open_batch ^ 1];
+  if (find_attestation_leaf(*signed_batch, leaf_hash, leaf_index))
+    return monitor_ok;
+
+  attestation_batch_t* batch = &g_attestation.batch[g_attestation.open_batch];
+  uint64_t now = read_real_time();
+  if (!find_attestation_leaf(batch, leaf_hash, leaf_index)) {
+    if (batch->leaf_count == attestation_batch_size) {
+      sign_open_attestation_batch();
+      batch = &g_attestation.batch[g_attestation.open_batch];
+    }
+    if (batch->leaf_count == 0)
+      batch->opened_at = now;
+    copy_attestation_bytes(
+        batch->nodes[attestation_batch_size + batch->leaf_count], leaf_hash,
+        merkle_hash_size);
+    batch->leaf_count += 1;
+  }
+
+  if (batch->leaf_count < attestation_batch_size &&
+      now - batch->opened_at < SM_ATTESTATION_BATCH_WINDOW) {
+    return monitor_concurrent_call;
+  }
+
+  sign_open_attestation_batch();
+  *signed_batch = &g_attestation.batch[g_attestation.open_batch ^ 1];
+  find_attestation_leaf(*signed_batch, leaf_hash, leaf_index);
+  return monitor_ok;
+}
+
+api_result_t attest_enclave(uintptr_t phys_addr) {
+  enclave_id_t enclave_id = current_enclave();
+  if (enclave_id == null_enclave_id)
+    return monitor_invalid_state;
+
+  size_t dram_region;
+  api_result_t result = lock_enclave_buffer(enclave_id, phys_addr,
+      sizeof(attestation_report_t), &dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  enclave_info_t* enclave_info = (enclave_info_t*)enclave_id;
+  if (enclave_info->is_initialized == 0) {
+    clear_dram_region_lock(dram_region);
+    return monitor_invalid_state;
+  }
+
+  // NOTE: The leaf is recomputed from the enclave's measurement and the data
+  //       in its report on every call, so a report is only handed back to an
+  //       enclave with the same measurement that asks for the same data.
+  attestation_report_t* report = (attestation_report_t*)phys_addr;
+  attestation_leaf_t leaf;
+  zero_attestation_bytes(leaf.enclave_hash, measurement_size);
+  copy_attestation_bytes(leaf.enclave_hash, &(enclave_info->hash),
+      hash_result_size);
+  copy_attestation_bytes(leaf.data, report->data, attestation_data_size);
+  uint8_t leaf_hash[merkle_hash_size];
+  merkle_hash_leaf(leaf_hash, &leaf, sizeof(leaf));
+
+  if (atomic_flag_test_and_set(&g_attestation.lock)) {
+    clear_dram_region_lock(dram_region);
+    return monitor_concurrent_call;
+  }
+
+  attestation_batch_t* batch;
+  size_t leaf_index;
+  result = find_signed_attestation(leaf_hash, &batch, &leaf_index);
+  if (result == monitor_ok) {
+    copy_attestation_bytes(report->enclave_hash, leaf.enclave_hash,
+        measurement_size);
+    copy_attestation_bytes(report->data, leaf.data, attestation_data_size);
+    report->leaf_index = leaf_index;
+    merkle_read_path(report->path, batch->nodes, attestation_batch_depth,
+        leaf_index);
+    copy_attestation_bytes(report->root_signature, batch->root_signature,
+        monitor_signature_size);
+  }
+
+  atomic_flag_clear(&g_attestation.lock);
+  clear_dram_region_lock(dram_region);
+  return result;
+}
@@ -0,0 +1,52 @@
+#ifndef MONITOR_ATTESTATION_H_INCLUDED
+#define MONITOR_ATTESTATION_H_INCLUDED
+
+#include <arch/base_types.h>
+#include <arch/atomics.h>
+#include <crypto/merkle_tree.h>
+#include <crypto/signing_key.h>
+#include <public/api.h>
+
+// The data hashed into an attestation batch leaf.
+//
+// This matches the first fields of attestation_report_t.
+typedef struct {
+  uint8_t enclave_hash[measurement_size];
+  uint8_t data[attestation_data_size];
+} attestation_leaf_t;
+
+// A batch of attestation reports that share one signature.
+typedef struct {
+  // Number of leaves used so far.
+  size_t leaf_count;
+
+  // The real time when the first leaf was added.
+  uint64_t opened_at;
+
+  // The Merkle tree over the batch, laid out as in crypto/merkle_tree.h.
+  //
+  // Leaf hashes are filled in as reports are submitted. The rest of the tree
+  // is computed when the batch is signed.
+  uint8_t nodes[2 * attestation_batch_size][merkle_hash_size];
+
+  // The signature over the tree root. Only valid once the batch is signed.
+  uint8_t root_signature[monitor_signature_size];
+} attestation_batch_t;
+
+// The monitor's attestation batches.
+//
+// One batch collects new reports, while the other holds the last signed batch,
+// whose reports are handed back to the enclaves that poll for them. Signing
+// the open batch discards the previous signed batch. Enclaves that had not
+// collected their reports yet find them missing, and have them resubmitted.
+typedef struct {
+  // Protects this structure from data races.
+  atomic_flag lock;
+
+  // The index of the batch collecting new reports.
+  size_t open_batch;
+
+  attestation_batch_t batch[2];
+} attestation_batches_t;
+
+#endif  // !defined(MONITOR_ATTESTATION_H_INCLUDED)
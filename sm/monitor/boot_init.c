@@ -1,6 +1,7 @@
 #include "boot_init.h"
 #include "metadata.h"
 #include "cpu_core.h"
+#include "scrub.h"
 #include <arch/bit_masking.h>
 #include <arch/memory.h>
 
@@ -108,12 +109,26 @@ void boot_init_dynamic_arrays() {
   g_core_count = read_core_count();
   g_core = (core_info_t*)g_monitor_top;
   g_monitor_top = (g_core + g_core_count);
+  for (size_t i = 0; i < g_core_count; ++i) {
+    core_info_t* core = g_core + i;
+    core->batch_regions = (size_t*)g_monitor_top;
+    core->batch_dirty_regions = core->batch_regions +
+        g_dram_region_bitmap_words;
+    g_monitor_top = (core->batch_dirty_regions + g_dram_region_bitmap_words);
+
+    // NOTE: DRAM is not necessarily erased at boot, so the generator is cleared
+    //       before the seed is mixed in.
+    for (size_t j = 0; j < sizeof(core->drbg.st.q) / sizeof(uint64_t); ++j)
+      core->drbg.st.q[j] = 0;
+    seed_core_random(core, i);
+  }
 
   g_dram_region = (dram_region_info_t*)g_monitor_top;
   g_monitor_top = (g_dram_region + g_dram_region_count);
   for (size_t i = 0; i < g_dram_region_count; ++i) {
     dram_region_info_t* region = g_dram_region + i;
-    atomic_flag_clear(region->lock);
+    atomic_flag_clear(&region->lock);
+    atomic_init(&region->owner_sequence, 0);
     region->owner = null_enclave_id;
     region->previous_owner = null_enclave_id;
     region->pinned_pages = 0;
@@ -122,12 +137,21 @@ void boot_init_dynamic_arrays() {
 
   g_dram_regions = (dram_regions_info_t*)g_monitor_top;
   g_monitor_top = (g_dram_regions + 1);
-  atomic_init(g_dram_regions->block_clock, 0);
+  atomic_init(&(g_dram_regions->block_clock), 0);
+  atomic_init(&g_dram_regions->dirty_region_count, 0);
+  g_dram_regions->dirty_regions = (size_t*)g_monitor_top;
+  g_monitor_top = (g_dram_regions->dirty_regions + g_dram_region_bitmap_words);
+  fill_bitmap(g_dram_regions->dirty_regions, g_dram_region_count, false);
 
   g_os_region_bitmap = (size_t*)g_monitor_top;
   g_monitor_top = (g_os_region_bitmap + g_dram_region_bitmap_words);
-  for (size_t i = 0; i < g_dram_region_count; ++i)
-    set_bitmap_bit(g_os_region_bitmap, i, 1);
+  fill_bitmap(g_os_region_bitmap, g_dram_region_count, true);
+
+  g_scrub.regions = (size_t*)g_monitor_top;
+  g_monitor_top = (g_scrub.regions + g_dram_region_count);
+  atomic_flag_clear(&g_scrub.lock);
+  atomic_init(&g_scrub.active, 0);
+  atomic_init(&g_scrub.helpers, 0);
 }
 
 void boot_init_protection() {
@@ -4,6 +4,7 @@
 #include <arch/base_types.h>
 #include <arch/cpu_context.h>
 #include <arch/atomics.h>
+#include <crypto/drbg.h>
 #include <public/api.h>
 #include "enclave.h"
 
@@ -23,6 +24,20 @@ typedef struct {
   // The value of block_clock when this core's TLB was last flushed.
   // This is read on other cores,
   size_t flushed_at;
+
+  // The random generator that serves get_random() calls on this core.
+  //
+  // Every generator is seeded from the TRNG at boot, and each core reseeds its
+  // own generator when it runs out. The generators never share state.
+  drbg_state_t drbg;
+
+  // Scratch DRAM region bitmaps used by the batched DRAM region calls.
+  //
+  // Each has g_dram_region_bitmap_words words, allocated at boot time. The
+  // caller's bitmap is copied into batch_regions before it is checked, so the
+  // caller cannot change the batch while the call runs.
+  size_t* batch_regions;
+  size_t* batch_dirty_regions;
 } core_info_t;
 
 // Core costants.
@@ -34,4 +49,10 @@ extern core_info_t* g_core;
 
 extern size_t g_core_count;
 
+// Seeds a core's random generator from the TRNG.
+//
+// `core` is the index of the core that owns the generator. This is called for
+// every core during boot, and by get_random() when a generator needs a reseed.
+void seed_core_random(core_info_t* core_info, size_t core);
+
 #endif  // !defined(MONITOR_CPU_CORE_H_INCLUDED)
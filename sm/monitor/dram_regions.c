@@ -4,6 +4,7 @@
 #include "dram_regions_inl.h"
 #include "enclave_inl.h"
 #include "metadata_inl.h"
+#include "scrub.h"
 
 dram_region_info_t* g_dram_region = 0;
 dram_regions_info_t* g_dram_regions = 0;
@@ -22,6 +23,89 @@ size_t g_dram_region_bitmap_words;
 size_t g_dma_range_start;
 size_t g_dma_range_end;
 
+// Checks that a locked DRAM region can be handed out, and zeroes it if needed.
+//
+// Free regions are handed out as they are. Dirty regions are zeroed on the
+// spot, with the help of the other cores running the OS, so the caller only
+// pays for scrubbing when the OS ran out of clean regions.
+//
+// Returns false if the region is neither free nor dirty.
+static bool take_free_dram_region(size_t dram_region) {
+  enclave_id_t owner = read_dram_region_owner(dram_region);
+  if (owner == dirty_enclave_id) {
+    scrub_dram_regions(&dram_region, 1);
+    set_dram_region_clean(dram_region);
+    return true;
+  }
+  return owner == free_enclave_id;
+}
+
+// True if the DMA range overlaps a DRAM region.
+//
+// The OS cannot block DRAM regions that its devices can write to.
+static bool dma_range_crosses_dram_region(size_t dram_region) {
+  bool dma_range_crossed = false;
+  uintptr_t region_start = dram_region_start(dram_region);
+  uintptr_t region_end = dram_region_start(dram_region + 1);
+  if (g_dma_range_start >= region_start && g_dma_range_end <= region_end)
+    dma_range_crossed = true;
+  if (g_dma_range_end >= region_start && g_dma_range_end <= region_end)
+    dma_range_crossed = true;
+  if (region_start >= g_dma_range_start && region_start <= g_dma_range_end)
+    dma_range_crossed = true;
+  if (region_end >= g_dma_range_start && region_end <= g_dma_range_end)
+    dma_range_crossed = true;
+  return dma_range_crossed;
+}
+
+// Copies the DRAM region bitmap passed to a batched call into batch_regions.
+//
+// The bitmap has g_dram_region_bitmap_words words, and must be in memory owned
+// by the caller. It must select at least one DRAM region, and every bit past
+// the last DRAM region must be clear.
+static api_result_t read_batch_regions(uintptr_t region_bitmap,
+    size_t* regions) {
+  size_t bitmap_dram_region;
+  api_result_t result = lock_caller_buffer(current_enclave(), region_bitmap,
+      g_dram_region_bitmap_words * sizeof(size_t), &bitmap_dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  const size_t* bitmap = (const size_t*)region_bitmap;
+  for (size_t i = 0; i < g_dram_region_bitmap_words; ++i)
+    regions[i] = bitmap[i];
+  clear_dram_region_lock(bitmap_dram_region);
+
+  const size_t bits_in_size_t = sizeof(size_t) * 8;
+  size_t region_count = count_bitmap_bits(regions, g_dram_region_count);
+  if (region_count == 0 || region_count != count_bitmap_bits(regions,
+      g_dram_region_bitmap_words * bits_in_size_t)) {
+    return monitor_invalid_value;
+  }
+  return monitor_ok;
+}
+
+// Releases the locks of a batch of DRAM regions.
+static void clear_batch_region_locks(size_t* regions) {
+  for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count)
+    clear_dram_region_lock(dram_region);
+}
+
+// Acquires the locks of a batch of DRAM regions, in increasing index order.
+//
+// Returns false if a lock was already held by someone else. In that case, the
+// locks acquired by this call are released before it returns.
+static bool test_and_set_batch_region_locks(size_t* regions) {
+  for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count) {
+    if (test_and_set_dram_region_lock(dram_region)) {
+      for_each_set_bitmap_bit(locked_region, regions, dram_region)
+        clear_dram_region_lock(locked_region);
+      return false;
+    }
+  }
+  return true;
+}
+
 size_t dram_size() {
   return g_dram_size;
 }
@@ -59,28 +143,14 @@ api_result_t block_dram_region(size_t dram_region) {
     return monitor_concurrent_call;
   }
 
-  if (owner_dram_region == 0) {
-    bool dma_range_crossed = false;
-    uintptr_t region_start = dram_region_start(dram_region);
-    uintptr_t region_end = dram_region_start(dram_region + 1);
-    if (g_dma_range_start >= region_start && g_dma_range_end <= region_end)
-      dma_range_crossed = true;
-    if (g_dma_range_end >= region_start && g_dma_range_end <= region_end)
-      dma_range_crossed = true;
-    if (region_start >= g_dma_range_start && region_start <= g_dma_range_end)
-      dma_range_crossed = true;
-    if (region_end >= g_dma_range_start && region_end <= g_dma_range_end)
-      dma_range_crossed = true;
-
-    if (dma_range_crossed) {
-      clear_dram_region_lock(owner_dram_region);
-      clear_dram_region_lock(dram_region);
-      return monitor_invalid_state;
-    }
+  if (owner_dram_region == 0 && dma_range_crosses_dram_region(dram_region)) {
+    clear_dram_region_lock(owner_dram_region);
+    clear_dram_region_lock(dram_region);
+    return monitor_invalid_state;
   }
 
   region->previous_owner = owner;
-  region->owner = blocked_enclave_id;
+  set_dram_region_owner(dram_region, blocked_enclave_id);
   size_t block_clock = atomic_fetch_add(
       &(g_dram_regions->block_clock),
       1);
@@ -98,6 +168,69 @@ api_result_t block_dram_region(size_t dram_region) {
   return monitor_ok;
 }
 
+api_result_t block_dram_regions(uintptr_t region_bitmap) {
+  size_t* regions = current_core_info()->batch_regions;
+  api_result_t result = read_batch_regions(region_bitmap, regions);
+  if (result != monitor_ok)
+    return result;
+  // NOTE: The first DRAM region is the only one that isn't dynamic.
+  if (read_bitmap_bit(regions, 0))
+    return monitor_invalid_value;
+
+  // NOTE: An enclave's main DRAM region always has pinned pages, so it can't
+  //       be blocked. Rejecting it up front keeps the lock sweep below from
+  //       running into the owner region's lock, which is taken first.
+  enclave_id_t owner = current_enclave();
+  size_t owner_dram_region = dram_region_for(owner);
+  if (read_bitmap_bit(regions, owner_dram_region))
+    return monitor_invalid_state;
+  if (test_and_set_dram_region_lock(owner_dram_region))
+    return monitor_concurrent_call;
+  if (!test_and_set_batch_region_locks(regions)) {
+    clear_dram_region_lock(owner_dram_region);
+    return monitor_concurrent_call;
+  }
+
+  result = monitor_ok;
+  for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count) {
+    dram_region_info_t* region = &g_dram_region[dram_region];
+    if (read_dram_region_owner(dram_region) != owner) {
+      result = monitor_access_denied;
+      break;
+    }
+    if (owner != null_enclave_id ? region->pinned_pages != 0 :
+        dma_range_crosses_dram_region(dram_region)) {
+      result = monitor_invalid_state;
+      break;
+    }
+  }
+
+  if (result == monitor_ok) {
+    // NOTE: The whole batch is blocked at the same time, so it needs a single
+    //       tick of the block clock.
+    size_t block_clock = atomic_fetch_add(
+        &(g_dram_regions->block_clock),
+        1);
+    // TODO: panic if block_clock is max_size_t
+    for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count) {
+      dram_region_info_t* region = &g_dram_region[dram_region];
+      region->previous_owner = owner;
+      region->blocked_at = block_clock;
+      set_dram_region_owner(dram_region, blocked_enclave_id);
+    }
+
+    set_enclave_region_bitmap_bits(owner, regions, false);
+    if (owner == 0)
+      set_drb_map(g_os_region_bitmap);
+    else
+      set_edrb_map(enclave_region_bitmap(owner));
+  }
+
+  clear_batch_region_locks(regions);
+  clear_dram_region_lock(owner_dram_region);
+  return result;
+}
+
 api_result_t dram_region_check_ownership(size_t dram_region) {
   if (!is_dynamic_dram_region(dram_region))
     return monitor_invalid_value;
@@ -123,11 +256,9 @@ dram_region_state_t dram_region_state(size_t dram_region) {
   if (!is_valid_dram_region(dram_region))
     return dram_region_invalid;
 
-  if (test_and_set_dram_region_lock(dram_region))
-    return dram_region_locked;
-
+  // NOTE: The state only depends on the owner, so this needs no lock.
   dram_region_state_t state;
-  switch (read_dram_region_owner(dram_region)) {
+  switch (read_dram_region_owner_lock_free(dram_region)) {
   case null_enclave_id:
     state = dram_region_owned;
     break;
@@ -137,11 +268,12 @@ dram_region_state_t dram_region_state(size_t dram_region) {
   case free_enclave_id:
     state = dram_region_free;
     break;
+  case dirty_enclave_id:
+    state = dram_region_dirty;
+    break;
   default:
     state = dram_region_owned;
   }
-
-  clear_dram_region_lock(dram_region);
   return state;
 }
 
@@ -149,14 +281,11 @@ enclave_id_t dram_region_owner(size_t dram_region) {
   if (!is_valid_dram_region(dram_region))
     return null_enclave_id;
 
-  if (test_and_set_dram_region_lock(dram_region))
-    return null_enclave_id;
-
-  enclave_id_t owner = read_dram_region_owner(dram_region);
-  if (owner == blocked_enclave_id || owner == free_enclave_id)
+  enclave_id_t owner = read_dram_region_owner_lock_free(dram_region);
+  if (owner == blocked_enclave_id || owner == free_enclave_id ||
+      owner == dirty_enclave_id) {
     owner = null_enclave_id;
-
-  clear_dram_region_lock(dram_region);
+  }
   return owner;
 }
 
@@ -171,32 +300,31 @@ api_result_t set_dma_range(uintptr_t base, uintptr_t mask) {
   if (test_and_set_dram_region_lock(0))
     return monitor_concurrent_call;
 
+  // NOTE: The OS' DRAM region bitmap only changes while the lock of DRAM
+  //       region 0 is held, so it can be read without locking the regions in
+  //       the DMA range.
   bool os_owns_regions = true;
   uintptr_t range_end = (base | mask) + 1;
-  // NOTE: because DRAM regions might not be contiguous, we iterate over all
-  //       the stripes in the DMA range and check that their DRAM regions are
-  //       owned by the OS
-  for (uintptr_t stripe_addr = base; stripe_addr < range_end;
-       stripe_addr += g_dram_stripe_size) {
-    size_t dram_region = dram_region_for(stripe_addr);
-    if (dram_region != 0) {
-      if (test_and_set_dram_region_lock(dram_region)) {
-        clear_dram_region_lock(0);
-        return monitor_concurrent_call;
-      }
+  // NOTE: relying on the compiler to optimize division to bitwise shift
+  size_t stripe_count = (mask + g_dram_stripe_size) / g_dram_stripe_size;
+  if (stripe_count >= g_dram_region_count) {
+    // Consecutive stripes cycle through all the DRAM regions.
+    os_owns_regions = count_bitmap_bits(g_os_region_bitmap,
+        g_dram_region_count) == g_dram_region_count;
+  } else {
+    // NOTE: because DRAM regions might not be contiguous, we iterate over all
+    //       the stripes in the DMA range and check that their DRAM regions are
+    //       owned by the OS
+    for (uintptr_t stripe_addr = base; stripe_addr < range_end;
+         stripe_addr += g_dram_stripe_size) {
+      size_t dram_region = dram_region_for(stripe_addr);
+      if (!read_bitmap_bit(g_os_region_bitmap, dram_region))
+        os_owns_regions = false;
     }
-    dram_region_info_t* region = &g_dram_region[dram_region];
-    if (region->owner != 0)
-      os_owns_regions = false;
-
-    // NOTE: We're clearing each DRAM region lock after acquiring it, instead
-    //       of acquiring all locks and clearing them. We do this so we don't
-    //       have to do cascade releases if a lock acquisition fails. This is
-    //       acceptable because we hold the lock of DRAM region 0 at all times,
-    //       so we're guaranteed that no enclaves join or leave the group of
-    //       OS-owned enclaves, and that's all we care about.
-    if (dram_region != 0)
-      clear_dram_region_lock(dram_region);
+  }
+  if (!os_owns_regions) {
+    clear_dram_region_lock(0);
+    return monitor_invalid_state;
   }
 
   g_dma_range_start = base;
@@ -216,7 +344,7 @@ api_result_t create_metadata_region(size_t dram_region) {
   if (test_and_set_dram_region_lock(dram_region))
     return monitor_concurrent_call;
 
-  if (read_dram_region_owner(dram_region) != free_enclave_id) {
+  if (!take_free_dram_region(dram_region)) {
     clear_dram_region_lock(dram_region);
     return monitor_invalid_state;
   }
@@ -235,7 +363,8 @@ api_result_t assign_dram_region(size_t dram_region, enclave_id_t new_owner) {
   if (test_and_set_dram_region_lock(dram_region))
     return monitor_concurrent_call;
 
-  if (read_dram_region_owner(dram_region) != free_enclave_id) {
+  enclave_id_t owner = read_dram_region_owner(dram_region);
+  if (owner != free_enclave_id && owner != dirty_enclave_id) {
     clear_dram_region_lock(dram_region);
     return monitor_invalid_state;
   }
@@ -252,8 +381,11 @@ api_result_t assign_dram_region(size_t dram_region, enclave_id_t new_owner) {
 
   api_result_t result;
   if (is_valid_enclave_id(new_owner)) {
-    dram_region_info_t* region = &g_dram_region[dram_region];
-    region->owner = new_owner;
+    // NOTE: The region is only scrubbed once the new owner is known to be
+    //       valid, so failed calls don't stall on a dirty region.
+    take_free_dram_region(dram_region);
+
+    set_dram_region_owner(dram_region, new_owner);
     set_enclave_region_bitmap_bit(new_owner, dram_region, true);
     // NOTE: This is an OS call, so we know for sure that no enclave DRAM
     //       region bitmap is in effect. We only need to apply changes to the
@@ -270,6 +402,62 @@ api_result_t assign_dram_region(size_t dram_region, enclave_id_t new_owner) {
   return result;
 }
 
+api_result_t assign_dram_regions(uintptr_t region_bitmap,
+    enclave_id_t new_owner) {
+  core_info_t* core_info = current_core_info();
+  size_t* regions = core_info->batch_regions;
+  api_result_t result = read_batch_regions(region_bitmap, regions);
+  if (result != monitor_ok)
+    return result;
+
+  // NOTE: The new owner's DRAM region is never free, so a batch that includes
+  //       it is rejected before the sweep would fail on its lock.
+  size_t new_owner_dram_region = dram_region_for(new_owner);
+  if (read_bitmap_bit(regions, new_owner_dram_region))
+    return monitor_invalid_state;
+  if (test_and_set_dram_region_lock(new_owner_dram_region))
+    return monitor_concurrent_call;
+  if (!test_and_set_batch_region_locks(regions)) {
+    clear_dram_region_lock(new_owner_dram_region);
+    return monitor_concurrent_call;
+  }
+
+  size_t* dirty_regions = core_info->batch_dirty_regions;
+  fill_bitmap(dirty_regions, g_dram_region_count, false);
+  for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count) {
+    enclave_id_t owner = read_dram_region_owner(dram_region);
+    if (owner == dirty_enclave_id) {
+      set_bitmap_bit(dirty_regions, dram_region, true);
+    } else if (owner != free_enclave_id) {
+      result = monitor_invalid_state;
+      break;
+    }
+  }
+  if (result == monitor_ok && !is_valid_enclave_id(new_owner))
+    result = monitor_invalid_value;
+
+  if (result == monitor_ok) {
+    // NOTE: The dirty regions are only scrubbed once the whole batch is known
+    //       to be valid, and they are all zeroed by the same scrub job.
+    scrub_dram_region_bitmap(dirty_regions);
+    for_each_set_bitmap_bit(dram_region, dirty_regions, g_dram_region_count)
+      set_dram_region_clean(dram_region);
+
+    for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count)
+      set_dram_region_owner(dram_region, new_owner);
+    set_enclave_region_bitmap_bits(new_owner, regions, true);
+    // NOTE: This is an OS call, so we know for sure that no enclave DRAM
+    //       region bitmap is in effect. We only need to apply changes to the
+    //       OS DRAM region bitmap.
+    if (new_owner == 0)
+      set_drb_map(g_os_region_bitmap);
+  }
+
+  clear_batch_region_locks(regions);
+  clear_dram_region_lock(new_owner_dram_region);
+  return result;
+}
+
 api_result_t free_dram_region(size_t dram_region) {
   // NOTE: non-dynamic DRAM regions will never be blocked, so we don't need to
   //       explicitly check for them here
@@ -298,7 +486,7 @@ api_result_t free_dram_region(size_t dram_region) {
       }
     }
     if (can_free) {
-      region->owner = free_enclave_id;
+      set_dram_region_owner(dram_region, free_enclave_id);
       result = monitor_ok;
     } else {
       result = monitor_invalid_state;
@@ -311,7 +499,7 @@ api_result_t free_dram_region(size_t dram_region) {
     // worry about TLB flushing. However, we do need to make sure they don't
     // have any in-use entries.
     if (region->pinned_pages == 0) {
-      region->owner = free_enclave_id;
+      set_dram_region_owner(dram_region, free_enclave_id);
       result = monitor_ok;
     } else {
       result = monitor_invalid_state;
@@ -324,6 +512,80 @@ api_result_t free_dram_region(size_t dram_region) {
   return result;
 }
 
+api_result_t free_dram_regions(uintptr_t region_bitmap) {
+  size_t* regions = current_core_info()->batch_regions;
+  api_result_t result = read_batch_regions(region_bitmap, regions);
+  if (result != monitor_ok)
+    return result;
+  if (!test_and_set_batch_region_locks(regions))
+    return monitor_concurrent_call;
+
+  // NOTE: A blocked region can be freed once every core's TLB was flushed
+  //       after it was blocked, so the oldest flush is checked against the
+  //       whole batch. See free_dram_region() for details.
+  size_t flushed_at = atomic_load(&(g_core[0].flushed_at));
+  for (size_t i = 1; i < g_core_count; ++i) {
+    size_t core_flushed_at = atomic_load(&(g_core[i].flushed_at));
+    if (core_flushed_at < flushed_at)
+      flushed_at = core_flushed_at;
+  }
+
+  for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count) {
+    enclave_id_t region_owner = read_dram_region_owner(dram_region);
+    dram_region_info_t* region = &g_dram_region[dram_region];
+    if (region_owner == blocked_enclave_id) {
+      if (region->blocked_at > flushed_at) {
+        result = monitor_invalid_state;
+        break;
+      }
+    } else if (region_owner == metadata_enclave_id) {
+      if (region->pinned_pages != 0) {
+        result = monitor_invalid_state;
+        break;
+      }
+    } else {
+      result = monitor_invalid_state;
+      break;
+    }
+  }
+
+  if (result == monitor_ok) {
+    for_each_set_bitmap_bit(dram_region, regions, g_dram_region_count)
+      set_dram_region_owner(dram_region, free_enclave_id);
+  }
+
+  clear_batch_region_locks(regions);
+  return result;
+}
+
+api_result_t clean_dram_region() {
+  if (atomic_load(&(g_dram_regions->dirty_region_count)) == 0)
+    return monitor_invalid_state;
+
+  // NOTE: The dirty region bitmap is read without a lock, and each region's
+  //       owner is checked again once its lock is held.
+  bool saw_locked_region = false;
+  size_t* dirty_regions = g_dram_regions->dirty_regions;
+  for_each_set_bitmap_bit(i, dirty_regions, g_dram_region_count) {
+    if (test_and_set_dram_region_lock(i)) {
+      saw_locked_region = true;
+      continue;
+    }
+    if (read_dram_region_owner(i) != dirty_enclave_id) {
+      clear_dram_region_lock(i);
+      continue;
+    }
+
+    // NOTE: The OS donated this core's time, so the region is zeroed here,
+    //       without interrupting the other cores.
+    bzero_dram_region(i);
+    set_dram_region_clean(i);
+    clear_dram_region_lock(i);
+    return monitor_ok;
+  }
+  return saw_locked_region ? monitor_concurrent_call : monitor_invalid_state;
+}
+
 api_result_t flush_cached_dram_regions() {
   dram_region_tlb_flush();
   return monitor_ok;
@@ -29,6 +29,7 @@
 // Per-DRAM region accounting information.
 typedef struct {
   atomic_flag lock;             // lock for all the DRAM region's state
+  size_t owner_sequence;        // odd while owner is changing; atomic
   enclave_id_t owner;           // nullptr if not owned by enclave
   enclave_id_t previous_owner;  // nullptr if previously owned by OS
   size_t pinned_pages;          // pages that can't be removed from DRAM
@@ -41,6 +42,18 @@ typedef struct {
   //       must be accessible in flush_cached_dram_regions(), which must be
   //       lock-free.
   size_t block_clock; // accesseds atomically
+
+  // The number of DRAM regions owned by dirty_enclave_id.
+  //
+  // This lets clean_dram_region() return right away when there is no work.
+  size_t dirty_region_count; // accessed atomically
+
+  // The DRAM regions owned by dirty_enclave_id, as a region bitmap.
+  //
+  // A region's bit is updated atomically, while holding the region's lock,
+  // together with its owner, so clean_dram_region() can find the dirty regions
+  // without scanning every region's owner.
+  size_t* dirty_regions;
 } dram_regions_info_t;
 
 // The regions are allocated at boot time, so the physical pointers never
@@ -123,4 +136,8 @@ extern size_t g_dma_range_end;
 // The enclave ID used as the owner of a free DRAM region.
 #define free_enclave_id 3
 
+// The enclave ID used as the owner of a free DRAM region that must be zeroed
+// before it is handed out, because it still holds a deleted enclave's data.
+#define dirty_enclave_id 4
+
 #endif  // !defined(MONITOR_DRAM_REGIONS_H_INCLUDED)
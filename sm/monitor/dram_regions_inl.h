@@ -83,7 +83,7 @@ static inline size_t dram_region_page_for(uintptr_t address) {
 // someone else.
 static inline bool test_and_set_dram_region_lock(size_t dram_region) {
   dram_region_info_t* region = &g_dram_region[dram_region];
-  return atomic_flag_test_and_set(region->lock);
+  return atomic_flag_test_and_set(&region->lock);
 }
 
 // Releases the lock for a DRAM region.
@@ -94,7 +94,7 @@ static inline bool test_and_set_dram_region_lock(size_t dram_region) {
 // because another piece of code might have acquired the lock.
 static inline void clear_dram_region_lock(size_t dram_region) {
   dram_region_info_t* region = &g_dram_region[dram_region];
-  atomic_flag_clear(region->lock);
+  atomic_flag_clear(&region->lock);
 }
 
 // Reads the owner from a DRAM region.
@@ -105,6 +105,73 @@ static inline enclave_id_t read_dram_region_owner(size_t dram_region) {
   return region->owner;
 }
 
+// Changes the owner of a DRAM region.
+//
+// Invalid DRAM region indices will cause memory thrashing.
+//
+// The caller must hold the DRAM region's lock. The owner sequence is odd while
+// the owner changes, so read_dram_region_owner_lock_free() can tell when it
+// raced with this.
+static inline void set_dram_region_owner(size_t dram_region,
+    enclave_id_t owner) {
+  dram_region_info_t* region = &g_dram_region[dram_region];
+  // NOTE: atomic_fetch_add() is a full fence, so the owner store can't move
+  //       outside the two sequence updates.
+  atomic_fetch_add(&(region->owner_sequence), 1);
+  region->owner = owner;
+  atomic_fetch_add(&(region->owner_sequence), 1);
+}
+
+// Flips a DRAM region's bit in the dirty region bitmap.
+static inline void set_dram_region_dirty_bit(size_t dram_region, bool dirty) {
+  const size_t bits_in_size_t = sizeof(size_t) * 8;
+
+  // NOTE: relying on the compiler to optimize division to bitwise shift
+  size_t* word = g_dram_regions->dirty_regions + dram_region / bits_in_size_t;
+  const size_t mask = (size_t)1 << (dram_region % bits_in_size_t);
+  if (dirty)
+    atomic_fetch_or(word, mask);
+  else
+    atomic_fetch_and(word, ~mask);
+}
+
+// Hands a locked DRAM region, whose contents must be zeroed before it can be
+// reused, over to dirty_enclave_id.
+static inline void set_dram_region_dirty(size_t dram_region) {
+  set_dram_region_owner(dram_region, dirty_enclave_id);
+  atomic_fetch_add(&(g_dram_regions->dirty_region_count), 1);
+  set_dram_region_dirty_bit(dram_region, true);
+}
+
+// Marks a locked dirty DRAM region as free, once it has been zeroed.
+static inline void set_dram_region_clean(size_t dram_region) {
+  set_dram_region_dirty_bit(dram_region, false);
+  set_dram_region_owner(dram_region, free_enclave_id);
+  atomic_fetch_sub(&(g_dram_regions->dirty_region_count), 1);
+}
+
+// Reads the owner from a DRAM region, without holding its lock.
+//
+// Invalid DRAM region indices will cause memory reads outside the DRAM space.
+//
+// This retries until it reads an owner that no set_dram_region_owner() call
+// was changing at the time. It never takes the DRAM region's lock, so polling
+// callers don't slow down the calls that change the owner.
+static inline enclave_id_t read_dram_region_owner_lock_free(
+    size_t dram_region) {
+  dram_region_info_t* region = &g_dram_region[dram_region];
+  while (true) {
+    size_t sequence = atomic_load(&(region->owner_sequence));
+    atomic_thread_fence();
+    enclave_id_t owner = region->owner;
+    atomic_thread_fence();
+    if ((sequence & 1) == 0 &&
+        atomic_load(&(region->owner_sequence)) == sequence) {
+      return owner;
+    }
+  }
+}
+
 // Wipes the data in a DRAM region.
 //
 // Invalid DRAM region indices will cause memory trashing.
@@ -129,10 +196,10 @@ static inline void dram_region_tlb_flush() {
   //       flushed; the moment the counter is incremented, some DRAM region may
   //       be freed and reallocated; this sequence is
 
-  const core_info_t* core_info = &g_core[current_core()];
+  core_info_t* core_info = &g_core[current_core()];
   const size_t block_clock = atomic_load(
       &(g_dram_regions->block_clock));
-  atomic_store(core_info->flushed_at, block_clock);
+  atomic_store(&(core_info->flushed_at), block_clock);
 }
 
 #endif  // !defined(MONITOR_DRAM_REGIONS_INL_H_INCLUDED)
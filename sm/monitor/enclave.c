@@ -26,26 +26,34 @@ api_result_t delete_enclave(enclave_id_t enclave_id) {
     clear_dram_region_lock(dram_region);
     return monitor_invalid_state;
   }
+  // NOTE: A loading call may still be hashing the enclave's pages after
+  //       releasing the DRAM region lock. hash_lock stays set if we succeed,
+  //       as the enclave is going away.
+  if (atomic_flag_test_and_set(&enclave_info->hash_lock)) {
+    clear_dram_region_lock(dram_region);
+    return monitor_concurrent_call;
+  }
 
+  // NOTE: The scans below only visit the regions that belong to the enclave.
   size_t* region_bitmap = enclave_region_bitmap(enclave_id);
-  size_t region_iterator = 0;
-  for (; region_iterator < g_dram_region_count; ++region_iterator) {
+  size_t region_iterator =
+      next_set_bitmap_bit(region_bitmap, g_dram_region_count, 0);
+  for (; region_iterator < g_dram_region_count; region_iterator =
+      next_set_bitmap_bit(region_bitmap, g_dram_region_count,
+          region_iterator + 1)) {
     if (region_iterator == dram_region)
       continue;  // We've already locked the enclave's main DRAM region.
-    if (!read_bitmap_bit(region_bitmap, region_iterator))
-      continue;  // This region does not belong to the enclave.
     if (test_and_set_dram_region_lock(region_iterator))
       break;  // Failed to acquire lock on region.
   }
   if (region_iterator < g_dram_region_count) {
     // We failed to acquire a DRAM region lock. Unlock everything we touched.
-    for (size_t i = 0; i < region_iterator; ++i) {
+    for_each_set_bitmap_bit(i, region_bitmap, region_iterator) {
       if (i == dram_region)
         continue;  // We've already locked the enclave's main DRAM region.
-      if (!read_bitmap_bit(region_bitmap, i))
-        continue;  // This region does not belong to the enclave.
       clear_dram_region_lock(i);
     }
+    atomic_flag_clear(&enclave_info->hash_lock);
     clear_dram_region_lock(dram_region);
     return monitor_concurrent_call;
   }
@@ -53,12 +61,12 @@ api_result_t delete_enclave(enclave_id_t enclave_id) {
   // NOTE: we know that no enclave thread is running, so we can free the
   //       enclave's DRAM regions directly, without going through the blocking
   //       state
-  for (size_t i = 0; i < g_dram_region_count; ++i) {
-    if (!read_bitmap_bit(region_bitmap, region_iterator))
-      continue;  // This region does not belong to the enclave.
-
+  //
+  // NOTE: The regions still hold the enclave's data. They are zeroed later,
+  //       by clean_dram_region(), or when they are handed out again.
+  for_each_set_bitmap_bit(i, region_bitmap, g_dram_region_count) {
     dram_region_info_t* region = &g_dram_region[i];
-    region->owner = free_enclave_id;
+    set_dram_region_dirty(i);
 
     // NOTE: The enclave's DRAM regions have pages and pinned pages, due to
     //       threads. The rest of the system assumes that pinned_pages is zero
@@ -66,15 +74,11 @@ api_result_t delete_enclave(enclave_id_t enclave_id) {
     //       prerequisite to the DRAM region being freed. So, we must make sure
     //       that pinned_pages is zero for the DRAM regions that we free.
     region->pinned_pages = 0;
-
-    bzero_dram_region(i);
   }
 
-  for (size_t i = 0; i < g_dram_region_count; ++i) {
+  for_each_set_bitmap_bit(i, region_bitmap, g_dram_region_count) {
     if (i == dram_region)
       continue;  // We've already locked the enclave's main DRAM region.
-    if (!read_bitmap_bit(region_bitmap, i))
-      continue;  // This region does not belong to the enclave.
     clear_dram_region_lock(i);
   }
   clear_dram_region_lock(dram_region);
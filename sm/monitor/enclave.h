@@ -5,6 +5,7 @@
 #include <arch/cpu_context.h>
 #include <arch/atomics.h>
 #include <crypto/hash.h>
+#include <crypto/sealing.h>
 #include <public/api.h>
 
 // The per-thread information stored in metadata regions.
@@ -37,6 +38,29 @@ typedef struct {
   size_t can_resume;            // true if the AEX state is valid
 } thread_info_t;
 
+// A loading operation whose measurement has been deferred.
+//
+// See the measurement journal in enclave_info_t.
+typedef struct {
+  size_t opcode;  // load_page_table_opcode or load_page_opcode.
+  uintptr_t virtual_addr;
+  uintptr_t acl;
+  size_t level;  // Only used by load_page_table.
+  uintptr_t phys_addr;  // The page to be hashed, for load_page.
+} measurement_record_t;
+
+// Non-zero builds the measurement journal that load_page and load_page_table
+// use to hash pages outside the enclave's DRAM region lock.
+//
+// Both calls' loading logic is still disabled in this tree, so nothing appends
+// to the journal, and it is left out of enclave_info_t unless this is set.
+#ifndef ENCLAVE_LOAD_JOURNAL
+#define ENCLAVE_LOAD_JOURNAL 0
+#endif
+
+// The number of records in an enclave's measurement journal.
+#define measurement_journal_size 32
+
 // Per-enclave accounting information.
 //
 // This structure is stored at the beginning of an enclave's main DRAM region,
@@ -94,6 +118,39 @@ typedef struct {
 
   // Working area for the enclave measurement process.
   uint32_t hash_block[hash_block_size / sizeof(uint32_t)];
+
+  // Protects hash and hash_block, and the journal's head.
+  //
+  // This is acquired while holding the lock of the enclave's main DRAM region,
+  // but may be held after that lock is released, while the journal is drained.
+  // Calls that delete or finalize the enclave fail while it is held.
+  atomic_flag hash_lock;
+
+#if ENCLAVE_LOAD_JOURNAL
+  // Loading operations that were validated but not yet hashed, in order.
+  //
+  // load_page and load_page_table append records at journal_tail while
+  // holding the lock of the enclave's main DRAM region, and the holder of
+  // hash_lock hashes them from journal_head, outside that lock. Both indexes
+  // only increase; a record's slot is its index modulo the journal size.
+  size_t journal_head;
+  size_t journal_tail;
+  measurement_record_t journal[measurement_journal_size];
+#endif  // ENCLAVE_LOAD_JOURNAL
+
+  // The sealing key that protects the pages evicted from the enclave.
+  //
+  // This is set by create_enclave(), and derived from the monitor's secret,
+  // the enclave ID, and the number of enclaves created since boot, so every
+  // enclave instance has its own key.
+  uint8_t paging_key[sealing_key_size];
+
+  // The version given to the last page evicted from the enclave.
+  //
+  // Each eviction takes the next version, which makes up the page's sealing
+  // IV, so no IV is used twice under the enclave's paging key. Version 0 marks
+  // free paging slots, and is never used.
+  uint64_t paging_version;
 } enclave_info_t;
 
 // The DRAM region bitmap for the OS.
@@ -7,6 +7,54 @@
 #include "measure_inl.h"
 #include "metadata_inl.h"
 
+#if ENCLAVE_LOAD_JOURNAL
+
+// Makes sure that an enclave's measurement journal can take another record.
+//
+// The caller must hold the lock of the enclave's main DRAM region, and must
+// call this before changing any state. If the journal is full, this releases
+// the DRAM region lock, drains the journal unless another call is draining it,
+// and returns monitor_concurrent_call, so the OS retries the load.
+static inline api_result_t reserve_enclave_journal_record(
+    enclave_info_t* enclave_info, size_t dram_region) {
+  if (!is_enclave_journal_full(enclave_info))
+    return monitor_ok;
+
+  bool drain = !atomic_flag_test_and_set(&enclave_info->hash_lock);
+  clear_dram_region_lock(dram_region);
+  if (drain) {
+    drain_enclave_journal(enclave_info);
+    atomic_flag_clear(&enclave_info->hash_lock);
+  }
+  return monitor_concurrent_call;
+}
+
+// Records a validated loading operation in the enclave's measurement journal,
+// and releases the lock of the enclave's main DRAM region.
+//
+// The caller must hold the lock of the enclave's main DRAM region, and must
+// have reserved the record with reserve_enclave_journal_record(). If the
+// journal is filling up and nobody is draining it, it is drained after the
+// DRAM region lock is released, so other loading calls can proceed meanwhile.
+static inline api_result_t finish_enclave_load(enclave_info_t* enclave_info,
+    size_t dram_region, size_t opcode, uintptr_t virtual_addr, uintptr_t acl,
+    size_t level, uintptr_t phys_addr) {
+  journal_enclave_load(enclave_info, opcode, virtual_addr, acl, level,
+      phys_addr);
+
+  bool drain = should_drain_enclave_journal(enclave_info) &&
+      !atomic_flag_test_and_set(&enclave_info->hash_lock);
+  clear_dram_region_lock(dram_region);
+
+  if (drain) {
+    drain_enclave_journal(enclave_info);
+    atomic_flag_clear(&enclave_info->hash_lock);
+  }
+  return monitor_ok;
+}
+
+#endif  // ENCLAVE_LOAD_JOURNAL
+
 api_result_t load_page_table(enclave_id_t enclave_id,
     uintptr_t phys_addr, uintptr_t virtual_addr, size_t level, size_t acl) {
   if (!is_dram_address(phys_addr))
@@ -66,6 +114,11 @@ api_result_t load_page_table(enclave_id_t enclave_id,
     }
   }
 
+  api_result_t result = reserve_enclave_journal_record(enclave_info,
+      dram_region);
+  if (result != monitor_ok)
+    return result;
+
   // Allocating a page table at level N means walking until level N + 1, and
   // then editing the level N + 1 table to point to our new table.
   size_t edit_level = level + 1;
@@ -89,7 +142,8 @@ api_result_t load_page_table(enclave_id_t enclave_id,
   enclave_info->*(&enclave_info_t::last_load_addr) = phys_end - page_size();
   bzero(size_t*{phys_addr}, table_size);
 
-  extend_enclave_hash_with_page_table(enclave_info, virtual_addr, level, acl);
+  return finish_enclave_load(enclave_info, dram_region,
+      load_page_table_opcode, virtual_addr, acl, level, 0);
   */
 
   clear_dram_region_lock(dram_region);
@@ -148,6 +202,11 @@ api_result_t load_page(enclave_id_t enclave_id, uintptr_t phys_addr,
     return monitor_invalid_state;
   }
 
+  api_result_t result = reserve_enclave_journal_record(enclave_info,
+      dram_region);
+  if (result != monitor_ok)
+    return result;
+
   // NOTE: We're performing the OS DRAM region checks last to minimize the
   //       number of times we have two release two locks when bailing out due
   //       to errors.
@@ -164,7 +223,7 @@ api_result_t load_page(enclave_id_t enclave_id, uintptr_t phys_addr,
 
   // NOTE: Even though we're reading the DRAM region ownership atomically, we
   //       still need to lock the region to make sure that it doesn't go away
-  //       while we bcopy a page out of it.
+  //       while we copy a page out of it.
   dram_region_info_t* region = &g_dram_region[os_dram_region];
   if (read_dram_region_owner(dram_region) != null_enclave_id) {
     clear_dram_region_lock(os_dram_region);
@@ -172,11 +231,14 @@ api_result_t load_page(enclave_id_t enclave_id, uintptr_t phys_addr,
     return monitor_access_denied;
   }
 
+  // NOTE: The page is measured later, from the journal, so the DRAM region
+  //       locks are only held while the page is copied.
   enclave_info->*(&enclave_info_t::last_load_addr) = phys_addr;
-  bcopy(size_t*{phys_addr}, size_t*{os_addr}, page_size());
+  bcopy((void*)phys_addr, (void*)os_addr, page_size());
   clear_dram_region_lock(os_dram_region);
 
-  extend_enclave_hash_with_page(enclave_info, virtual_addr, acl, phys_addr);
+  return finish_enclave_load(enclave_info, dram_region, load_page_opcode,
+      virtual_addr, acl, 0, phys_addr);
   */
   clear_dram_region_lock(dram_region);
   return monitor_ok;
@@ -200,7 +262,13 @@ api_result_t init_enclave(enclave_id_t enclave_id) {
     return monitor_invalid_state;
   }
 
+  if (atomic_flag_test_and_set(&enclave_info->hash_lock)) {
+    clear_dram_region_lock(dram_region);
+    return monitor_concurrent_call;
+  }
+  drain_enclave_journal(enclave_info);
   finalize_enclave_hash(enclave_info);
+  atomic_flag_clear(&enclave_info->hash_lock);
 
   enclave_info->is_initialized = 1;
   clear_dram_region_lock(dram_region);
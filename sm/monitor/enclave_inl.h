@@ -7,6 +7,7 @@
 #include "dram_regions.h"
 #include "enclave.h"
 #include "measure_inl.h"
+#include "metadata_inl.h"
 
 // Checks if a given virtual address is a valid enclave virtual address.
 //
@@ -75,13 +76,56 @@ static inline uintptr_t walk_page_tables(uintptr_t ptb, uintptr_t virtual_addr)
   return page_table_entry_target(entry_addr, 0);
 }
 
+// Walks an initialized enclave's page tables to the leaf entry for an address.
+//
+// Unlike walk_page_tables_to_entry(), this does not trust the page tables,
+// which the enclave can change once it runs. The walk starts at the EPTBR set
+// while the enclave was loaded, and every page table must be in a DRAM region
+// that belongs to the enclave.
+//
+// The caller must hold the lock of the enclave's main DRAM region, so the
+// enclave's DRAM regions cannot change during the walk.
+//
+// Returns 0 if the walk was interrupted due to a page table entry not being
+// valid / present, or due to a page table outside the enclave's memory.
+static inline uintptr_t walk_enclave_page_tables_to_leaf(
+    enclave_id_t enclave_id, uintptr_t virtual_addr) {
+  enclave_info_t* enclave_info = (enclave_info_t*)enclave_id;
+  size_t addr_shift = page_table_translated_bits();
+  uintptr_t table_addr = enclave_info->load_eptbr;
+
+  size_t walk_level = page_table_levels();
+  while (true) {
+    if (!is_dram_address(table_addr))
+      break;
+    size_t table_dram_region = dram_region_for(table_addr);
+    if (!read_enclave_region_bitmap_bit(enclave_id, table_dram_region))
+      break;
+
+    walk_level--;
+    size_t level_addr_shift = page_table_shift(walk_level);
+    addr_shift -= level_addr_shift;
+    uintptr_t addr_mask = ((1 << level_addr_shift) - 1);
+    uintptr_t entry_offset = (virtual_addr >> addr_shift) & addr_mask;
+
+    uintptr_t entry_addr = table_addr +
+        (entry_offset << page_table_entry_shift(walk_level));
+    if (walk_level == 0)
+      return entry_addr;
+    if (!is_valid_page_table_entry(entry_addr, walk_level))
+      break;
+    table_addr = page_table_entry_target(entry_addr, walk_level);
+  }
+  return 0;
+}
+
 // Initializes an enclave's metadata structure.
 //
 // The caller is responsible for validating all input parameters. The caller
 // must also hold the lock for the metadata region of the enclave metadata.
 static inline void init_enclave_info(enclave_info_t* enclave_info,
     uintptr_t ev_base, uintptr_t ev_mask, size_t mailbox_count, bool debug) {
-  atomic_flag_clear(enclave_info->lock);
+  atomic_flag_clear(&enclave_info->lock);
   enclave_info->mailbox_count = mailbox_count;
   enclave_info->is_initialized = 0;
   enclave_info->is_debug = debug;
@@ -91,6 +135,7 @@ static inline void init_enclave_info(enclave_info_t* enclave_info,
   enclave_info->last_load_addr = 0;
   enclave_info->thread_count = 0;
   enclave_info->dram_region_count = 0;
+  enclave_info->paging_version = 0;
   init_enclave_hash(enclave_info, ev_base, ev_mask, mailbox_count, debug);
 }
 
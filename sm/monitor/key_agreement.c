@@ -0,0 +1,59 @@
+#include <public/api.h>
+
+#include "ed25519/ed25519.h"
+#include "cpu_core_inl.h"
+#include "dram_regions_inl.h"
+#include "metadata_inl.h"
+
+// Checks whether a public key is the X25519 base point (9).
+static bool is_x25519_base_point(const uint8_t* public_key) {
+  uint8_t diff = public_key[0] ^ 9;
+  for (size_t i = 1; i < x25519_key_size; ++i)
+    diff |= public_key[i];
+  return diff == 0;
+}
+
+api_result_t x25519_key_agreement(uintptr_t phys_addr) {
+  enclave_id_t enclave_id = current_enclave();
+  if (enclave_id == null_enclave_id)
+    return monitor_invalid_state;
+
+  size_t dram_region;
+  api_result_t result = lock_enclave_buffer(enclave_id, phys_addr,
+      sizeof(x25519_request_t), &dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  // NOTE: The keys are copied out of the enclave's buffer first, so the result
+  //       does not depend on enclave threads changing the buffer meanwhile.
+  x25519_request_t* request = (x25519_request_t*)phys_addr;
+  uint8_t private_key[x25519_key_size];
+  uint8_t public_key[x25519_key_size];
+  uint8_t shared_secret[x25519_key_size];
+  for (size_t i = 0; i < x25519_key_size; ++i) {
+    private_key[i] = request->private_key[i];
+    public_key[i] = request->public_key[i];
+  }
+
+  // NOTE: The base point case uses the Edwards fixed-base table, which is a
+  //       few times faster than the ladder.
+  if (is_x25519_base_point(public_key)) {
+    x25519_public_key(shared_secret, private_key);
+  } else if (!x25519(shared_secret, private_key, public_key)) {
+    result = monitor_invalid_value;
+  }
+
+  for (size_t i = 0; i < x25519_key_size; ++i) {
+    request->shared_secret[i] =
+        (result == monitor_ok) ? shared_secret[i] : 0;
+  }
+
+  volatile uint8_t* secrets[2] = { private_key, shared_secret };
+  for (size_t j = 0; j < 2; ++j) {
+    for (size_t i = 0; i < x25519_key_size; ++i)
+      secrets[j][i] = 0;
+  }
+
+  clear_dram_region_lock(dram_region);
+  return result;
+}
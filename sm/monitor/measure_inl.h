@@ -36,7 +36,7 @@ const size_t finalize_enclave_opcode =  0xEEEEEEEE;
 static inline measurement_block_t* enclave_measurement_block(
     enclave_info_t* enclave_info) {
   uint32_t* block_ptr = enclave_info->hash_block;
-  return block_ptr;
+  return (measurement_block_t*)block_ptr;
 }
 
 // Initializes an enclave's measurement hash.
@@ -50,6 +50,11 @@ static inline void init_enclave_hash(enclave_info_t* enclave_info,
   size_t* fast_hash_block = (size_t*)(enclave_info->hash_block);
   bzero(fast_hash_block, hash_block_size);
   init_hash(&(enclave_info->hash));
+  atomic_flag_clear(&enclave_info->hash_lock);
+#if ENCLAVE_LOAD_JOURNAL
+  enclave_info->journal_head = 0;
+  enclave_info->journal_tail = 0;
+#endif  // ENCLAVE_LOAD_JOURNAL
 
   measurement_block_t* block =
       enclave_measurement_block(enclave_info);
@@ -107,11 +112,33 @@ static inline void extend_enclave_hash_with_page(
   block->ptr1 = 0;
   block->ptr2 = 0;
 
-  uint32_t* page_end = phys_addr + page_size();
-  for(uint32_t* page_ptr = phys_addr; page_ptr != page_end;
-      page_ptr += hash_block_size / sizeof(uint32_t)) {
-    extend_hash(&(enclave_info->hash), page_ptr);
-  }
+  extend_hash_pages(&(enclave_info->hash), (const void*)phys_addr, 1);
+}
+
+// Copies a page into an enclave and adds it to the enclave's measurement hash.
+//
+// The caller must hold the enclave's hash_lock, the locks of the encalve's main
+// DRAM region and of the DRAM region that contains `os_addr`, and must have
+// checked that the measurement journal is empty.
+//
+// This produces the same measurement as copying the page to `phys_addr` and
+// calling extend_enclave_hash_with_page(), but reads the page only once.
+static inline void extend_enclave_hash_with_copied_page(
+    enclave_info_t* enclave_info, uintptr_t virtual_addr,
+    uintptr_t acl, uintptr_t phys_addr, uintptr_t os_addr) {
+  measurement_block_t* block =
+      enclave_measurement_block(enclave_info);
+  block->opcode = load_page_opcode;
+  block->ptr1 =   virtual_addr;
+  block->ptr2 =   acl;
+
+  extend_hash(&(enclave_info->hash),
+      enclave_info->hash_block);
+  block->ptr1 = 0;
+  block->ptr2 = 0;
+
+  extend_hash_with_copy(&(enclave_info->hash), (void*)phys_addr,
+      (const void*)os_addr, page_size());
 }
 
 // Adds a thread creation operation to an enclave's measurement hash.
@@ -136,6 +163,111 @@ static inline void extend_enclave_hash_with_thread(
   block->ptr4 = 0;
 }
 
+// A snapshot of an enclave's measurement, taken between two loading operations.
+//
+// Enclaves that are created with the same arguments and start by loading the
+// same pages share a measurement prefix. A checkpoint saved after the prefix
+// lets the measurement of each such enclave resume from there.
+typedef struct {
+  hash_state_t hash;
+} enclave_hash_checkpoint_t;
+
+// Saves a checkpoint of an enclave's measurement hash.
+//
+// The caller must hold the lock of the encalve's main DRAM region.
+static inline void save_enclave_hash_checkpoint(
+    enclave_info_t* enclave_info, enclave_hash_checkpoint_t* checkpoint) {
+  copy_hash(&(checkpoint->hash), &(enclave_info->hash));
+}
+
+// Resumes an enclave's measurement hash from a checkpoint.
+//
+// The enclave's hash must have been set up by init_enclave_hash(). The caller
+// must hold the lock of the encalve's main DRAM region, and is responsible for
+// ensuring that the enclave's memory holds exactly what was measured up to the
+// checkpoint.
+static inline void restore_enclave_hash_checkpoint(
+    enclave_info_t* enclave_info,
+    const enclave_hash_checkpoint_t* checkpoint) {
+  copy_hash(&(enclave_info->hash), &(checkpoint->hash));
+}
+
+#if ENCLAVE_LOAD_JOURNAL
+
+// Returns true if an enclave's measurement journal has no room for a record.
+//
+// The caller must hold the lock of the encalve's main DRAM region, which keeps
+// other calls from appending records.
+static inline bool is_enclave_journal_full(enclave_info_t* enclave_info) {
+  size_t head = atomic_load(&(enclave_info->journal_head));
+  return enclave_info->journal_tail - head == measurement_journal_size;
+}
+
+// Appends a loading operation to an enclave's measurement journal.
+//
+// The caller must hold the lock of the encalve's main DRAM region, and must
+// have checked that the journal is not full while holding it.
+static inline void journal_enclave_load(enclave_info_t* enclave_info,
+    size_t opcode, uintptr_t virtual_addr, uintptr_t acl, size_t level,
+    uintptr_t phys_addr) {
+  size_t tail = enclave_info->journal_tail;
+  measurement_record_t* record =
+      &(enclave_info->journal[tail % measurement_journal_size]);
+  record->opcode =        opcode;
+  record->virtual_addr =  virtual_addr;
+  record->acl =           acl;
+  record->level =         level;
+  record->phys_addr =     phys_addr;
+
+  // The record must be visible before the drainer can see the new tail.
+  __sync_synchronize();
+  atomic_store(&(enclave_info->journal_tail), tail + 1);
+}
+
+// Returns true if enough records are pending to be worth draining.
+static inline bool should_drain_enclave_journal(
+    enclave_info_t* enclave_info) {
+  size_t pending = atomic_load(&(enclave_info->journal_tail)) -
+      atomic_load(&(enclave_info->journal_head));
+  return pending >= measurement_journal_size / 2;
+}
+
+// Hashes the records in an enclave's measurement journal, in order.
+//
+// The caller must hold the enclave's hash_lock. The lock of the enclave's main
+// DRAM region is not needed: an uninitialized enclave cannot release its DRAM
+// regions, and delete_enclave() fails while hash_lock is held, so the pages
+// named by the records stay put.
+//
+// The resulting hash is the same as if each operation had been hashed by the
+// API call that performed it.
+static inline void drain_enclave_journal(enclave_info_t* enclave_info) {
+  size_t head = enclave_info->journal_head;
+  size_t tail = atomic_load(&(enclave_info->journal_tail));
+  __sync_synchronize();
+
+  for (; head != tail; ++head) {
+    measurement_record_t* record =
+        &(enclave_info->journal[head % measurement_journal_size]);
+    if (record->opcode == load_page_table_opcode) {
+      extend_enclave_hash_with_page_table(enclave_info, record->virtual_addr,
+          record->level, record->acl);
+    } else {
+      extend_enclave_hash_with_page(enclave_info, record->virtual_addr,
+          record->acl, record->phys_addr);
+    }
+  }
+  atomic_store(&(enclave_info->journal_head), head);
+}
+
+#else  // !ENCLAVE_LOAD_JOURNAL
+
+// Without the journal, every operation is hashed by the call that performs it.
+static inline void drain_enclave_journal(enclave_info_t* enclave_info) {
+}
+
+#endif  // ENCLAVE_LOAD_JOURNAL
+
 // Finalizes the enclave's measurement hash.
 static inline void finalize_enclave_hash(enclave_info_t* enclave_info) {
   measurement_block_t* block =
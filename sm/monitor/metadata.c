@@ -7,6 +7,7 @@
 #include "enclave_inl.h"
 #include "measure_inl.h"
 #include "metadata_inl.h"
+#include "paging.h"
 
 size_t g_metadata_region_pages;
 size_t g_metadata_region_start;
@@ -31,7 +32,7 @@ api_result_t create_enclave(enclave_id_t enclave_id, uintptr_t ev_base,
     return monitor_invalid_value;
 
   size_t dram_region;
-  api_result_t result = lock_metadata_region_for(enclave_id, dram_region);
+  api_result_t result = lock_metadata_region_for(enclave_id, &dram_region);
   if (result != monitor_ok)
     return result;
 
@@ -51,6 +52,7 @@ api_result_t create_enclave(enclave_id_t enclave_id, uintptr_t ev_base,
 
   init_enclave_info((enclave_info_t*){enclave_id}, ev_base, ev_mask,
       mailbox_count, debug);
+  init_enclave_paging_keys((enclave_info_t*){enclave_id}, enclave_id);
   clear_dram_region_lock(dram_region);
   return monitor_ok;
 }
@@ -61,7 +63,7 @@ api_result_t assign_thread(enclave_id_t enclave_id, thread_id_t thread_id) {
     return result;
 
   size_t dram_region;
-  result = lock_metadata_region_for(thread_id, dram_region);
+  result = lock_metadata_region_for(thread_id, &dram_region);
   if (result != monitor_ok) {
     unlock_enclave(enclave_id);
     return result;
@@ -96,7 +98,7 @@ api_result_t load_thread(enclave_id_t enclave_id,
     return result;
 
   size_t thread_dram_region;
-  result = lock_metadata_region_for(thread_id, thread_dram_region);
+  result = lock_metadata_region_for(thread_id, &thread_dram_region);
   if (result != monitor_ok) {
     unlock_enclave(enclave_id);
     return result;
@@ -105,9 +107,13 @@ api_result_t load_thread(enclave_id_t enclave_id,
   enclave_info_t* enclave_info = enclave_id;
   if (enclave_info->is_initialized || (enclave_info->load_eptbr == 0)) {
     result = monitor_invalid_state;
+  } else if (atomic_flag_test_and_set(&enclave_info->hash_lock)) {
+    result = monitor_concurrent_call;
   } else {
     result = reserve_metadata_pages(enclave_id, thread_metadata_pages(),
         enclave_id, thread_metadata_page_type);
+    if (result != monitor_ok)
+      atomic_flag_clear(&enclave_info->hash_lock);
   }
 
   if (result != monitor_ok) {
@@ -119,15 +125,19 @@ api_result_t load_thread(enclave_id_t enclave_id,
   enclave_info->thread_count += 1;
 
   thread_info_t* thread_metadata = thread_id;
-  atomic_flag_clear(thread_metadata->lock);
+  atomic_flag_clear(&thread_metadata->lock);
   thread_metadata->entry_pc = entry_pc;
   thread_metadata->entry_stack = entry_stack;
   thread_metadata->fault_pc = fault_pc;
   thread_metadata->fault_stack = fault_stack;
   thread_metadata->eptbr = enclave_info->load_eptbr;
 
+  // NOTE: Loads that were journaled before this call are hashed first, so
+  //       the measurement follows the order of the API calls.
+  drain_enclave_journal(enclave_info);
   extend_enclave_hash_with_thread(enclave_info, entry_pc, entry_stack,
       fault_pc, fault_stack);
+  atomic_flag_clear(&enclave_info->hash_lock);
 
   clear_dram_region_lock(thread_dram_region);
   unlock_enclave(enclave_id);
@@ -175,7 +185,7 @@ api_result_t accept_thread(thread_id_t thread_id, uintptr_t thread_info_addr) {
   thread_info_t* thread_metadata = thread_id;
   thread_init_info_t* thread_info = thread_info_addr;
 
-  atomic_flag_clear(thread_metadata->lock);
+  atomic_flag_clear(&thread_metadata->lock);
 
   uintptr_t entry_pc = thread_info->entry_pc;
   uintptr_t entry_stack = thread_info->entry_stack;
@@ -27,7 +27,7 @@
 typedef uintptr_t metadata_page_info_t;
 
 // Mask that selects the metadata page type bits.
-#define metadata_page_type_mask 3
+#define metadata_page_type_mask 7
 
 // Type for metadata pages that have been assigned to enclaves but not used.
 //
@@ -49,6 +49,9 @@ typedef uintptr_t metadata_page_info_t;
 // Type for metadata pages that hold a thread_info_t for an enclave.
 #define thread_metadata_page_type 3
 
+// Type for metadata pages that hold a paging_info_t for an enclave.
+#define paging_metadata_page_type 4
+
 // Total number of metadata pages in a DRAM region dedicated to metadata.
 extern size_t g_metadata_region_pages;
 
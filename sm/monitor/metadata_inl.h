@@ -4,6 +4,7 @@
 #include <arch/base_types.h>
 #include <arch/bit_masking.h>
 #include <arch/atomics.h>
+#include "boot_init.h"
 #include "dram_regions_inl.h"
 #include "enclave.h"
 #include "mailbox.h"
@@ -35,7 +36,7 @@ static inline metadata_page_info_t metadata_page_info_type(
 // be free.
 static inline void init_metadata_region(size_t dram_region) {
   dram_region_info_t* region = &g_dram_region[dram_region];
-  region->owner = metadata_enclave_id;
+  set_dram_region_owner(dram_region, metadata_enclave_id);
   region->pinned_pages = 0;
 
   metadata_page_info_t* metadata_map = dram_region_start(dram_region);
@@ -50,17 +51,18 @@ static inline void init_metadata_region(size_t dram_region) {
 //
 // If this succeeds, it sets dram_region to the DRAM region index of the
 // metadata region that the given address belongs to.
-static inline api_result_t lock_metadata_region_for(uintptr_t phys_addr, size_t dram_region) {
+static inline api_result_t lock_metadata_region_for(uintptr_t phys_addr,
+    size_t* dram_region) {
   if (!is_page_aligned(phys_addr) || !is_dram_address(phys_addr))
     return monitor_invalid_value;
 
-  dram_region = dram_region_for(phys_addr);
-  if (test_and_set_dram_region_lock(dram_region))
+  *dram_region = dram_region_for(phys_addr);
+  if (test_and_set_dram_region_lock(*dram_region))
     return monitor_concurrent_call;
 
-  dram_region_info_t* region = &g_dram_region[dram_region];
+  dram_region_info_t* region = &g_dram_region[*dram_region];
   if (region->owner != metadata_enclave_id) {
-    clear_dram_region_lock(dram_region);
+    clear_dram_region_lock(*dram_region);
     return monitor_invalid_state;
   }
   return monitor_ok;
@@ -168,7 +170,7 @@ static inline api_result_t lock_enclave(enclave_id_t enclave_id) {
     return monitor_invalid_value;
 
   size_t dram_region;
-  api_result_t result = lock_metadata_region_for(enclave_id, dram_region);
+  api_result_t result = lock_metadata_region_for(enclave_id, &dram_region);
   if (result != monitor_ok)
     return result;
 
@@ -179,8 +181,8 @@ static inline api_result_t lock_enclave(enclave_id_t enclave_id) {
       metadata_page_info(enclave_id, enclave_metadata_page_type)) {
     result = monitor_invalid_value;
   } else {
-    const enclave_info_t* enclave_info = enclave_id;
-    if (atomic_flag_test_and_set(enclave_info->lock))
+    enclave_info_t* enclave_info = enclave_id;
+    if (atomic_flag_test_and_set(&enclave_info->lock))
       result = monitor_concurrent_call;
   }
 
@@ -196,8 +198,8 @@ static inline api_result_t lock_enclave(enclave_id_t enclave_id) {
 // Incorrect enclave IDs will cause memory trashing. Unlocking an already
 // unlocked enclave is a security error
 static inline void unlock_enclave(enclave_id_t enclave_id) {
-  const enclave_info_t* enclave_info = enclave_id;
-  atomic_flag_clear(enclave_info->lock);
+  enclave_info_t* enclave_info = enclave_id;
+  atomic_flag_clear(&enclave_info->lock);
 }
 
 // Computes the physical address of an enclave's DRAM region bitmap.
@@ -262,6 +264,24 @@ static inline void set_enclave_region_bitmap_bit(enclave_id_t enclave_id,
   }
 }
 
+// Sets or clears the bits of a batch of DRAM regions in a DRAM region bitmap.
+//
+// `regions` is a DRAM region bitmap whose set bits select the DRAM regions.
+// The caller should hold the lock of the enclave metadata's DRAM region.
+//
+// A null enclave_id causes bits to be changed in the OS' DRAM region bitmap.
+static inline void set_enclave_region_bitmap_bits(enclave_id_t enclave_id,
+    const size_t* regions, bool true_for_set) {
+  size_t* bitmap = (enclave_id == null_enclave_id) ?
+      g_os_region_bitmap : enclave_region_bitmap(enclave_id);
+  for (size_t i = 0; i < g_dram_region_bitmap_words; ++i) {
+    if (true_for_set)
+      bitmap[i] |= regions[i];
+    else
+      bitmap[i] &= ~regions[i];
+  }
+}
+
 // Reads a bit from a DRAM region bitmap.
 //
 // The caller should hold the lock of the enclave's main DRAM region.
@@ -275,6 +295,76 @@ static inline bool read_enclave_region_bitmap_bit(enclave_id_t enclave_id,
     return read_bitmap_bit(enclave_region_bitmap(enclave_id), dram_region);
 }
 
+// Locks an enclave's main DRAM region, and checks a buffer passed by the
+// enclave to an API call.
+//
+// The buffer must be uintptr_t-aligned, and must be contained in a single DRAM
+// region that belongs to the enclave. Holding the lock keeps that DRAM region
+// from being removed from the enclave while the buffer is used.
+//
+// On success, `dram_region` is set to the enclave's main DRAM region, whose
+// lock the caller must release with clear_dram_region_lock().
+static inline api_result_t lock_enclave_buffer(enclave_id_t enclave_id,
+    uintptr_t phys_addr, size_t size, size_t* dram_region) {
+  uintptr_t phys_end = phys_addr + size;
+  if (phys_addr % sizeof(uintptr_t) != 0)
+    return monitor_invalid_value;
+  if (!is_dram_address(phys_addr) || !is_dram_address(phys_end - 1))
+    return monitor_invalid_value;
+  size_t buffer_dram_region = dram_region_for(phys_addr);
+  if (dram_region_for(phys_end - 1) != buffer_dram_region)
+    return monitor_invalid_value;
+
+  *dram_region = dram_region_for(enclave_id);
+  if (test_and_set_dram_region_lock(*dram_region))
+    return monitor_concurrent_call;
+
+  if (!read_enclave_region_bitmap_bit(enclave_id, buffer_dram_region)) {
+    clear_dram_region_lock(*dram_region);
+    return monitor_invalid_value;
+  }
+  return monitor_ok;
+}
+
+// Locks the DRAM region holding a buffer passed by the OS to an API call.
+//
+// The buffer must be uintptr_t-aligned, and must be contained in a single DRAM
+// region that belongs to the OS. It may not overlap the monitor.
+//
+// On success, `dram_region` is set to the buffer's DRAM region, whose lock the
+// caller must release with clear_dram_region_lock().
+static inline api_result_t lock_os_buffer(uintptr_t phys_addr, size_t size,
+    size_t* dram_region) {
+  uintptr_t phys_end = phys_addr + size;
+  if (phys_addr % sizeof(uintptr_t) != 0 || phys_addr < g_monitor_top)
+    return monitor_invalid_value;
+  if (!is_dram_address(phys_addr) || !is_dram_address(phys_end - 1))
+    return monitor_invalid_value;
+  *dram_region = dram_region_for(phys_addr);
+  if (dram_region_for(phys_end - 1) != *dram_region)
+    return monitor_invalid_value;
+
+  if (test_and_set_dram_region_lock(*dram_region))
+    return monitor_concurrent_call;
+
+  if (read_dram_region_owner(*dram_region) != null_enclave_id) {
+    clear_dram_region_lock(*dram_region);
+    return monitor_invalid_value;
+  }
+  return monitor_ok;
+}
+
+// Locks and checks a buffer passed to an API call by an enclave or the OS.
+//
+// This is lock_os_buffer() for a null `enclave_id`, and lock_enclave_buffer()
+// otherwise.
+static inline api_result_t lock_caller_buffer(enclave_id_t enclave_id,
+    uintptr_t phys_addr, size_t size, size_t* dram_region) {
+  if (enclave_id == null_enclave_id)
+    return lock_os_buffer(phys_addr, size, dram_region);
+  return lock_enclave_buffer(enclave_id, phys_addr, size, dram_region);
+}
+
 // Verifies the validity of an enclave ID. 0 is considered a valid ID.
 //
 // This should be called while holding the DRAM region lock for the region
@@ -0,0 +1,369 @@
+#include "paging.h"
+
+#include <arch/memory.h>
+#include <arch/page_tables.h>
+#include <crypto/sealing.h>
+#include <crypto/signing_key.h>
+#include "cpu_core_inl.h"
+#include "dram_regions_inl.h"
+#include "enclave_inl.h"
+#include "metadata_inl.h"
+
+// The number of enclaves created since boot.
+//
+// This is a part of the label of each enclave's paging keys, so a new enclave
+// that reuses the ID of a deleted enclave gets different keys.
+static uintptr_t g_paging_key_generation;
+
+// The label passed to derive_monitor_key() for an enclave's paging keys.
+typedef struct {
+  char name[16];
+  enclave_id_t enclave_id;
+  uintptr_t generation;
+} paging_key_label_t;
+
+void init_enclave_paging_keys(enclave_info_t* enclave_info,
+    enclave_id_t enclave_id) {
+  paging_key_label_t label = {
+    .name = "enclave paging",
+    .enclave_id = enclave_id,
+    .generation = atomic_fetch_add(&g_paging_key_generation, 1),
+  };
+
+  derive_monitor_key(enclave_info->paging_key, sealing_key_size, &label,
+      sizeof(label));
+}
+
+// Locks the metadata region that holds an initialized enclave's metadata.
+//
+// Paging calls hold this lock until they complete. It keeps the enclave's DRAM
+// regions from changing, and keeps the enclave from being entered, so its page
+// tables do not change either.
+static api_result_t lock_paging_enclave(enclave_id_t enclave_id,
+    size_t* dram_region) {
+  api_result_t result = lock_metadata_region_for(enclave_id, dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  const enclave_info_t* enclave_info = (const enclave_info_t*)enclave_id;
+  if (*metadata_page_info_for(enclave_id) !=
+      metadata_page_info(enclave_id, enclave_metadata_page_type)) {
+    result = monitor_invalid_value;
+  } else if (enclave_info->is_initialized == 0) {
+    result = monitor_invalid_state;
+  }
+
+  if (result != monitor_ok)
+    clear_dram_region_lock(*dram_region);
+  return result;
+}
+
+// Locks the metadata region that holds a paging structure.
+//
+// No lock is taken if the structure is in `enclave_dram_region`, whose lock the
+// caller already holds. The caller must release the lock by calling
+// clear_paging_region_lock().
+static api_result_t lock_paging_region(uintptr_t paging_addr,
+    size_t enclave_dram_region, size_t* dram_region) {
+  if (!is_page_aligned(paging_addr) || !is_dram_address(paging_addr))
+    return monitor_invalid_value;
+
+  if (dram_region_for(paging_addr) == enclave_dram_region) {
+    *dram_region = enclave_dram_region;
+    return monitor_ok;
+  }
+  return lock_metadata_region_for(paging_addr, dram_region);
+}
+
+// Releases a lock acquired by lock_paging_region().
+static inline void clear_paging_region_lock(size_t dram_region,
+    size_t enclave_dram_region) {
+  if (dram_region != enclave_dram_region)
+    clear_dram_region_lock(dram_region);
+}
+
+// Checks that a metadata page holds one of an enclave's paging structures.
+//
+// The caller must hold the lock of the page's metadata region.
+static inline bool is_enclave_paging_page(enclave_id_t enclave_id,
+    uintptr_t paging_addr) {
+  return *metadata_page_info_for(paging_addr) ==
+      metadata_page_info(enclave_id, paging_metadata_page_type);
+}
+
+// Checks whether an enclave is running on any core.
+//
+// The caller must hold the lock of the enclave's main DRAM region, which
+// enter_enclave() holds while it sets up a core to run the enclave.
+static bool is_enclave_running(enclave_id_t enclave_id) {
+  for (size_t i = 0; i < g_core_count; ++i) {
+    if (g_core[i].enclave_id == enclave_id)
+      return true;
+  }
+  return false;
+}
+
+api_result_t assign_paging_page(enclave_id_t enclave_id, uintptr_t phys_addr) {
+  size_t enclave_dram_region;
+  api_result_t result = lock_paging_enclave(enclave_id, &enclave_dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  size_t dram_region;
+  result = lock_paging_region(phys_addr, enclave_dram_region, &dram_region);
+  if (result != monitor_ok) {
+    clear_dram_region_lock(enclave_dram_region);
+    return result;
+  }
+
+  result = reserve_metadata_pages(phys_addr, 1, enclave_id,
+      paging_metadata_page_type);
+  if (result == monitor_ok)
+    bzero((void*)phys_addr, page_size());
+
+  clear_paging_region_lock(dram_region, enclave_dram_region);
+  clear_dram_region_lock(enclave_dram_region);
+  return result;
+}
+
+api_result_t free_paging_page(enclave_id_t enclave_id, uintptr_t phys_addr) {
+  size_t enclave_dram_region;
+  api_result_t result = lock_paging_enclave(enclave_id, &enclave_dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  size_t dram_region;
+  result = lock_paging_region(phys_addr, enclave_dram_region, &dram_region);
+  if (result != monitor_ok) {
+    clear_dram_region_lock(enclave_dram_region);
+    return result;
+  }
+
+  const paging_info_t* paging_info = (const paging_info_t*)phys_addr;
+  if (!is_enclave_paging_page(enclave_id, phys_addr)) {
+    result = monitor_invalid_value;
+  } else {
+    for (size_t i = 0; i < paging_slot_count; ++i) {
+      if (paging_info->slot_version[i] != 0)
+        result = monitor_invalid_state;
+    }
+  }
+
+  // NOTE: free_page_count is zero when all the slots are free, so freeing the
+  //       structure does not lose track of any enclave pages.
+  if (result == monitor_ok)
+    *metadata_page_info_for(phys_addr) = empty_metadata_page_info;
+
+  clear_paging_region_lock(dram_region, enclave_dram_region);
+  clear_dram_region_lock(enclave_dram_region);
+  return result;
+}
+
+// The locks and checked arguments of an eviction or a reload.
+typedef struct {
+  size_t enclave_dram_region;
+  size_t paging_dram_region;
+  size_t os_dram_region;
+
+  // The paging structure holding the call's slot.
+  paging_info_t* paging_info;
+  size_t slot;
+
+  // The enclave's leaf page table entry for the page's virtual address.
+  uintptr_t entry_addr;
+} paging_call_t;
+
+// Checks the arguments shared by evict_enclave_page() and
+// reload_enclave_page(), and takes the call's locks.
+//
+// On success, the caller must release the locks by calling end_paging_call().
+static api_result_t begin_paging_call(enclave_id_t enclave_id,
+    uintptr_t virtual_addr, uintptr_t os_addr, uintptr_t mac_addr,
+    paging_slot_id_t slot_id, paging_call_t* call) {
+  uintptr_t mac_end = mac_addr + evicted_page_mac_size;
+  if (!is_page_aligned(virtual_addr) || !is_page_aligned(os_addr))
+    return monitor_invalid_value;
+  if (mac_addr % sizeof(uintptr_t) != 0)
+    return monitor_invalid_value;
+  if (!is_dram_address(os_addr) || !is_dram_address(mac_addr) ||
+      !is_dram_address(mac_end - 1)) {
+    return monitor_invalid_value;
+  }
+  call->os_dram_region = dram_region_for(os_addr);
+  if (dram_region_for(mac_addr) != call->os_dram_region ||
+      dram_region_for(mac_end - 1) != call->os_dram_region) {
+    return monitor_invalid_value;
+  }
+
+  uintptr_t paging_addr = slot_id & ~(uintptr_t)(page_size() - 1);
+  call->paging_info = (paging_info_t*)paging_addr;
+  call->slot = slot_id - paging_addr;
+  if (call->slot >= paging_slot_count)
+    return monitor_invalid_value;
+
+  api_result_t result = lock_paging_enclave(enclave_id,
+      &call->enclave_dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  result = lock_paging_region(paging_addr, call->enclave_dram_region,
+      &call->paging_dram_region);
+  if (result != monitor_ok) {
+    clear_dram_region_lock(call->enclave_dram_region);
+    return result;
+  }
+
+  // NOTE: If the OS page is in one of the metadata regions locked above, we'll
+  //       fail to acquire the lock and return concurrent_call. This is
+  //       acceptable, as the OS page is invalid anyway.
+  if (test_and_set_dram_region_lock(call->os_dram_region)) {
+    clear_paging_region_lock(call->paging_dram_region,
+        call->enclave_dram_region);
+    clear_dram_region_lock(call->enclave_dram_region);
+    return monitor_concurrent_call;
+  }
+
+  if (read_dram_region_owner(call->os_dram_region) != null_enclave_id)
+    result = monitor_invalid_value;
+  if (!is_enclave_paging_page(enclave_id, paging_addr))
+    result = monitor_invalid_value;
+  if (!is_enclave_virtual_address(virtual_addr, enclave_id))
+    result = monitor_invalid_value;
+  if (is_enclave_running(enclave_id))
+    result = monitor_invalid_state;
+
+  if (result == monitor_ok) {
+    call->entry_addr = walk_enclave_page_tables_to_leaf(enclave_id,
+        virtual_addr);
+    if (call->entry_addr == 0)
+      result = monitor_invalid_state;
+  }
+
+  if (result != monitor_ok) {
+    clear_dram_region_lock(call->os_dram_region);
+    clear_paging_region_lock(call->paging_dram_region,
+        call->enclave_dram_region);
+    clear_dram_region_lock(call->enclave_dram_region);
+  }
+  return result;
+}
+
+// Releases the locks taken by begin_paging_call().
+static void end_paging_call(const paging_call_t* call) {
+  clear_dram_region_lock(call->os_dram_region);
+  clear_paging_region_lock(call->paging_dram_region,
+      call->enclave_dram_region);
+  clear_dram_region_lock(call->enclave_dram_region);
+}
+
+// Builds the sealing IV for a version of an evicted page.
+//
+// The IV is the version, big-endian, followed by zeros. Versions are never
+// reused under an enclave's paging key.
+static void init_paging_iv(uint8_t* iv, uint64_t version) {
+  for (size_t i = 0; i < sealing_iv_size; ++i) {
+    iv[i] = (i < sizeof(version)) ?
+        (uint8_t)(version >> (8 * (sizeof(version) - 1 - i))) : 0;
+  }
+}
+
+api_result_t evict_enclave_page(enclave_id_t enclave_id,
+    uintptr_t virtual_addr, uintptr_t os_addr, uintptr_t mac_addr,
+    paging_slot_id_t slot_id) {
+  paging_call_t call;
+  api_result_t result = begin_paging_call(enclave_id, virtual_addr, os_addr,
+      mac_addr, slot_id, &call);
+  if (result != monitor_ok)
+    return result;
+
+  paging_info_t* paging_info = call.paging_info;
+  uintptr_t page_addr = page_table_entry_target(call.entry_addr, 0);
+  if (paging_info->slot_version[call.slot] != 0)
+    result = monitor_invalid_state;
+  if (!is_valid_page_table_entry(call.entry_addr, 0))
+    result = monitor_invalid_state;
+  if (!is_dram_address(page_addr) ||
+      !read_enclave_region_bitmap_bit(enclave_id, dram_region_for(page_addr))) {
+    result = monitor_invalid_state;
+  }
+  if (result != monitor_ok) {
+    end_paging_call(&call);
+    return result;
+  }
+
+  enclave_info_t* enclave_info = (enclave_info_t*)enclave_id;
+  enclave_info->paging_version += 1;
+  uint64_t version = enclave_info->paging_version;
+
+  // NOTE: The virtual address is authenticated along with the page, so the
+  //       OS cannot reload the page at a different address.
+  uint8_t iv[sealing_iv_size];
+  init_paging_iv(iv, version);
+  seal_copy((void*)os_addr, (const void*)page_addr, page_size(),
+      enclave_info->paging_key, iv, &virtual_addr, sizeof(virtual_addr),
+      (uint8_t*)mac_addr);
+
+  // NOTE: No core is running the enclave, and enclave exits flush the TLBs,
+  //       so no TLB entry can map the page once its entry is invalidated.
+  invalidate_page_table_entry(call.entry_addr, 0);
+  bzero((void*)page_addr, page_size());
+
+  paging_info->slot_version[call.slot] = version;
+  paging_info->free_pages[paging_info->free_page_count] = page_addr;
+  paging_info->free_page_count += 1;
+
+  end_paging_call(&call);
+  return monitor_ok;
+}
+
+api_result_t reload_enclave_page(enclave_id_t enclave_id,
+    uintptr_t virtual_addr, uintptr_t os_addr, uintptr_t mac_addr,
+    paging_slot_id_t slot_id) {
+  paging_call_t call;
+  api_result_t result = begin_paging_call(enclave_id, virtual_addr, os_addr,
+      mac_addr, slot_id, &call);
+  if (result != monitor_ok)
+    return result;
+
+  paging_info_t* paging_info = call.paging_info;
+  uint64_t version = paging_info->slot_version[call.slot];
+  if (version == 0 || is_valid_page_table_entry(call.entry_addr, 0)) {
+    end_paging_call(&call);
+    return monitor_invalid_state;
+  }
+
+  // NOTE: Free pages in DRAM regions that the enclave blocked since they were
+  //       evicted are not usable anymore, so they are dropped here.
+  uintptr_t page_addr = 0;
+  while (page_addr == 0 && paging_info->free_page_count != 0) {
+    paging_info->free_page_count -= 1;
+    uintptr_t free_page =
+        paging_info->free_pages[paging_info->free_page_count];
+    size_t free_page_dram_region = dram_region_for(free_page);
+    if (read_enclave_region_bitmap_bit(enclave_id, free_page_dram_region))
+      page_addr = free_page;
+  }
+  if (page_addr == 0) {
+    end_paging_call(&call);
+    return monitor_invalid_state;
+  }
+
+  enclave_info_t* enclave_info = (enclave_info_t*)enclave_id;
+  uint8_t iv[sealing_iv_size];
+  init_paging_iv(iv, version);
+  if (unseal_copy((void*)page_addr, (const void*)os_addr, page_size(),
+      enclave_info->paging_key, iv, &virtual_addr, sizeof(virtual_addr),
+      (const uint8_t*)mac_addr)) {
+    write_page_table_entry(call.entry_addr, 0, page_addr,
+        page_table_entry_acl(call.entry_addr, 0));
+    paging_info->slot_version[call.slot] = 0;
+  } else {
+    // NOTE: unseal_copy() already cleared the page.
+    paging_info->free_pages[paging_info->free_page_count] = page_addr;
+    paging_info->free_page_count += 1;
+    result = monitor_invalid_value;
+  }
+
+  end_paging_call(&call);
+  return result;
+}
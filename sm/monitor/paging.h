@@ -0,0 +1,43 @@
+#ifndef MONITOR_PAGING_H_INCLUDED
+#define MONITOR_PAGING_H_INCLUDED
+
+#include <arch/base_types.h>
+#include <public/api.h>
+#include "enclave.h"
+
+// Enclave paging lets the OS move enclave pages out to its own memory, and
+// bring them back later, so enclaves can have more virtual memory than the
+// DRAM regions assigned to them.
+//
+// An evicted page is sealed (see crypto/sealing.h) under the enclave's paging
+// key, with the page's version as the IV, and its virtual address as the
+// associated data. The version is kept by the monitor in a paging slot, so
+// the OS cannot replay an older copy of a page, or reload a page twice.
+
+// The per-enclave paging structure stored in metadata regions.
+//
+// The structure takes up a single metadata page.
+typedef struct {
+  // Number of valid entries in free_pages.
+  size_t free_page_count;
+
+  // Physical pages freed by evictions into this structure's slots.
+  //
+  // These pages belong to the enclave. They are cleared, unmapped, and used
+  // to back the reloads of this structure's slots.
+  uintptr_t free_pages[paging_slot_count];
+
+  // The version of the page evicted into each slot, or 0 for free slots.
+  uint64_t slot_version[paging_slot_count];
+} paging_info_t;
+//static_assert(sizeof(paging_info_t) <= page_size(),
+//    "The paging structure must fit in a metadata page");
+
+// Derives the paging keys for a newly created enclave.
+//
+// The caller must hold the lock for the metadata region of the enclave
+// metadata.
+void init_enclave_paging_keys(enclave_info_t* enclave_info,
+    enclave_id_t enclave_id);
+
+#endif  // !defined(MONITOR_PAGING_H_INCLUDED)
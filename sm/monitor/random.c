@@ -0,0 +1,45 @@
+#include <public/api.h>
+
+#include <sanctum_config.h>
+#include <arch/cpu_context.h>
+#include "cpu_core_inl.h"
+#include "dram_regions_inl.h"
+#include "metadata_inl.h"
+
+// NOTE: The core's index is mixed into the seed, so two cores never end up
+//       with the same generator state, even if the TRNG misbehaves.
+void seed_core_random(core_info_t* core_info, size_t core) {
+  uintptr_t seed[drbg_seed_size / sizeof(uintptr_t) + 1];
+  for (size_t i = 0; i < drbg_seed_size / sizeof(uintptr_t); ++i)
+    seed[i] = read_trng();
+  seed[drbg_seed_size / sizeof(uintptr_t)] = core;
+
+  drbg_seed(&core_info->drbg, seed, sizeof(seed), SM_RANDOM_RESEED_BYTES);
+
+  volatile uintptr_t* secret = seed;
+  for (size_t i = 0; i < sizeof(seed) / sizeof(uintptr_t); ++i)
+    secret[i] = 0;
+}
+
+api_result_t get_random(uintptr_t phys_addr, size_t size) {
+  if (size == 0 || size > random_max_size)
+    return monitor_invalid_value;
+
+  enclave_id_t enclave_id = current_enclave();
+  size_t dram_region;
+  api_result_t result = lock_caller_buffer(enclave_id, phys_addr, size,
+      &dram_region);
+  if (result != monitor_ok)
+    return result;
+
+  // NOTE: The generator belongs to this core, and monitor calls are not
+  //       interrupted, so it needs no lock. The DRAM region lock only keeps the
+  //       buffer owned by the caller.
+  core_info_t* core_info = current_core_info();
+  if (drbg_needs_seed(&core_info->drbg))
+    seed_core_random(core_info, current_core());
+  drbg_generate(&core_info->drbg, (void*)phys_addr, size);
+
+  clear_dram_region_lock(dram_region);
+  return monitor_ok;
+}
@@ -0,0 +1,123 @@
+#include "scrub.h"
+
+#include <arch/cpu_context.h>
+#include <arch/memory.h>
+#include "cpu_core.h"
+#include "dram_regions_inl.h"
+
+scrub_job_t g_scrub;
+
+// Reads a counter shared by the cores taking part in a scrub job.
+//
+// NOTE: atomic_load() is a plain read, which the compiler may hoist out of a
+//       spin loop. Adding 0 atomically forces a fresh read.
+static inline size_t read_scrub_counter(size_t* counter) {
+  return atomic_fetch_add(counter, 0);
+}
+
+// The log2 of the size of the chunks in the current job.
+static inline size_t scrub_chunk_bits() {
+  return (g_dram_region_shift < scrub_chunk_shift) ?
+      g_dram_region_shift : scrub_chunk_shift;
+}
+
+// The number of chunks that make up a DRAM region.
+static inline size_t scrub_chunks_per_region() {
+  const size_t region_bits = g_dram_stripe_shift - g_dram_region_shift;
+  return g_dram_size >> (region_bits + scrub_chunk_bits());
+}
+
+// The physical address of a chunk in the current job.
+static uintptr_t scrub_chunk_start(size_t chunk) {
+  const size_t chunks_per_region = scrub_chunks_per_region();
+  // NOTE: relying on the compiler to optimize division to bitwise shift
+  const size_t dram_region = g_scrub.regions[chunk / chunks_per_region];
+
+  // The chunk's offset in the region, if the region's stripes were contiguous.
+  const uintptr_t offset = (chunk % chunks_per_region) << scrub_chunk_bits();
+  const uintptr_t stripe = offset >> g_dram_region_shift;
+  return (stripe << g_dram_stripe_shift) |
+      (dram_region << g_dram_region_shift) |
+      (offset & (g_dram_stripe_size - 1));
+}
+
+// Claims and zeroes chunks of the current job until none are left.
+static void scrub_chunks() {
+  const size_t chunk_size = (size_t)1 << scrub_chunk_bits();
+  while (true) {
+    size_t chunk = atomic_fetch_add(&g_scrub.next_chunk, 1);
+    if (chunk >= g_scrub.chunk_count)
+      break;
+    bzero((void*)scrub_chunk_start(chunk), chunk_size);
+    atomic_fetch_add(&g_scrub.done_chunks, 1);
+  }
+}
+
+void help_scrub_dram_regions() {
+  // NOTE: The starting core waits for helpers to leave before it changes the
+  //       job, so a helper that sees an active job can use all its fields.
+  atomic_fetch_add(&g_scrub.helpers, 1);
+  if (read_scrub_counter(&g_scrub.active) != 0)
+    scrub_chunks();
+  atomic_fetch_sub(&g_scrub.helpers, 1);
+}
+
+// Runs a job over the first `region_count` entries in g_scrub.regions.
+//
+// The caller must hold the job lock, which is released when the job ends.
+static void run_scrub_job(size_t region_count) {
+  g_scrub.chunk_count = region_count * scrub_chunks_per_region();
+  g_scrub.next_chunk = 0;
+  g_scrub.done_chunks = 0;
+  atomic_fetch_add(&g_scrub.active, 1);
+
+  // NOTE: Cores running enclaves are left alone, as the interrupt would cause
+  //       an asynchronous enclave exit. A core that enters an enclave after
+  //       this check gets an exit, and helps once it is back in the OS.
+  const size_t current = current_core();
+  for (size_t core = 0; core < g_core_count; ++core) {
+    if (core != current && g_core[core].enclave_id == null_enclave_id)
+      send_scrub_ipi(core);
+  }
+
+  scrub_chunks();
+  while (read_scrub_counter(&g_scrub.done_chunks) < g_scrub.chunk_count) {
+    // spin
+  }
+
+  atomic_fetch_sub(&g_scrub.active, 1);
+  while (read_scrub_counter(&g_scrub.helpers) != 0) {
+    // spin
+  }
+  atomic_flag_clear(&g_scrub.lock);
+}
+
+void scrub_dram_regions(const size_t* regions, size_t region_count) {
+  if (atomic_flag_test_and_set(&g_scrub.lock)) {
+    // Another core's job is using the helpers. Zeroing the regions here is
+    // slower, but it doesn't wait on an unrelated monitor call.
+    for (size_t i = 0; i < region_count; ++i)
+      bzero_dram_region(regions[i]);
+    return;
+  }
+
+  for (size_t i = 0; i < region_count; ++i)
+    g_scrub.regions[i] = regions[i];
+  run_scrub_job(region_count);
+}
+
+void scrub_dram_region_bitmap(size_t* region_bitmap) {
+  if (atomic_flag_test_and_set(&g_scrub.lock)) {
+    for_each_set_bitmap_bit(dram_region, region_bitmap, g_dram_region_count)
+      bzero_dram_region(dram_region);
+    return;
+  }
+
+  size_t region_count = 0;
+  for_each_set_bitmap_bit(dram_region, region_bitmap, g_dram_region_count)
+    g_scrub.regions[region_count++] = dram_region;
+  if (region_count != 0)
+    run_scrub_job(region_count);
+  else
+    atomic_flag_clear(&g_scrub.lock);
+}
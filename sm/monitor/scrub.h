@@ -0,0 +1,64 @@
+#ifndef MONITOR_SCRUB_H_INCLUDED
+#define MONITOR_SCRUB_H_INCLUDED
+
+#include <arch/base_types.h>
+#include <arch/atomics.h>
+
+// Zeroes DRAM regions with the help of the cores that are running the OS.
+//
+// A scrub job splits its regions into chunks of scrub_chunk_size bytes. The
+// core that starts the job interrupts the other cores running the OS, and all
+// of them claim chunks from a shared counter until none are left. The job
+// ends once every chunk is zeroed, so the regions are clean when the call
+// that started the job returns.
+
+// The size of the unit of scrubbing work, in bytes.
+//
+// Chunks never cross a DRAM stripe. Stripes smaller than a chunk are zeroed
+// in one piece.
+#define scrub_chunk_shift 18
+#define scrub_chunk_size (1 << scrub_chunk_shift)
+// 256 KiB
+
+// The scrub job shared by all cores.
+typedef struct {
+  // Held by the core that started the job, until every helper has left.
+  atomic_flag lock;
+
+  // Non-zero while chunks may be claimed.
+  size_t active;
+
+  // The number of cores inside help_scrub_dram_regions().
+  size_t helpers;
+
+  // The indices of the DRAM regions being zeroed.
+  //
+  // Allocated at boot time, with room for every DRAM region.
+  size_t* regions;
+
+  size_t chunk_count;  // chunks in the job
+  size_t next_chunk;  // the next chunk to be claimed
+  size_t done_chunks;  // chunks zeroed so far
+} scrub_job_t;
+
+extern scrub_job_t g_scrub;
+
+// Zeroes the `region_count` DRAM regions listed in `regions`.
+//
+// The caller must hold the locks of all the regions. If another core is
+// running a scrub job, the caller zeroes the regions on its own.
+void scrub_dram_regions(const size_t* regions, size_t region_count);
+
+// Zeroes the DRAM regions whose bits are set in a DRAM region bitmap.
+//
+// This is scrub_dram_regions() for the batched DRAM region calls, so a batch
+// of dirty regions is zeroed by a single job.
+void scrub_dram_region_bitmap(size_t* region_bitmap);
+
+// Zeroes chunks of the current scrub job, if there is one.
+//
+// This is called in machine mode on the cores interrupted by
+// scrub_dram_regions().
+void help_scrub_dram_regions();
+
+#endif  // !defined(MONITOR_SCRUB_H_INCLUDED)
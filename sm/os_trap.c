@@ -9,6 +9,7 @@
 #include <devices/uart.h>
 #include <platform/platform_interface.h>
 #include <public/api.h>
+#include <crypto/signing_key.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -50,6 +51,10 @@ static uintptr_t mcall_console_putchar(uint8_t ch)
 
 void poweroff()
 {
+  // DRAM is not necessarily erased before the next boot, so the monitor's keys
+  // must not outlive it.
+  wipe_monitor_signing_key();
+
   if (platform__use_htif()) {
     htif_poweroff();
   } else {
@@ -87,6 +92,11 @@ static void send_ipi(uintptr_t recipient, int event)
   *OTHER_HLS(recipient)->ipi = 1;
 }
 
+void send_scrub_ipi(size_t core)
+{
+  send_ipi(core, IPI_SCRUB);
+}
+
 static uintptr_t mcall_console_getchar()
 {
   if (uart) {
@@ -159,6 +169,9 @@ void ecall_from_s_trap(uintptr_t* regs, uintptr_t mcause, uintptr_t mepc)
   switch (n)
   {
     // SM calls from OS Kernel
+    case SBI_SM_OS_BLOCK_DRAM_REGION:
+      retval = block_dram_region((size_t)arg0);
+      break;
     case SBI_SM_OS_SET_DMA_RANGE:
       retval = set_dma_range((uintptr_t)arg0, (uintptr_t)arg1);
       break;
@@ -177,6 +190,18 @@ void ecall_from_s_trap(uintptr_t* regs, uintptr_t mcause, uintptr_t mepc)
     case SBI_SM_OS_FLUSH_CACHED_DRAM_REGIONS:
       retval = flush_cached_dram_regions();
       break;
+    case SBI_SM_OS_CLEAN_DRAM_REGION:
+      retval = clean_dram_region();
+      break;
+    case SBI_SM_OS_ASSIGN_DRAM_REGIONS:
+      retval = assign_dram_regions((uintptr_t)arg0, (enclave_id_t)arg1);
+      break;
+    case SBI_SM_OS_BLOCK_DRAM_REGIONS:
+      retval = block_dram_regions((uintptr_t)arg0);
+      break;
+    case SBI_SM_OS_FREE_DRAM_REGIONS:
+      retval = free_dram_regions((uintptr_t)arg0);
+      break;
     case SBI_SM_OS_CREATE_METADATA_REGION:
       retval = create_metadata_region((size_t)arg0);
       break;
@@ -243,6 +268,29 @@ void ecall_from_s_trap(uintptr_t* regs, uintptr_t mcause, uintptr_t mepc)
       retval = copy_debug_enclave_page((enclave_id_t)arg0,
           (uintptr_t)arg1, (uintptr_t)arg2, (bool)arg3);
       break;
+    case SBI_SM_OS_ASSIGN_PAGING_PAGE:
+      retval = assign_paging_page((enclave_id_t)arg0, (uintptr_t)arg1);
+      break;
+    case SBI_SM_OS_FREE_PAGING_PAGE:
+      retval = free_paging_page((enclave_id_t)arg0, (uintptr_t)arg1);
+      break;
+    case SBI_SM_OS_EVICT_ENCLAVE_PAGE:
+      arg2 = regs[12];
+      arg3 = regs[13];
+      arg4 = regs[14];
+      retval = evict_enclave_page((enclave_id_t)arg0, (uintptr_t)arg1,
+          (uintptr_t)arg2, (uintptr_t)arg3, (paging_slot_id_t)arg4);
+      break;
+    case SBI_SM_OS_RELOAD_ENCLAVE_PAGE:
+      arg2 = regs[12];
+      arg3 = regs[13];
+      arg4 = regs[14];
+      retval = reload_enclave_page((enclave_id_t)arg0, (uintptr_t)arg1,
+          (uintptr_t)arg2, (uintptr_t)arg3, (paging_slot_id_t)arg4);
+      break;
+    case SBI_SM_OS_GET_RANDOM:
+      retval = get_random((uintptr_t)arg0, (size_t)arg1);
+      break;
 
     // Standard OS calls
     case SBI_CONSOLE_PUTCHAR:
@@ -23,6 +23,10 @@ typedef uintptr_t thread_id_t;
 // A mailbox ID is the index of the mailbox's structure in an array.
 typedef size_t mailbox_id_t;
 
+// A paging slot ID is the physical address of an enclave paging structure plus
+// the slot's index in the structure. See evict_enclave_page().
+typedef uintptr_t paging_slot_id_t;
+
 // Error codes returned from monitor API calls.
 typedef enum {
   // API call succeeded.
@@ -101,6 +105,22 @@ size_t dram_region_mask();
 // confidential information from the DRAM region.
 api_result_t block_dram_region(size_t dram_region);
 
+// Blocks a batch of DRAM regions that are owned by the caller.
+//
+// `region_bitmap` is the physical address of a DRAM region bitmap, with one
+// bit per DRAM region in the system, rounded up to whole uintptr_t words. The
+// regions whose bits are set make up the batch. The bitmap must be in memory
+// owned by the caller.
+//
+// The call succeeds only if block_dram_region() would succeed on every region
+// in the batch. Otherwise, no region is blocked. The batch's regions are
+// locked in increasing index order, and monitor_concurrent_call is returned if
+// any of them is locked by another API call.
+//
+// This is much faster than blocking the regions one by one, as the DRAM region
+// bitmaps and the protection hardware are only updated once.
+api_result_t block_dram_regions(uintptr_t region_bitmap);
+
 //namespace enclave {  // sanctum::api::enclave
 
 // Returns monitor_ok if the given DRAM region is owned by the calling enclave.
@@ -136,6 +156,42 @@ api_result_t exit_enclave();
 // belongs to the enclave.
 api_result_t get_attestation_key(uintptr_t phys_addr);
 
+// Has the monitor attest to the calling enclave's measurement.
+//
+// `phys_addr` must point to an attestation_report_t whose `data` was filled in
+// by the enclave. The entire structure must be contained in a single DRAM
+// region that belongs to the enclave.
+//
+// Reports submitted close together are signed as one batch, so the call
+// returns monitor_concurrent_call while the caller's report waits for its
+// batch to be signed. The caller should retry with the same report until the
+// call returns monitor_ok. At that point, the monitor has filled in the rest of
+// the report.
+api_result_t attest_enclave(uintptr_t phys_addr);
+
+// Computes an X25519 shared secret for the calling enclave.
+//
+// `phys_addr` must point to an x25519_request_t whose private_key and
+// public_key were filled in by the enclave. The entire structure must be
+// contained in a single DRAM region that belongs to the enclave. The monitor
+// fills in shared_secret.
+//
+// Passing the X25519 base point (9) as public_key yields the public key that
+// matches private_key. Returns monitor_invalid_value, and zeros the shared
+// secret, if public_key has small order.
+api_result_t x25519_key_agreement(uintptr_t phys_addr);
+
+// Fills a buffer with random bytes from the monitor's generator.
+//
+// This can be called by enclaves and by the OS. `phys_addr` must point to a
+// uintptr_t-aligned buffer of `size` bytes, which must be contained in a single
+// DRAM region that belongs to the caller. `size` must be at most
+// random_max_size.
+//
+// Each core has its own generator, which is seeded from the TRNG and reseeded
+// periodically, so the call is much faster than reading the TRNG.
+api_result_t get_random(uintptr_t phys_addr, size_t size);
+
 // Prepares a mailbox to receive a message from another enclave.
 //
 // The mailbox will discard any message that it might contain.
@@ -189,6 +245,53 @@ typedef struct {
 //static_assert(measurement_size % sizeof(uintptr_t) == 0,
 //    "The enclave measurement size must be a multiple of the uintptr_t size");
 
+// The height of the Merkle tree over a batch of attestation reports.
+#define attestation_batch_depth 4
+
+// The maximum number of attestation reports signed at once.
+#define attestation_batch_size (1 << attestation_batch_depth)
+
+// The size of the enclave-supplied data in an attestation report, in bytes.
+#define attestation_data_size 64
+
+// An attestation report, and the proof that the monitor signed it.
+//
+// The report is the leaf of a SHA3-512 Merkle tree (see crypto/merkle_tree.h)
+// whose leaf data is enclave_hash followed by data. The monitor signs the
+// 64-byte tree root with its attestation key (PK_SM), so a verifier rebuilds
+// the root from the leaf and the path, and checks root_signature against it.
+typedef struct {
+  // The enclave's measurement. This is filled in by the monitor.
+  uintptr_t enclave_hash[measurement_size / sizeof(uintptr_t)];
+
+  // Data chosen by the enclave, such as the hash of a key or a nonce.
+  uint8_t data[attestation_data_size];
+
+  // The leaf's position in the batch.
+  size_t leaf_index;
+
+  // The sibling hashes on the leaf's path to the root, starting at the leaf.
+  //
+  // Bit i of leaf_index is set if path[i] is the left child.
+  uint8_t path[attestation_batch_depth][64];
+
+  // The monitor's signature over the root of the batch's Merkle tree.
+  uint8_t root_signature[64];
+} attestation_report_t;
+
+// The size of X25519 keys and shared secrets, in bytes.
+#define x25519_key_size 32
+
+// The parameters and result of an X25519 key agreement.
+typedef struct {
+  uint8_t private_key[x25519_key_size];
+  uint8_t public_key[x25519_key_size];  // The peer's public key.
+  uint8_t shared_secret[x25519_key_size];
+} x25519_request_t;
+
+// The largest number of bytes returned by one get_random() call.
+#define random_max_size 4096
+
 // The size of a message carried by a mailbox, in bytes.
 #define mailbox_message_size 128
 
@@ -223,8 +326,9 @@ typedef enum {
   dram_region_invalid = 0,
   dram_region_free = 1,
   dram_region_blocked = 2,
-  dram_region_locked = 3,
+  dram_region_locked = 3,  // no longer returned; see dram_region_state()
   dram_region_owned = 4,
+  dram_region_dirty = 5,
 } dram_region_state_t;
 
 // Sets the memory range that allows DMA transfers.
@@ -234,27 +338,69 @@ api_result_t set_dma_range(uintptr_t base, uintptr_t mask);
 
 // Returns the state of the DRAM region with the given index.
 //
+// A dirty DRAM region is free, but still holds a deleted enclave's data. It can
+// be assigned like a free region, but the call that assigns it has to zero it
+// first, so the OS should prefer free regions.
+//
 // Returns dram_region_invalid if the given DRAM region index is invalid.
-// Returns dram_region_locked if the given DRAM region is currently locked by
-// another API call.
+//
+// This never takes the DRAM region's lock, so it doesn't fail or slow down
+// other API calls while they are using the region. If the region is changing,
+// the state from just before or just after the change is returned.
 dram_region_state_t dram_region_state(size_t dram_region);
 
 // Returns the owner of the DRAM region with the given index.
 //
-// Returns null_enclave_id if the given DRAM region index is invalid, locked by
-// another operation, or if the region is not in the owned state.
+// Returns null_enclave_id if the given DRAM region index is invalid, or if the
+// region is not in the owned state.
+//
+// Like dram_region_state(), this never takes the DRAM region's lock.
 enclave_id_t dram_region_owner(size_t dram_region);
 
-// Assigns a free DRAM region to an enclave or to the OS.
+// Assigns a free or dirty DRAM region to an enclave or to the OS.
 //
 // `new_owner` is the enclave ID of the enclave that will own the DRAM region.
 // 0 means that the DRAM region will be assigned to the OS.
 //
+// Dirty DRAM regions are zeroed before this returns, which takes much longer
+// than assigning a free region.
 api_result_t assign_dram_region(size_t dram_region, enclave_id_t new_owner);
 
+// Assigns a batch of free or dirty DRAM regions to an enclave or to the OS.
+//
+// `region_bitmap` is the physical address of a DRAM region bitmap that selects
+// the batch. See block_dram_regions() for its layout. The bitmap must be in
+// memory owned by the OS.
+//
+// The call succeeds only if assign_dram_region() would succeed on every region
+// in the batch. Otherwise, no region is assigned. All the batch's dirty
+// regions are zeroed together, with the help of the other cores running the
+// OS.
+api_result_t assign_dram_regions(uintptr_t region_bitmap,
+    enclave_id_t new_owner);
+
 // Frees a DRAM region that was previously locked.
 api_result_t free_dram_region(size_t dram_region);
 
+// Frees a batch of DRAM regions that were previously locked.
+//
+// `region_bitmap` is the physical address of a DRAM region bitmap that selects
+// the batch. See block_dram_regions() for its layout. The bitmap must be in
+// memory owned by the OS.
+//
+// The call succeeds only if free_dram_region() would succeed on every region
+// in the batch. Otherwise, no region is freed.
+api_result_t free_dram_regions(uintptr_t region_bitmap);
+
+// Zeroes one dirty DRAM region, which then becomes free.
+//
+// The region is zeroed by the calling core. The OS should call this when a
+// core is idle, so dirty regions are cleaned before they are needed.
+//
+// Returns monitor_invalid_state if there are no dirty DRAM regions, and
+// monitor_concurrent_call if every dirty region is locked by another call.
+api_result_t clean_dram_region();
+
 // Performs the TLB flushes needed to free a locked region.
 //
 // System software must invoke this call instead of flushing the TLB directly,
@@ -262,7 +408,7 @@ api_result_t free_dram_region(size_t dram_region);
 // has occurred.
 api_result_t flush_cached_dram_regions();
 
-// Reserves a free DRAM region to hold enclave metadata.
+// Reserves a free or dirty DRAM region to hold enclave metadata.
 //
 // DRAM regions that hold enclave metadata can be freed directly by calling
 // free_dram_region(). Calling block_dram_region() on them will fail.
@@ -398,6 +544,9 @@ api_result_t delete_thread(thread_id_t thread_id);
 //
 // This can only be called when there is no thread metadata associated with the
 // enclave.
+//
+// The enclave's DRAM regions become dirty, and are zeroed later, by
+// clean_dram_region() or by the call that assigns them again.
 api_result_t delete_enclave(enclave_id_t enclave_id);
 
 // Reads/writes a page from/to a debug enclave's memory.
@@ -409,6 +558,71 @@ api_result_t delete_enclave(enclave_id_t enclave_id);
 api_result_t copy_debug_enclave_page(enclave_id_t enclave_id,
     uintptr_t enclave_addr, uintptr_t os_addr, bool read_from_enclave);
 
+// The number of slots in an enclave paging structure.
+//
+// Each slot keeps track of one evicted enclave page.
+#define paging_slot_count 255
+
+// The size of the MAC that authenticates an evicted enclave page, in bytes.
+//
+// This is the AES-GCM tag size of the monitor's sealing code.
+#define evicted_page_mac_size 16
+
+// Creates a paging structure that holds slots for an enclave's evicted pages.
+//
+// `enclave_id` must identify an enclave that has been initialized.
+//
+// `phys_addr` must be the physical address of a free page in a DRAM metadata
+// region. Its slots are identified by the IDs phys_addr to
+// phys_addr + paging_slot_count - 1.
+api_result_t assign_paging_page(enclave_id_t enclave_id, uintptr_t phys_addr);
+
+// Frees an enclave paging structure created by assign_paging_page().
+//
+// This fails if any of the structure's slots holds an evicted page.
+api_result_t free_paging_page(enclave_id_t enclave_id, uintptr_t phys_addr);
+
+// Encrypts a page of an initialized enclave out to OS memory.
+//
+// The page mapped at `virtual_addr` by the enclave's page tables (the tables
+// rooted at the EPTBR set while the enclave was loaded) is encrypted under a
+// key that only the monitor knows, and written to the page at `os_addr`. The
+// MAC that authenticates it is written at `mac_addr`. The enclave's page
+// table entry is invalidated, and the physical page is cleared and kept in
+// the slot's paging structure, to back a later reload_enclave_page() call.
+//
+// `slot_id` must be a free slot in a paging structure that belongs to the
+// enclave. Each eviction records a new version number in the slot, so an
+// evicted page can only be reloaded once, from the slot it was evicted to.
+//
+// `os_addr` must point to a page in a DRAM region owned by the OS, and
+// `mac_addr` must point to evicted_page_mac_size bytes in the same DRAM region.
+//
+// The enclave must not be running on any core. Its threads must be stopped
+// (e.g., by AEX) before its pages are evicted.
+//
+// Enclaves whose pages get evicted must not map a physical page at more than
+// one virtual address, and must not map the pages held by their paging
+// structures.
+api_result_t evict_enclave_page(enclave_id_t enclave_id,
+    uintptr_t virtual_addr, uintptr_t os_addr, uintptr_t mac_addr,
+    paging_slot_id_t slot_id);
+
+// Loads a page evicted by evict_enclave_page() back into an enclave.
+//
+// The arguments must match the evict_enclave_page() call, and the page at
+// `os_addr` and the MAC at `mac_addr` must not have been modified. The page is
+// decrypted into a physical page taken from the slot's paging structure, and
+// the enclave's page table entry for `virtual_addr` is restored to point to
+// it. The slot is freed.
+//
+// If the MAC does not match, nothing changes and the call returns
+// monitor_invalid_value. The call returns monitor_invalid_state if the enclave
+// has blocked the DRAM regions of all the pages held by the paging structure.
+api_result_t reload_enclave_page(enclave_id_t enclave_id,
+    uintptr_t virtual_addr, uintptr_t os_addr, uintptr_t mac_addr,
+    paging_slot_id_t slot_id);
+
 //};  // namespace sanctum::api::os
 //};  // namespace sanctum::api
 //};  // namespace sanctum
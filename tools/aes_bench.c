@@ -0,0 +1,145 @@
+// Host benchmark for the AES modes in common/aes.
+//
+// Reports the cost of encrypting one page in each mode, after checking the
+// cipher against the ECB-AES128 vectors of NIST SP 800-38A (listed at the top
+// of common/aes/aes.c), and GCM against test case 4 of the GCM specification:
+//
+//   aes_bench [PAGES [ROUNDS]]
+//
+// Costs are in cycles per page on hosts with a cycle counter (x86-64 and
+// RISC-V), and in nanoseconds per page elsewhere. The best of ROUNDS runs over
+// PAGES pages is reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aes/aes.h"
+#include "aes_kat.h"
+
+#if defined(__x86_64__)
+#define COST_UNIT "cycles"
+static inline uint64_t read_cost_counter() {
+  return __builtin_ia32_rdtsc();
+}
+#elif defined(__riscv)
+#define COST_UNIT "cycles"
+static inline uint64_t read_cost_counter() {
+  uint64_t cycles;
+  asm volatile ("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+#else
+#define COST_UNIT "ns"
+static inline uint64_t read_cost_counter() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
+
+#define page_size 4096
+
+typedef enum {
+  bench_ecb_encrypt,
+  bench_cbc_encrypt,
+  bench_cbc_decrypt,
+  bench_ctr_xcrypt,
+  bench_gcm_encrypt,
+} bench_kind_t;
+
+static const char* const bench_names[] = {
+  "AES_ECB_encrypt",
+  "AES_CBC_encrypt_buffer",
+  "AES_CBC_decrypt_buffer",
+  "AES_CTR_xcrypt_buffer",
+  "AES_GCM_encrypt_buffer",
+};
+
+// Runs `kind` over `page_count` pages and returns the cost counter delta.
+static uint64_t run_once(bench_kind_t kind, struct AES_ctx* ctx,
+    struct AES_gcm_ctx* gcm, uint8_t* pages, size_t page_count) {
+  uint8_t tag[AES_GCM_TAGLEN];
+  uint64_t start = read_cost_counter();
+
+  for (size_t page = 0; page < page_count; ++page) {
+    uint8_t* buf = pages + page * page_size;
+    switch (kind) {
+      case bench_ecb_encrypt:
+        AES_ECB_encrypt_blocks(ctx, buf, page_size);
+        break;
+      case bench_cbc_encrypt:
+        AES_CBC_encrypt_buffer(ctx, buf, page_size);
+        break;
+      case bench_cbc_decrypt:
+        AES_CBC_decrypt_buffer(ctx, buf, page_size);
+        break;
+      case bench_ctr_xcrypt:
+        AES_CTR_xcrypt_buffer(ctx, buf, page_size);
+        break;
+      case bench_gcm_encrypt:
+        AES_GCM_start(gcm, ctx->Iv, NULL, 0);
+        AES_GCM_encrypt_buffer(gcm, buf, page_size);
+        AES_GCM_finish(gcm, tag);
+        break;
+    }
+  }
+
+  return read_cost_counter() - start;
+}
+
+int main(int argc, char** argv) {
+  size_t page_count = (argc > 1) ? strtoull(argv[1], NULL, 0) : 64;
+  size_t rounds = (argc > 2) ? strtoull(argv[2], NULL, 0) : 20;
+  if (argc > 3 || page_count == 0 || rounds == 0) {
+    fprintf(stderr, "usage: aes_bench [PAGES [ROUNDS]]\n");
+    return 2;
+  }
+
+  if (AES_KEYLEN == 16 && !check_known_answer()) {
+    fprintf(stderr, "aes_bench: AES does not match SP 800-38A\n");
+    return 1;
+  }
+  if (AES_KEYLEN == 16 && !check_gcm_known_answer()) {
+    fprintf(stderr, "aes_bench: AES-GCM does not match test case 4\n");
+    return 1;
+  }
+
+  uint8_t* pages = malloc(page_count * page_size);
+  if (pages == NULL) {
+    fprintf(stderr, "aes_bench: out of memory\n");
+    return 1;
+  }
+  for (size_t i = 0; i < page_count * page_size; ++i)
+    pages[i] = (uint8_t)(i * 131 + 7);
+
+  uint8_t key[AES_KEYLEN];
+  uint8_t iv[AES_BLOCKLEN];
+  for (size_t i = 0; i < sizeof(key); ++i)
+    key[i] = (uint8_t)(i * 17);
+  for (size_t i = 0; i < sizeof(iv); ++i)
+    iv[i] = (uint8_t)(0xf0 | i);
+
+  struct AES_ctx ctx;
+  struct AES_gcm_ctx gcm;
+  AES_init_ctx_iv(&ctx, key, iv);
+  AES_GCM_init_ctx(&gcm, key);
+
+  printf("AES-%d, %zu pages, best of %zu\n", AES_KEYLEN * 8, page_count,
+      rounds);
+  for (int kind = bench_ecb_encrypt; kind <= bench_gcm_encrypt; ++kind) {
+    uint64_t best = UINT64_MAX;
+    for (size_t round = 0; round < rounds; ++round) {
+      uint64_t cost = run_once((bench_kind_t)kind, &ctx, &gcm, pages,
+          page_count);
+      if (cost < best)
+        best = cost;
+    }
+    printf("  %-24s %10.1f %s/page\n", bench_names[kind],
+        (double)best / page_count, COST_UNIT);
+  }
+
+  free(pages);
+  return 0;
+}
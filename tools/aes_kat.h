@@ -0,0 +1,170 @@
+// Known-answer checks for common/aes, shared by the host tools.
+//
+// The cipher is checked against the ECB-AES128 and CBC-AES128 vectors of NIST
+// SP 800-38A (the ECB ones are listed at the top of common/aes/aes.c), and GCM
+// against test case 4 of the GCM specification.
+
+#ifndef TOOLS_AES_KAT_H_INCLUDED
+#define TOOLS_AES_KAT_H_INCLUDED
+
+#include <string.h>
+
+#include "aes/aes.h"
+
+static const uint8_t sp800_38a_key[16] = {
+  0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+  0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static const uint8_t sp800_38a_plaintext[64] = {
+  0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+  0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+  0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+  0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+  0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+  0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+  0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+  0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+static const uint8_t sp800_38a_ecb_ciphertext[64] = {
+  0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60,
+  0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+  0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d,
+  0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+  0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23,
+  0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+  0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f,
+  0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4,
+};
+
+static const uint8_t sp800_38a_cbc_iv[AES_BLOCKLEN] = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+  0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static const uint8_t sp800_38a_cbc_ciphertext[64] = {
+  0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+  0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+  0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+  0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+  0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+  0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+  0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+  0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+
+// GCM test case 4, from McGrew and Viega, "The Galois/Counter Mode of
+// Operation (GCM)".
+static const uint8_t gcm_key[16] = {
+  0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c,
+  0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08,
+};
+
+static const uint8_t gcm_iv[AES_GCM_IVLEN] = {
+  0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88,
+};
+
+static const uint8_t gcm_aad[20] = {
+  0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed,
+  0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2,
+};
+
+static const uint8_t gcm_plaintext[60] = {
+  0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5,
+  0xa5, 0x59, 0x09, 0xc5, 0xaf, 0xf5, 0x26, 0x9a,
+  0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda,
+  0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72,
+  0x1c, 0x3c, 0x0c, 0x95, 0x95, 0x68, 0x09, 0x53,
+  0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+  0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57,
+  0xba, 0x63, 0x7b, 0x39,
+};
+
+static const uint8_t gcm_ciphertext[60] = {
+  0x42, 0x83, 0x1e, 0xc2, 0x21, 0x77, 0x74, 0x24,
+  0x4b, 0x72, 0x21, 0xb7, 0x84, 0xd0, 0xd4, 0x9c,
+  0xe3, 0xaa, 0x21, 0x2f, 0x2c, 0x02, 0xa4, 0xe0,
+  0x35, 0xc1, 0x7e, 0x23, 0x29, 0xac, 0xa1, 0x2e,
+  0x21, 0xd5, 0x14, 0xb2, 0x54, 0x66, 0x93, 0x1c,
+  0x7d, 0x8f, 0x6a, 0x5a, 0xac, 0x84, 0xaa, 0x05,
+  0x1b, 0xa3, 0x0b, 0x39, 0x6a, 0x0a, 0xac, 0x97,
+  0x3d, 0x58, 0xe0, 0x91,
+};
+
+static const uint8_t gcm_tag[AES_GCM_TAGLEN] = {
+  0x5b, 0xc9, 0x4f, 0xbc, 0x32, 0x21, 0xa5, 0xdb,
+  0x94, 0xfa, 0xe9, 0x5a, 0xe7, 0x12, 0x1a, 0x47,
+};
+
+// Checks single-block and multi-block encryption, and decryption, against
+// the ECB and CBC vectors. Only meaningful for AES-128.
+static int check_known_answer() {
+  struct AES_ctx ctx;
+  uint8_t buf[64];
+
+  AES_init_ctx(&ctx, sp800_38a_key);
+
+  memcpy(buf, sp800_38a_plaintext, sizeof(buf));
+  for (size_t i = 0; i < sizeof(buf); i += AES_BLOCKLEN)
+    AES_ECB_encrypt(&ctx, buf + i);
+  if (memcmp(buf, sp800_38a_ecb_ciphertext, sizeof(buf)) != 0)
+    return 0;
+
+  for (size_t i = 0; i < sizeof(buf); i += AES_BLOCKLEN)
+    AES_ECB_decrypt(&ctx, buf + i);
+  if (memcmp(buf, sp800_38a_plaintext, sizeof(buf)) != 0)
+    return 0;
+
+  AES_ECB_encrypt_blocks(&ctx, buf, sizeof(buf));
+  if (memcmp(buf, sp800_38a_ecb_ciphertext, sizeof(buf)) != 0)
+    return 0;
+
+  // CBC, with the chaining value carried over between calls.
+  memcpy(buf, sp800_38a_plaintext, sizeof(buf));
+  AES_ctx_set_iv(&ctx, sp800_38a_cbc_iv);
+  AES_CBC_encrypt_buffer(&ctx, buf, AES_BLOCKLEN);
+  AES_CBC_encrypt_buffer(&ctx, buf + AES_BLOCKLEN, sizeof(buf) - AES_BLOCKLEN);
+  if (memcmp(buf, sp800_38a_cbc_ciphertext, sizeof(buf)) != 0)
+    return 0;
+
+  AES_ctx_set_iv(&ctx, sp800_38a_cbc_iv);
+  AES_CBC_decrypt_buffer(&ctx, buf, sizeof(buf));
+  return memcmp(buf, sp800_38a_plaintext, sizeof(buf)) == 0;
+}
+
+// Checks GCM encryption, split at a block boundary, and decryption, including
+// the rejection of a corrupted tag. Only meaningful for AES-128.
+static int check_gcm_known_answer() {
+  struct AES_gcm_ctx ctx;
+  uint8_t buf[sizeof(gcm_plaintext)];
+  uint8_t tag[AES_GCM_TAGLEN];
+
+  AES_GCM_init_ctx(&ctx, gcm_key);
+
+  memcpy(buf, gcm_plaintext, sizeof(buf));
+  AES_GCM_start(&ctx, gcm_iv, gcm_aad, sizeof(gcm_aad));
+  AES_GCM_encrypt_buffer(&ctx, buf, 2 * AES_BLOCKLEN);
+  AES_GCM_encrypt_buffer(&ctx, buf + 2 * AES_BLOCKLEN,
+      sizeof(buf) - 2 * AES_BLOCKLEN);
+  AES_GCM_finish(&ctx, tag);
+  if (memcmp(buf, gcm_ciphertext, sizeof(buf)) != 0 ||
+      memcmp(tag, gcm_tag, sizeof(tag)) != 0) {
+    return 0;
+  }
+
+  AES_GCM_start(&ctx, gcm_iv, gcm_aad, sizeof(gcm_aad));
+  AES_GCM_decrypt_buffer(&ctx, buf, sizeof(buf));
+  if (!AES_GCM_check_tag(&ctx, gcm_tag) ||
+      memcmp(buf, gcm_plaintext, sizeof(buf)) != 0) {
+    return 0;
+  }
+
+  tag[0] ^= 1;
+  memcpy(buf, gcm_ciphertext, sizeof(buf));
+  AES_GCM_start(&ctx, gcm_iv, gcm_aad, sizeof(gcm_aad));
+  AES_GCM_decrypt_buffer(&ctx, buf, sizeof(buf));
+  return !AES_GCM_check_tag(&ctx, tag);
+}
+
+#endif  // !defined(TOOLS_AES_KAT_H_INCLUDED)
@@ -0,0 +1,156 @@
+// Known-answer tests for the crypto code that has RISC-V ISA extension
+// backends.
+//
+// Checks each piece of code whose backend is picked from the __riscv_* macros
+// (see RISCV_ISA_EXT in the Makefile), so a cross build run under QEMU
+// exercises the instructions that the build enabled:
+//
+//   AES rounds (zkne, zknd)   the ECB vectors of NIST SP 800-38A
+//   GHASH (zbc, zbkc)         GCM test case 4
+//   SHA-256 (zknh)            FIPS 180-4 digests, through the SM hash engine
+//   ctz, cpop (zbb)           portable bit loops, on pseudo-random words
+//
+// The Keccak-f backend (zbb, zbkb) is checked by sha3_test.
+//
+//   crypto_kat
+//
+// Prints the failing checks and exits with status 1 on any mismatch.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sanctum_config.h"
+#include "aes/aes.h"
+#include "arch/bit_masking.h"
+#include "crypto/hash.h"
+#include "aes_kat.h"
+
+#if SM_HASH_ENGINE != SM_HASH_SHA256
+#error "crypto_kat checks the SHA-256 engine; build it with SM_HASH_ENGINE=0"
+#endif
+
+typedef struct {
+  size_t block_count;
+  const char* digest;
+} sha256_vector_t;
+
+// SHA-256 of the first `block_count` blocks of the bytes 0, 1, ..., 255, 0, ...
+static const sha256_vector_t sha256_vectors[] = {
+  { 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+  { 1, "fdeab9acf3710362bd2658cdc9a29e8f9c757fcf9811603a8c447cd1d9151108" },
+  { 3 * hash_page_size / hash_block_size,
+    "8dec5fb0de8a0b457c0cf7be559e4ef488e9cf39d5ddb0ff7464b23372ab21fa" },
+};
+
+#define sha256_message_pages 3
+
+// Formats a digest as lowercase hex.
+static void format_digest(char* hex, const uint8_t* digest, size_t size) {
+  for (size_t i = 0; i < size; ++i)
+    sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+// Checks the SHA-256 engine, block by block and, for whole pages, through
+// extend_hash_pages(). Returns the number of failures.
+static int check_sha256() {
+  static size_t message[sha256_message_pages * hash_page_size /
+      sizeof(size_t)];
+  uint8_t* message_bytes = (uint8_t*)message;
+  for (size_t i = 0; i < sizeof(message); ++i)
+    message_bytes[i] = (uint8_t)i;
+
+  int failures = 0;
+  const size_t vector_count =
+      sizeof(sha256_vectors) / sizeof(sha256_vectors[0]);
+  for (size_t i = 0; i < vector_count; ++i) {
+    const sha256_vector_t* vector = &sha256_vectors[i];
+    hash_state_t state;
+    char hex[2 * hash_result_size + 1];
+
+    init_hash(&state);
+    for (size_t block = 0; block < vector->block_count; ++block) {
+      extend_hash(&state,
+          (uint32_t*)(message_bytes + block * hash_block_size));
+    }
+    finalize_hash(&state);
+    format_digest(hex, (const uint8_t*)&state, hash_result_size);
+    if (strcmp(hex, vector->digest) != 0) {
+      fprintf(stderr, "crypto_kat: SHA-256 of %zu blocks is %s\n",
+          vector->block_count, hex);
+      ++failures;
+    }
+
+    const size_t blocks_per_page = hash_page_size / hash_block_size;
+    if (vector->block_count % blocks_per_page != 0)
+      continue;
+    init_hash(&state);
+    extend_hash_pages(&state, message, vector->block_count / blocks_per_page);
+    finalize_hash(&state);
+    format_digest(hex, (const uint8_t*)&state, hash_result_size);
+    if (strcmp(hex, vector->digest) != 0) {
+      fprintf(stderr, "crypto_kat: SHA-256 of %zu blocks, hashed as pages, "
+          "is %s\n", vector->block_count, hex);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+// Checks count_trailing_zeros() and count_ones() against bit-by-bit loops.
+static int check_bit_counts() {
+  uint64_t x = 0x9E3779B97F4A7C15ULL;
+  for (int i = 0; i < 4096; ++i) {
+    // xorshift64
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    // Sparse words have long runs of trailing zeros.
+    size_t word = (size_t)x;
+    if (i % 2 == 1)
+      word &= ~(size_t)0 << (i % (sizeof(size_t) * 8));
+    if (word == 0)
+      continue;
+
+    size_t trailing_zeros = 0;
+    while (((word >> trailing_zeros) & 1) == 0)
+      ++trailing_zeros;
+    size_t ones = 0;
+    for (size_t bit = 0; bit < sizeof(size_t) * 8; ++bit)
+      ones += (word >> bit) & 1;
+
+    if (count_trailing_zeros(word) != trailing_zeros ||
+        count_ones(word) != ones) {
+      fprintf(stderr, "crypto_kat: bit counts of %016llx are wrong\n",
+          (unsigned long long)word);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 1) {
+    fprintf(stderr, "usage: crypto_kat\n");
+    return 1;
+  }
+
+  int failures = 0;
+  if (AES_KEYLEN == 16 && !check_known_answer()) {
+    fprintf(stderr, "crypto_kat: AES does not match SP 800-38A\n");
+    ++failures;
+  }
+  if (AES_KEYLEN == 16 && !check_gcm_known_answer()) {
+    fprintf(stderr, "crypto_kat: AES-GCM does not match test case 4\n");
+    ++failures;
+  }
+  failures += check_sha256();
+  if (!check_bit_counts())
+    ++failures;
+
+  if (failures != 0) {
+    fprintf(stderr, "crypto_kat: %d failures\n", failures);
+    return 1;
+  }
+  printf("crypto_kat: AES, AES-GCM, SHA-256 and bit counts ok\n");
+  return 0;
+}
@@ -0,0 +1,104 @@
+// Host benchmark for the ed25519 fixed-base table geometry.
+//
+// Reports the cost of ed25519 key generation and signing, which are dominated
+// by ge_scalarmult_base(), with the table selected by ED25519_BASE_WINDOW and
+// ED25519_BASE_SPACING (see tools/ed25519_precomp.py):
+//
+//   ed25519_bench [ROUNDS]
+//
+// Costs are in cycles per operation on hosts with a cycle counter (x86-64 and
+// RISC-V), and in nanoseconds per operation elsewhere. The best of ROUNDS runs
+// is reported.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ed25519/ed25519.h"
+#include "ed25519/ge.h"
+
+#if defined(__x86_64__)
+#define COST_UNIT "cycles"
+static inline uint64_t read_cost_counter() {
+  return __builtin_ia32_rdtsc();
+}
+#elif defined(__riscv)
+#define COST_UNIT "cycles"
+static inline uint64_t read_cost_counter() {
+  uint64_t cycles;
+  asm volatile ("rdcycle %0" : "=r"(cycles));
+  return cycles;
+}
+#else
+#define COST_UNIT "ns"
+static inline uint64_t read_cost_counter() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+#endif
+
+// Operations timed per round.
+#define ops_per_round 64
+
+// The same geometry arithmetic as ge.c.
+#define base_digits ((256 + ED25519_BASE_WINDOW - 1) / ED25519_BASE_WINDOW)
+#define base_rows \
+    ((base_digits + ED25519_BASE_SPACING - 1) / ED25519_BASE_SPACING)
+#define base_points (1 << (ED25519_BASE_WINDOW - 1))
+
+int main(int argc, char** argv) {
+  size_t rounds = (argc > 1) ? strtoull(argv[1], NULL, 0) : 20;
+  if (argc > 2 || rounds == 0) {
+    fprintf(stderr, "usage: ed25519_bench [ROUNDS]\n");
+    return 2;
+  }
+
+  unsigned char seed[32];
+  unsigned char public_key[32];
+  unsigned char private_key[64];
+  unsigned char message[64];
+  unsigned char signature[64];
+  for (size_t i = 0; i < sizeof(seed); ++i)
+    seed[i] = i;
+  for (size_t i = 0; i < sizeof(message); ++i)
+    message[i] = i * 7;
+
+  uint64_t best_keypair = UINT64_MAX;
+  uint64_t best_sign = UINT64_MAX;
+  for (size_t round = 0; round < rounds; ++round) {
+    uint64_t start = read_cost_counter();
+    for (size_t op = 0; op < ops_per_round; ++op) {
+      ed25519_create_keypair(public_key, private_key, seed);
+      seed[0] = public_key[0];
+    }
+    uint64_t cost = read_cost_counter() - start;
+    if (cost < best_keypair)
+      best_keypair = cost;
+
+    start = read_cost_counter();
+    for (size_t op = 0; op < ops_per_round; ++op) {
+      ed25519_sign(signature, message, sizeof(message), public_key,
+          private_key);
+    }
+    cost = read_cost_counter() - start;
+    if (cost < best_sign)
+      best_sign = cost;
+  }
+
+  // The last signature must check out, whatever the table.
+  if (!ed25519_verify(signature, message, sizeof(message), public_key)) {
+    fprintf(stderr, "ed25519_bench: signature does not verify\n");
+    return 1;
+  }
+
+  printf("window %d, spacing %d: %3d x %3d table, %6zu bytes, "
+      "%2d doublings\n", ED25519_BASE_WINDOW, ED25519_BASE_SPACING,
+      base_rows, base_points, base_rows * base_points * sizeof(ge_precomp),
+      ED25519_BASE_WINDOW * (ED25519_BASE_SPACING - 1));
+  printf("  %-22s %10.1f %s/op\n", "ed25519_create_keypair",
+      (double)best_keypair / ops_per_round, COST_UNIT);
+  printf("  %-22s %10.1f %s/op\n", "ed25519_sign",
+      (double)best_sign / ops_per_round, COST_UNIT);
+  return 0;
+}
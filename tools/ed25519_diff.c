@@ -0,0 +1,285 @@
+// Differential test of the 64-bit ed25519 arithmetic against ref10.
+//
+// Built twice, with ED25519_64BIT=0 (fe.c, sc.c) and ED25519_64BIT=1 (fe51.c,
+// sc52.c), which share their symbol names. Each build runs the same
+// pseudo-random and edge-case inputs through every fe_* and sc_* operation,
+// ed25519_create_keypair, ed25519_sign, ed25519_verify and X25519, and writes
+// one line per result:
+//
+//   ed25519_diff_ref10 | ed25519_diff_64 -c
+//
+// With -c, the results are compared with the transcript read from stdin
+// instead; the mismatching lines are printed and the exit status is 1 on any
+// difference.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ed25519/ed25519.h"
+#include "ed25519/fe.h"
+#include "ed25519/sc.h"
+
+#define fe_random_inputs 56
+#define sc_random_inputs 256
+#define key_count 32
+
+// Field elements at the edges of the limb and modulus ranges, as fe_frombytes
+// input, followed by pseudo-random ones.
+static const char* const fe_edge_inputs[] = {
+  "0000000000000000000000000000000000000000000000000000000000000000",
+  "0100000000000000000000000000000000000000000000000000000000000000",
+  "1300000000000000000000000000000000000000000000000000000000000000",
+  "ecffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",  // p - 1
+  "edffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",  // p
+  "eeffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",  // p + 1
+  "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+  "ffffffffffff07000000feffff3f00000000ffffff01000000f0ffff0f000000",
+};
+
+#define fe_edge_count (sizeof(fe_edge_inputs) / sizeof(fe_edge_inputs[0]))
+#define fe_input_count (fe_edge_count + fe_random_inputs)
+
+// Scalars around l, as the low bytes of sc_reduce and sc_muladd input.
+static const char* const sc_edge_inputs[] = {
+  "0000000000000000000000000000000000000000000000000000000000000000",
+  "ecd3f55c1a631258d69cf7a2def9de1400000000000000000000000000000010",  // l - 1
+  "edd3f55c1a631258d69cf7a2def9de1400000000000000000000000000000010",  // l
+  "eed3f55c1a631258d69cf7a2def9de1400000000000000000000000000000010",  // l + 1
+  "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+};
+
+#define sc_edge_count (sizeof(sc_edge_inputs) / sizeof(sc_edge_inputs[0]))
+
+static int compare_mode;
+static size_t result_count;
+static int failures;
+
+static uint64_t prng_state = 0x9E3779B97F4A7C15ULL;
+
+// Fills `bytes` from a xorshift64 generator, the same on every build.
+static void random_bytes(unsigned char* bytes, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    prng_state ^= prng_state << 13;
+    prng_state ^= prng_state >> 7;
+    prng_state ^= prng_state << 17;
+    bytes[i] = (unsigned char)(prng_state >> 32);
+  }
+}
+
+static void parse_hex(unsigned char* bytes, const char* hex) {
+  for (size_t i = 0; hex[2 * i] != '\0'; ++i)
+    sscanf(hex + 2 * i, "%2hhx", &bytes[i]);
+}
+
+// Writes one result line, or checks it against the next line of the
+// reference transcript.
+static void emit(const char* label, size_t index, const unsigned char* bytes,
+    size_t size) {
+  char line[256];
+  int length = snprintf(line, sizeof(line), "%s %zu ", label, index);
+  for (size_t i = 0; i < size; ++i)
+    length += snprintf(line + length, sizeof(line) - length, "%02x", bytes[i]);
+  snprintf(line + length, sizeof(line) - length, "\n");
+  ++result_count;
+
+  if (!compare_mode) {
+    fputs(line, stdout);
+    return;
+  }
+  char reference[256];
+  if (fgets(reference, sizeof(reference), stdin) == NULL) {
+    fprintf(stderr, "ed25519_diff: reference transcript ends before %s",
+        line);
+    ++failures;
+  } else if (strcmp(line, reference) != 0) {
+    fprintf(stderr, "ed25519_diff: expected %s", reference);
+    fprintf(stderr, "ed25519_diff:      got %s", line);
+    ++failures;
+  }
+}
+
+static void emit_fe(const char* label, size_t index, const fe f) {
+  unsigned char bytes[32];
+  fe_tobytes(bytes, f);
+  emit(label, index, bytes, sizeof(bytes));
+}
+
+static void emit_int(const char* label, size_t index, int value) {
+  unsigned char byte = (unsigned char)value;
+  emit(label, index, &byte, 1);
+}
+
+static void check_fe() {
+  static unsigned char inputs[fe_input_count][32];
+  for (size_t i = 0; i < fe_edge_count; ++i)
+    parse_hex(inputs[i], fe_edge_inputs[i]);
+  for (size_t i = fe_edge_count; i < fe_input_count; ++i)
+    random_bytes(inputs[i], 32);
+
+  fe h;
+  fe_0(h);
+  emit_fe("fe_0", 0, h);
+  fe_1(h);
+  emit_fe("fe_1", 0, h);
+
+  for (size_t i = 0; i < fe_input_count; ++i) {
+    fe f;
+    fe_frombytes(f, inputs[i]);
+    emit_fe("fe_frombytes", i, f);
+    fe_copy(h, f);
+    emit_fe("fe_copy", i, h);
+    emit_int("fe_isnegative", i, fe_isnegative(f));
+    emit_int("fe_isnonzero", i, fe_isnonzero(f));
+    fe_neg(h, f);
+    emit_fe("fe_neg", i, h);
+    fe_sq(h, f);
+    emit_fe("fe_sq", i, h);
+    fe_sq2(h, f);
+    emit_fe("fe_sq2", i, h);
+    fe_mul121666(h, f);
+    emit_fe("fe_mul121666", i, h);
+    fe_invert(h, f);
+    emit_fe("fe_invert", i, h);
+    fe_pow22523(h, f);
+    emit_fe("fe_pow22523", i, h);
+  }
+
+  for (size_t i = 0; i < fe_input_count; ++i) {
+    for (size_t j = 0; j < fe_input_count; ++j) {
+      const size_t index = i * fe_input_count + j;
+      fe f, g, sum, difference;
+      fe_frombytes(f, inputs[i]);
+      fe_frombytes(g, inputs[j]);
+
+      fe_add(sum, f, g);
+      emit_fe("fe_add", index, sum);
+      fe_sub(difference, f, g);
+      emit_fe("fe_sub", index, difference);
+      fe_mul(h, f, g);
+      emit_fe("fe_mul", index, h);
+
+      // Unreduced sums and differences feed the other operations in ge.c and
+      // x25519.c.
+      fe_mul(h, sum, difference);
+      emit_fe("fe_mul(add,sub)", index, h);
+      fe_sq(h, sum);
+      emit_fe("fe_sq(add)", index, h);
+      fe_sq2(h, difference);
+      emit_fe("fe_sq2(sub)", index, h);
+      fe_mul121666(h, difference);
+      emit_fe("fe_mul121666(sub)", index, h);
+      fe_neg(h, sum);
+      emit_fe("fe_neg(add)", index, h);
+
+      for (unsigned int b = 0; b <= 1; ++b) {
+        fe_copy(h, f);
+        fe_cmov(h, g, b);
+        emit_fe(b ? "fe_cmov1" : "fe_cmov0", index, h);
+        fe_copy(h, f);
+        fe_copy(sum, g);
+        fe_cswap(h, sum, b);
+        emit_fe(b ? "fe_cswap1.f" : "fe_cswap0.f", index, h);
+        emit_fe(b ? "fe_cswap1.g" : "fe_cswap0.g", index, sum);
+      }
+    }
+  }
+}
+
+static void check_sc() {
+  unsigned char wide[64];
+  for (size_t i = 0; i < sc_edge_count + sc_random_inputs; ++i) {
+    if (i < sc_edge_count) {
+      memset(wide, 0, sizeof(wide));
+      parse_hex(wide, sc_edge_inputs[i]);
+    } else {
+      random_bytes(wide, sizeof(wide));
+    }
+    sc_reduce(wide);
+    emit("sc_reduce", i, wide, 32);
+  }
+  for (size_t i = 0; i < sc_edge_count; ++i) {
+    memset(wide, 0, sizeof(wide));
+    parse_hex(wide + 32, sc_edge_inputs[i]);
+    sc_reduce(wide);
+    emit("sc_reduce(high)", i, wide, 32);
+  }
+
+  for (size_t i = 0; i < sc_edge_count * sc_edge_count * sc_edge_count +
+      sc_random_inputs; ++i) {
+    unsigned char a[32], b[32], c[32], s[32];
+    if (i < sc_edge_count * sc_edge_count * sc_edge_count) {
+      parse_hex(a, sc_edge_inputs[i % sc_edge_count]);
+      parse_hex(b, sc_edge_inputs[i / sc_edge_count % sc_edge_count]);
+      parse_hex(c, sc_edge_inputs[i / sc_edge_count / sc_edge_count]);
+    } else {
+      random_bytes(a, sizeof(a));
+      random_bytes(b, sizeof(b));
+      random_bytes(c, sizeof(c));
+    }
+    sc_muladd(s, a, b, c);
+    emit("sc_muladd", i, s, sizeof(s));
+  }
+}
+
+static void check_signatures() {
+  unsigned char public_keys[key_count][32];
+  unsigned char x25519_keys[key_count][32];
+  for (size_t i = 0; i < key_count; ++i) {
+    unsigned char seed[32];
+    unsigned char private_key[64];
+    unsigned char message[key_count * 7];
+    unsigned char signature[64];
+    const size_t message_len = i * 7;
+    random_bytes(seed, sizeof(seed));
+    random_bytes(message, message_len);
+
+    ed25519_create_keypair(public_keys[i], private_key, seed);
+    emit("ed25519_create_keypair.public", i, public_keys[i], 32);
+    emit("ed25519_create_keypair.private", i, private_key, 64);
+    ed25519_sign(signature, message, message_len, public_keys[i],
+        private_key);
+    emit("ed25519_sign", i, signature, sizeof(signature));
+    emit_int("ed25519_verify", i,
+        ed25519_verify(signature, message, message_len, public_keys[i]));
+    signature[i % sizeof(signature)] ^= 1;
+    emit_int("ed25519_verify(corrupt)", i,
+        ed25519_verify(signature, message, message_len, public_keys[i]));
+
+    x25519_public_key(x25519_keys[i], seed);
+    emit("x25519_public_key", i, x25519_keys[i], 32);
+    if (i == 0)
+      continue;
+    unsigned char shared_secret[32];
+    emit_int("x25519.result", i,
+        x25519(shared_secret, seed, x25519_keys[i - 1]));
+    emit("x25519", i, shared_secret, sizeof(shared_secret));
+  }
+}
+
+int main(int argc, char** argv) {
+  compare_mode = (argc == 2 && strcmp(argv[1], "-c") == 0);
+  if (argc > 2 || (argc == 2 && !compare_mode)) {
+    fprintf(stderr, "usage: ed25519_diff [-c]\n");
+    return 1;
+  }
+
+  check_fe();
+  check_sc();
+  check_signatures();
+
+  if (!compare_mode)
+    return 0;
+  char extra[256];
+  if (fgets(extra, sizeof(extra), stdin) != NULL) {
+    fprintf(stderr, "ed25519_diff: reference transcript has more results\n");
+    ++failures;
+  }
+  if (failures != 0) {
+    fprintf(stderr, "ed25519_diff: %d of %zu results differ from ref10\n",
+        failures, result_count);
+    return 1;
+  }
+  printf("ed25519_diff: %zu fe, sc, ed25519 and X25519 results match ref10\n",
+      result_count);
+  return 0;
+}
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+# Generates the ed25519 precomputed tables (common/ed25519/precomp_data.h).
+#
+#   ed25519_precomp.py WINDOW SPACING > precomp_data.h
+#
+# ge_scalarmult_base() writes the scalar as signed digits of WINDOW bits, and
+# adds digit i from row i / SPACING of the base table:
+#
+#   base[row][j] = (j + 1) * 2^(WINDOW * SPACING * row) * B
+#
+# The table has 2^(WINDOW - 1) points per row, for ceil(ceil(256 / WINDOW) /
+# SPACING) rows, and every point takes 120 bytes. Each scalar multiplication
+# costs one table addition per digit, plus WINDOW * (SPACING - 1) doublings.
+# So larger windows and smaller spacings trade table size for speed. 4 2 is
+# the ref10 table.
+#
+# Both field representations (ED25519_64BIT or not) are emitted, along with
+# the Bi table used by ge_double_scalarmult_vartime().
+from __future__ import print_function
+import sys
+
+P = 2**255 - 19
+
+def eprint(*args, **kwargs):
+  print(*args, file=sys.stderr, **kwargs)
+
+def inv(x):
+  return pow(x, P - 2, P)
+
+D = -121665 * inv(121666) % P
+
+def recover_x(y):
+  x2 = (y * y - 1) * inv(D * y * y + 1) % P
+  x = pow(x2, (P + 3) // 8, P)
+  if (x * x - x2) % P != 0:
+    x = x * pow(2, (P - 1) // 4, P) % P
+  if x & 1:
+    x = P - x
+  return x
+
+def add(a, b):
+  x1, y1 = a
+  x2, y2 = b
+  t = D * x1 * x2 * y1 * y2 % P
+  return ((x1 * y2 + x2 * y1) * inv(1 + t) % P,
+          (y1 * y2 + x1 * x2) * inv(1 - t) % P)
+
+BASE_Y = 4 * inv(5) % P
+BASE = (recover_x(BASE_Y), BASE_Y)
+
+# ge_precomp is (y + x, y - x, 2 d x y).
+def precomp(point):
+  x, y = point
+  return [(y + x) % P, (y - x) % P, 2 * D * x * y % P]
+
+# The 32-bit representation of fe.c: ten limbs of alternately 26 and 25 bits,
+# carried into signed limbs the way fe_frombytes() does it.
+def limbs_fe32(v):
+  bits = [26 if i % 2 == 0 else 25 for i in range(10)]
+  h = []
+  shift = 0
+  for b in bits:
+    h.append((v >> shift) & ((1 << b) - 1))
+    shift += b
+  for i in [9, 1, 3, 5, 7, 0, 2, 4, 6, 8]:
+    carry = (h[i] + (1 << (bits[i] - 1))) >> bits[i]
+    h[i] -= carry << bits[i]
+    if i == 9:
+      h[0] += carry * 19
+    else:
+      h[i + 1] += carry
+  return ', '.join(str(limb) for limb in h)
+
+# The 64-bit representation of fe51.c: five 51-bit limbs.
+def limbs_fe51(v):
+  return ', '.join('0x%013x' % ((v >> (51 * i)) & (2**51 - 1))
+                   for i in range(5))
+
+def emit_points(points, limbs, indent):
+  for point in points:
+    print(indent + '{')
+    for v in precomp(point):
+      print(indent + '    { ' + limbs(v) + ' },')
+    print(indent + '},')
+
+def emit_tables(bi, base, window, spacing, limbs):
+  print('static const ge_precomp Bi[%d] = {' % len(bi))
+  emit_points(bi, limbs, '    ')
+  print('};')
+  print('')
+  print('')
+  print('/* base[i][j] = (j+1)*2^(%d*i)*B */' % (window * spacing))
+  print('static const ge_precomp base[%d][%d] = {' % (len(base), len(base[0])))
+  for row in base:
+    print('    {')
+    emit_points(row, limbs, '        ')
+    print('    },')
+  print('};')
+
+def main():
+  if len(sys.argv) != 3:
+    eprint("usage: ed25519_precomp.py WINDOW SPACING")
+    exit(1)
+  window = int(sys.argv[1])
+  spacing = int(sys.argv[2])
+  # Signed digits must fit in a signed char.
+  if not 2 <= window <= 7 or spacing < 1:
+    eprint("ed25519_precomp.py: need 2 <= WINDOW <= 7 and SPACING >= 1")
+    exit(1)
+
+  digits = (256 + window - 1) // window
+  rows = (digits + spacing - 1) // spacing
+
+  # Bi[i] = (2i+1)*B
+  bi = [BASE]
+  double_base = add(BASE, BASE)
+  for i in range(7):
+    bi.append(add(bi[-1], double_base))
+
+  base = []
+  row_base = BASE
+  for row in range(rows):
+    points = [row_base]
+    for j in range(2**(window - 1) - 1):
+      points.append(add(points[-1], row_base))
+    base.append(points)
+    for i in range(window * spacing):
+      row_base = add(row_base, row_base)
+
+  print('/*')
+  print('    Generated by tools/ed25519_precomp.py %d %d; do not edit.' %
+        (window, spacing))
+  print('*/')
+  print('')
+  print('#define ED25519_BASE_WINDOW %d' % window)
+  print('#define ED25519_BASE_SPACING %d' % spacing)
+  print('')
+  print('#if ED25519_64BIT')
+  print('')
+  emit_tables(bi, base, window, spacing, limbs_fe51)
+  print('')
+  print('#else')
+  print('')
+  emit_tables(bi, base, window, spacing, limbs_fe32)
+  print('')
+  print('#endif')
+
+main()
@@ -0,0 +1,394 @@
+// Host test for the ed25519 code in common/ed25519.
+//
+// The signatures in this tree hash with SHA3-512 instead of SHA-512, so the
+// RFC 8032 test vectors are checked below the hash: each vector carries the
+// SHA-512 outputs that RFC 8032 signing computes, and the test derives the
+// public key, R, S and the verification equation from them with the same
+// scalar and group operations that keypair.c, sign.c and verify.c use.
+//
+// ed25519_verify_batch() is checked against ed25519_verify() on random batches
+// of valid and corrupted signatures, with scratch space for whole batches and
+// for fewer signatures than the batch holds.
+//
+// X25519 is checked against the RFC 7748 vectors: the two in section 5.2, the
+// iterated one to 1000 iterations, and the key agreement in section 6.1:
+//
+//   ed25519_test
+//
+// Build it with ED25519_64BIT=0 and 1 to cover both backends. Prints the
+// failing cases and exits with status 1 on any mismatch.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ed25519/ed25519.h"
+#include "ed25519/ge.h"
+#include "ed25519/sc.h"
+
+typedef struct {
+  const char* public_key;
+  const char* signature;
+  // SHA-512(secret key)[0..31], before clamping.
+  const char* expanded_key;
+  // SHA-512(SHA-512(secret key)[32..63] || message)
+  const char* nonce_hash;
+  // SHA-512(R || public key || message)
+  const char* challenge_hash;
+} rfc8032_vector_t;
+
+// RFC 8032 section 7.1, TEST 1 to TEST 3, whose messages are "", 72 and af82.
+static const rfc8032_vector_t rfc8032_vectors[] = {
+  {
+    "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a",
+    "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e06522490155"
+    "5fb8821590a33bacc61e39701cf9b46bd25bf5f0595bbe24655141438e7a100b",
+    "357c83864f2833cb427a2ef1c00a013cfdff2768d980c0a3a520f006904de90f",
+    "b6b19cd8e0426f5983fa112d89a143aa97dab8bc5deb8d5b6253c928b65272f4"
+    "044098c2a990039cde5b6a4818df0bfb6e40dc5dee54248032962323e701352d",
+    "2771062b6b536fe7ffbdda0320c3827b035df10d284df3f08222f04dbca7a4c2"
+    "0ef15bdc988a22c7207411377c33f2ac09b1e86a046234283768ee7ba03c0e9f",
+  },
+  {
+    "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c",
+    "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da"
+    "085ac1e43e15996e458f3613d0f11d8c387b2eaeb4302aeeb00d291612bb0c00",
+    "6ebd9ed75882d52815a97585caf4790a7f6c6b3b7f821c5e259a24b02e502e11",
+    "d3ed2599eb78018fb16df36634c8cc5c5925536d258f8d676a750a5f62bf0ce3"
+    "96d4e16dc701d63e8b001bcb902f27b75bca8583c34deaf31a373cdf12d0714f",
+    "a271df0d2b0d03bd17b4ed9a4b6afddf2e73287fd630f1a137d87ce873a591cc"
+    "31b6dd852a98b5dd1226fe993d8228278ceba21f80b8fc95986a70d71edf3faf",
+  },
+  {
+    "fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025",
+    "6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac"
+    "18ff9b538d16f290ae67f760984dc6594a7c15e9716ed28dc027beceea1ec40a",
+    "909a8b755ed902849023a55b15c23d11ba4d7f4ec5c2f51b1325a181991ea99c",
+    "1a50bed315e61db803801f0538c952d222c279aebb1ada611ff09660781def63"
+    "73ac7025635d44ad7135f39fd5b8bc3538373789af87c8cb02e3c7400e2393a4",
+    "09bfb4ff1993f38f2ef65699934a8b64c0325867f858059b95bca199f78dc09e"
+    "544857aeb4abddc6e35660da2867ab5963135ffef60d242dbfce0a85fbc362bf",
+  },
+};
+
+typedef struct {
+  const char* scalar;
+  const char* u;
+  const char* result;
+} x25519_vector_t;
+
+// RFC 7748 section 5.2.
+static const x25519_vector_t x25519_vectors[] = {
+  {
+    "a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4",
+    "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c",
+    "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552",
+  },
+  {
+    "4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d",
+    "e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493",
+    "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957",
+  },
+};
+
+// RFC 7748 section 5.2: starting from k = u = 9, each iteration sets k to
+// X25519(k, u) and u to the old k. These are k after 1 and 1000 iterations.
+static const char* const x25519_iterated_1 =
+    "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079";
+static const char* const x25519_iterated_1000 =
+    "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51";
+
+// RFC 7748 section 6.1: Alice's and Bob's keys, and their shared secret.
+static const char* const x25519_dh_keys[2][2] = {
+  { "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a",
+    "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a" },
+  { "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb",
+    "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f" },
+};
+static const char* const x25519_dh_shared =
+    "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742";
+
+#define batch_rounds 200
+#define batch_max_count 16
+#define batch_message_size 48
+
+// The group order l, little-endian.
+static const unsigned char group_order[32] = {
+  0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+  0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+};
+
+static uint64_t prng_state = 0x9E3779B97F4A7C15ULL;
+
+// A xorshift64 generator; the batches are the same on every run.
+static uint64_t random_word() {
+  prng_state ^= prng_state << 13;
+  prng_state ^= prng_state >> 7;
+  prng_state ^= prng_state << 17;
+  return prng_state;
+}
+
+static void random_bytes(unsigned char* bytes, size_t size) {
+  for (size_t i = 0; i < size; ++i)
+    bytes[i] = (unsigned char)(random_word() >> 32);
+}
+
+static void parse_hex(unsigned char* bytes, const char* hex) {
+  for (size_t i = 0; hex[2 * i] != '\0'; ++i)
+    sscanf(hex + 2 * i, "%2hhx", &bytes[i]);
+}
+
+// Checks an RFC 8032 vector. Returns the number of failures.
+static int check_rfc8032_vector(const rfc8032_vector_t* vector, size_t index) {
+  unsigned char public_key[32], signature[64];
+  unsigned char scalar[32], nonce[64], challenge[64];
+  parse_hex(public_key, vector->public_key);
+  parse_hex(signature, vector->signature);
+  parse_hex(scalar, vector->expanded_key);
+  parse_hex(nonce, vector->nonce_hash);
+  parse_hex(challenge, vector->challenge_hash);
+  int failures = 0;
+
+  // ed25519_create_keypair
+  unsigned char encoded[32];
+  ge_p3 point;
+  scalar[0] &= 248;
+  scalar[31] &= 63;
+  scalar[31] |= 64;
+  ge_scalarmult_base(&point, scalar);
+  ge_p3_tobytes(encoded, &point);
+  if (memcmp(encoded, public_key, 32) != 0) {
+    fprintf(stderr, "ed25519_test: RFC 8032 TEST %zu public key is wrong\n",
+        index + 1);
+    ++failures;
+  }
+
+  // ed25519_sign
+  unsigned char s[32];
+  sc_reduce(nonce);
+  ge_scalarmult_base(&point, nonce);
+  ge_p3_tobytes(encoded, &point);
+  sc_reduce(challenge);
+  sc_muladd(s, challenge, scalar, nonce);
+  if (memcmp(encoded, signature, 32) != 0 ||
+      memcmp(s, signature + 32, 32) != 0) {
+    fprintf(stderr, "ed25519_test: RFC 8032 TEST %zu signature is wrong\n",
+        index + 1);
+    ++failures;
+  }
+
+  // ed25519_verify: [S]B - [k]A must be R.
+  ge_p2 check;
+  if (ge_frombytes_negate_vartime(&point, public_key) != 0) {
+    fprintf(stderr, "ed25519_test: RFC 8032 TEST %zu public key does not "
+        "decode\n", index + 1);
+    return failures + 1;
+  }
+  ge_double_scalarmult_vartime(&check, challenge, &point, signature + 32);
+  ge_tobytes(encoded, &check);
+  if (memcmp(encoded, signature, 32) != 0) {
+    fprintf(stderr, "ed25519_test: RFC 8032 TEST %zu does not verify\n",
+        index + 1);
+    ++failures;
+  }
+  return failures;
+}
+
+// Checks X25519 against RFC 7748. Returns the number of failures.
+static int check_x25519() {
+  unsigned char scalar[32], u[32], expected[32], result[32];
+  int failures = 0;
+
+  const size_t vector_count =
+      sizeof(x25519_vectors) / sizeof(x25519_vectors[0]);
+  for (size_t i = 0; i < vector_count; ++i) {
+    parse_hex(scalar, x25519_vectors[i].scalar);
+    parse_hex(u, x25519_vectors[i].u);
+    parse_hex(expected, x25519_vectors[i].result);
+    if (!x25519(result, scalar, u) || memcmp(result, expected, 32) != 0) {
+      fprintf(stderr, "ed25519_test: RFC 7748 X25519 vector %zu is wrong\n",
+          i + 1);
+      ++failures;
+    }
+  }
+
+  memset(scalar, 0, sizeof(scalar));
+  scalar[0] = 9;
+  memcpy(u, scalar, sizeof(u));
+  for (int iteration = 1; iteration <= 1000; ++iteration) {
+    x25519(result, scalar, u);
+    memcpy(u, scalar, sizeof(u));
+    memcpy(scalar, result, sizeof(scalar));
+    if (iteration != 1 && iteration != 1000)
+      continue;
+    parse_hex(expected,
+        (iteration == 1) ? x25519_iterated_1 : x25519_iterated_1000);
+    if (memcmp(result, expected, 32) != 0) {
+      fprintf(stderr, "ed25519_test: RFC 7748 X25519 after %d iterations is "
+          "wrong\n", iteration);
+      ++failures;
+    }
+  }
+
+  unsigned char private_keys[2][32], public_keys[2][32];
+  for (int party = 0; party < 2; ++party) {
+    parse_hex(private_keys[party], x25519_dh_keys[party][0]);
+    parse_hex(expected, x25519_dh_keys[party][1]);
+    x25519_public_key(public_keys[party], private_keys[party]);
+    if (memcmp(public_keys[party], expected, 32) != 0) {
+      fprintf(stderr, "ed25519_test: RFC 7748 X25519 public key %d is "
+          "wrong\n", party + 1);
+      ++failures;
+    }
+  }
+  parse_hex(expected, x25519_dh_shared);
+  for (int party = 0; party < 2; ++party) {
+    if (!x25519(result, private_keys[party], public_keys[1 - party]) ||
+        memcmp(result, expected, 32) != 0) {
+      fprintf(stderr, "ed25519_test: RFC 7748 X25519 shared secret %d is "
+          "wrong\n", party + 1);
+      ++failures;
+    }
+  }
+
+  // u = 0 has order 1, and must be rejected.
+  memset(u, 0, sizeof(u));
+  if (x25519(result, private_keys[0], u)) {
+    fprintf(stderr, "ed25519_test: X25519 accepts the all-zero secret\n");
+    ++failures;
+  }
+  return failures;
+}
+
+// Adds l to a canonical scalar, which keeps its value mod l.
+static void add_group_order(unsigned char* s) {
+  unsigned int carry = 0;
+  for (size_t i = 0; i < 32; ++i) {
+    carry += s[i] + group_order[i];
+    s[i] = (unsigned char)carry;
+    carry >>= 8;
+  }
+}
+
+typedef enum {
+  corrupt_none,
+  corrupt_r,
+  corrupt_s,
+  corrupt_message,
+  corrupt_key,
+  corrupt_noncanonical_s,
+  corrupt_kinds,
+} corruption_t;
+
+// Checks ed25519_verify_batch() against ed25519_verify() on random batches.
+// Returns the number of failures.
+static int check_batches() {
+  static unsigned char public_keys[batch_max_count][32];
+  static unsigned char private_keys[batch_max_count][64];
+  static unsigned char messages[batch_max_count][batch_message_size];
+  static unsigned char signatures[batch_max_count][64];
+  static uint64_t scratch[batch_max_count * ED25519_BATCH_SCRATCH_BYTES /
+      sizeof(uint64_t)];
+
+  for (size_t i = 0; i < batch_max_count; ++i) {
+    unsigned char seed[32];
+    random_bytes(seed, sizeof(seed));
+    ed25519_create_keypair(public_keys[i], private_keys[i], seed);
+  }
+
+  int failures = 0;
+  for (size_t round = 0; round < batch_rounds; ++round) {
+    const unsigned char* signature_ptrs[batch_max_count];
+    const unsigned char* message_ptrs[batch_max_count];
+    const unsigned char* key_ptrs[batch_max_count];
+    size_t message_lens[batch_max_count];
+    int valid[batch_max_count];
+
+    size_t count = 1 + random_word() % batch_max_count;
+    for (size_t i = 0; i < count; ++i) {
+      size_t signer = random_word() % batch_max_count;
+      message_lens[i] = random_word() % (batch_message_size + 1);
+      random_bytes(messages[i], message_lens[i]);
+      ed25519_sign(signatures[i], messages[i], message_lens[i],
+          public_keys[signer], private_keys[signer]);
+      signature_ptrs[i] = signatures[i];
+      message_ptrs[i] = messages[i];
+      key_ptrs[i] = public_keys[signer];
+
+      // Most rounds corrupt a few signatures; some leave the batch valid.
+      corruption_t corruption = (round % 4 == 0) ?
+          corrupt_none : (corruption_t)(random_word() % corrupt_kinds);
+      size_t bit = random_word() % 256;
+      switch (corruption) {
+        case corrupt_r:
+          signatures[i][bit / 8] ^= 1 << (bit % 8);
+          break;
+        case corrupt_s:
+          signatures[i][32 + bit / 8 % 31] ^= 1 << (bit % 8);
+          break;
+        case corrupt_message:
+          if (message_lens[i] != 0)
+            messages[i][bit / 8 % message_lens[i]] ^= 1 << (bit % 8);
+          break;
+        case corrupt_key:
+          key_ptrs[i] = public_keys[(signer + 1) % batch_max_count];
+          break;
+        case corrupt_noncanonical_s:
+          add_group_order(signatures[i] + 32);
+          break;
+        default:
+          break;
+      }
+    }
+
+    // Room for the whole batch, for part of it, or for a single signature.
+    size_t scratch_count = (round % 3 == 0) ? count :
+        (round % 3 == 1) ? 1 + random_word() % count : 1;
+    int all_valid = ed25519_verify_batch(signature_ptrs, message_ptrs,
+        message_lens, key_ptrs, count, valid, scratch,
+        scratch_count * ED25519_BATCH_SCRATCH_BYTES);
+
+    int expected_all_valid = 1;
+    for (size_t i = 0; i < count; ++i) {
+      int expected = ed25519_verify(signature_ptrs[i], message_ptrs[i],
+          message_lens[i], key_ptrs[i]);
+      expected_all_valid &= expected;
+      if (valid[i] != expected) {
+        fprintf(stderr, "ed25519_test: batch %zu, signature %zu of %zu: "
+            "batch says %d, ed25519_verify says %d\n", round, i, count,
+            valid[i], expected);
+        ++failures;
+      }
+    }
+    if (all_valid != expected_all_valid) {
+      fprintf(stderr, "ed25519_test: batch %zu returns %d\n", round,
+          all_valid);
+      ++failures;
+    }
+  }
+  return failures;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 1) {
+    fprintf(stderr, "usage: ed25519_test\n");
+    return 1;
+  }
+
+  int failures = 0;
+  const size_t vector_count =
+      sizeof(rfc8032_vectors) / sizeof(rfc8032_vectors[0]);
+  for (size_t i = 0; i < vector_count; ++i)
+    failures += check_rfc8032_vector(&rfc8032_vectors[i], i);
+  failures += check_batches();
+  failures += check_x25519();
+
+  if (failures != 0) {
+    fprintf(stderr, "ed25519_test: %d failures\n", failures);
+    return 1;
+  }
+  printf("ed25519_test: %zu RFC 8032 vectors, %d batches and RFC 7748 X25519 "
+      "ok (ED25519_64BIT=%d)\n", vector_count, batch_rounds, ED25519_64BIT);
+  return 0;
+}
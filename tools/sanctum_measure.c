@@ -0,0 +1,468 @@
+// Offline measurement tool.
+//
+// Reproduces, on a Linux host, the measurements computed on the device:
+//
+//   sanctum_measure bootloader [-s SIZE] FILE
+//     The ROT's expected bootloader hash over FILE (bootloader.bin): the
+//     loaded bytes listed in the manifest embedded in FILE. The manifest must
+//     fit in SIZE bytes (BOOTLOADER_SIZE by default).
+//
+//   sanctum_measure sm [-m MODE] [-l LEAF_SIZE] [-M MANIFEST] FILE
+//     The SM_H computed by the bootloader over FILE (sm.bin), using the
+//     configured SM_MEASUREMENT_MODE and SM_MEASUREMENT_LEAF_SIZE by default.
+//     MANIFEST is the SM's segment manifest (sm_manifest.bin); without it,
+//     FILE is measured as a single loaded segment.
+//
+//   sanctum_measure enclave LAYOUT...
+//     The measurement the monitor computes for an enclave loaded as described
+//     by each LAYOUT file. The hashing is done by sm/monitor/measure_inl.h and
+//     sm/crypto, exactly as in the monitor.
+//
+// A LAYOUT file lists the monitor calls the OS makes to load the enclave, one
+// per line, in order. '#' starts a comment. Numbers use C syntax (0x...), and
+// FILE paths are relative to the LAYOUT file.
+//
+//   create_enclave  EV_BASE EV_MASK MAILBOX_COUNT DEBUG
+//   load_page_table VIRTUAL_ADDR LEVEL ACL
+//   load_page       VIRTUAL_ADDR ACL FILE [OFFSET]
+//   load_pages      VIRTUAL_ADDR ACL FILE [OFFSET [LENGTH]]
+//   load_thread     ENTRY_PC ENTRY_STACK FAULT_PC FAULT_STACK
+//
+// load_page hashes one page read from FILE at OFFSET; load_pages is shorthand
+// for consecutive load_page calls covering LENGTH bytes (the rest of the file
+// by default). Reads past the end of FILE yield zeroes. init_enclave is
+// implied at the end of the file.
+//
+// When several LAYOUT files are given, each one only replays the lines that
+// follow the prefix it shares with the previous one; the measurement of the
+// shared prefix is restored from a checkpoint.
+//
+// The measurement structures use size_t and uintptr_t, so the tool must run on
+// a 64-bit little-endian host to match an RV64 monitor.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sanctum_config.h"
+#include "sha3/sha3.h"
+#include "sm_measurement.h"
+
+// arch/memory.h has its own bzero() and bcopy(), which clash with the host's
+// <strings.h> declarations.
+#define bzero monitor_bzero
+#define bcopy monitor_bcopy
+#include <arch/memory.h>
+#include <monitor/measure_inl.h>
+#undef bzero
+#undef bcopy
+
+_Static_assert(sizeof(size_t) == 8 && sizeof(uintptr_t) == 8,
+    "the enclave measurement layout assumes a 64-bit host");
+
+#define MAX_MAPPED_FILES 64
+#define MAX_LINE 4096
+
+// A read-only mapping of an input file.
+typedef struct {
+  char* path;
+  const uint8_t* data;
+  size_t size;
+} mapped_file_t;
+
+static mapped_file_t g_files[MAX_MAPPED_FILES];
+static size_t g_file_count;
+
+static void die(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "sanctum_measure: ");
+  vfprintf(stderr, fmt, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+  exit(1);
+}
+
+static void usage() {
+  fprintf(stderr,
+      "usage: sanctum_measure bootloader [-s SIZE] FILE\n"
+      "       sanctum_measure sm [-m MODE] [-l LEAF_SIZE] [-M MANIFEST] FILE\n"
+      "       sanctum_measure enclave LAYOUT...\n");
+  exit(2);
+}
+
+static void print_hex(const uint8_t* bytes, size_t len, const char* label) {
+  for (size_t i = 0; i < len; ++i)
+    printf("%02x", bytes[i]);
+  if (label)
+    printf("  %s", label);
+  printf("\n");
+}
+
+static uint64_t parse_number(const char* s) {
+  char* end;
+  errno = 0;
+  uint64_t value = strtoull(s, &end, 0);
+  if (errno != 0 || end == s || *end != '\0')
+    die("invalid number: %s", s);
+  return value;
+}
+
+// Maps a file, reusing earlier mappings of the same path.
+static const mapped_file_t* map_file(const char* path) {
+  for (size_t i = 0; i < g_file_count; ++i) {
+    if (strcmp(g_files[i].path, path) == 0)
+      return &g_files[i];
+  }
+  if (g_file_count == MAX_MAPPED_FILES)
+    die("too many input files, at %s", path);
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    die("cannot open %s", path);
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    die("cannot stat %s", path);
+
+  mapped_file_t* file = &g_files[g_file_count];
+  file->size = st.st_size;
+  file->data = NULL;
+  if (file->size != 0) {
+    file->data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (file->data == MAP_FAILED)
+      die("cannot map %s", path);
+    madvise((void*)file->data, file->size, MADV_SEQUENTIAL);
+  }
+  close(fd);
+  file->path = strdup(path);
+  g_file_count += 1;
+  return file;
+}
+
+static void unmap_files() {
+  for (size_t i = 0; i < g_file_count; ++i) {
+    if (g_files[i].size != 0)
+      munmap((void*)g_files[i].data, g_files[i].size);
+    free(g_files[i].path);
+  }
+  g_file_count = 0;
+}
+
+// Returns a pointer to `len` bytes of a file at `offset`, zero-extended.
+//
+// The bytes are read in place when they are all inside the file, and copied
+// into `scratch` otherwise.
+static const uint8_t* file_bytes(const mapped_file_t* file, uint64_t offset,
+    size_t len, uint8_t* scratch) {
+  if (offset <= file->size && file->size - offset >= len)
+    return file->data + offset;
+
+  size_t available = (offset < file->size) ? file->size - offset : 0;
+  if (available != 0)
+    memcpy(scratch, file->data + offset, available);
+  memset(scratch + available, 0, len - available);
+  return scratch;
+}
+
+static int measure_bootloader(int argc, char** argv) {
+  uint64_t size = BOOTLOADER_SIZE;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:")) != -1) {
+    if (opt == 's')
+      size = parse_number(optarg);
+    else
+      usage();
+  }
+  if (optind + 1 != argc)
+    usage();
+
+  const mapped_file_t* file = map_file(argv[optind]);
+  bootloader_manifest_t manifest;
+  if (file->size < BOOTLOADER_MANIFEST_OFFSET + sizeof(manifest))
+    die("%s is too small to hold a manifest", argv[optind]);
+  memcpy(&manifest, file->data + BOOTLOADER_MANIFEST_OFFSET, sizeof(manifest));
+
+  // Same checks as rot_hash_and_verify().
+  if (manifest.loaded_size < BOOTLOADER_MANIFEST_OFFSET + sizeof(manifest) ||
+      manifest.loaded_size > size ||
+      manifest.zero_size > size - manifest.loaded_size)
+    die("%s has an invalid manifest", argv[optind]);
+  if (manifest.loaded_size > file->size)
+    die("%s is shorter than its manifest says", argv[optind]);
+
+  uint8_t hash[64];
+  sha3(file->data, manifest.loaded_size, hash, 64);
+  print_hex(hash, sizeof(hash), NULL);
+  return 0;
+}
+
+static int measure_sm(int argc, char** argv) {
+  uint64_t mode = SM_MEASUREMENT_MODE;
+  uint64_t leaf_size = SM_MEASUREMENT_LEAF_SIZE;
+  const char* manifest_path = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "m:l:M:")) != -1) {
+    if (opt == 'm')
+      mode = parse_number(optarg);
+    else if (opt == 'l')
+      leaf_size = parse_number(optarg);
+    else if (opt == 'M')
+      manifest_path = optarg;
+    else
+      usage();
+  }
+  if (optind + 1 != argc)
+    usage();
+
+  // The bootloader reads the manifest from memory, where it is zero-extended
+  // to its full size.
+  sm_manifest_t manifest;
+  memset(&manifest, 0, sizeof(manifest));
+  if (manifest_path) {
+    const mapped_file_t* manifest_file = map_file(manifest_path);
+    size_t manifest_size = (manifest_file->size < sizeof(manifest)) ?
+        manifest_file->size : sizeof(manifest);
+    if (manifest_size != 0)
+      memcpy(&manifest, manifest_file->data, manifest_size);
+  }
+
+  const mapped_file_t* file = map_file(argv[optind]);
+  sm_manifest_t measured;
+  sm_measured_manifest(&measured, &manifest, file->size);
+  if (manifest_path && !sm_manifest_is_valid(&manifest, file->size)) {
+    fprintf(stderr, "sanctum_measure: warning: %s does not match %s, "
+        "measuring the whole image\n", manifest_path, argv[optind]);
+  }
+
+  uint8_t hash[64];
+  if (mode == SM_MEASUREMENT_SERIAL) {
+    sm_serial_hash(hash, file->data, &measured);
+  } else if (mode == SM_MEASUREMENT_TREE) {
+    if (leaf_size == 0)
+      die("invalid leaf size: 0");
+    uint64_t leaf_count = sm_tree_leaf_count(
+        sm_manifest_loaded_size(&measured), leaf_size);
+    uint8_t* leaf_hashes = malloc(leaf_count * 64 + 1);
+    if (!leaf_hashes)
+      die("out of memory");
+    for (uint64_t leaf = 0; leaf < leaf_count; ++leaf) {
+      sm_tree_hash_leaf(file->data, &measured, leaf_size, leaf,
+          leaf_hashes + leaf * 64);
+    }
+    sm_tree_root(hash, mode, &measured, leaf_size, leaf_hashes);
+    free(leaf_hashes);
+  } else {
+    die("unknown measurement mode: %" PRIu64, mode);
+  }
+  print_hex(hash, sizeof(hash), NULL);
+  return 0;
+}
+
+// Splits a line into whitespace-separated words, dropping comments.
+static size_t split_words(char* line, char** words, size_t max_words) {
+  char* comment = strchr(line, '#');
+  if (comment)
+    *comment = '\0';
+
+  size_t count = 0;
+  for (char* word = strtok(line, " \t\r\n"); word != NULL;
+       word = strtok(NULL, " \t\r\n")) {
+    if (count == max_words)
+      return max_words + 1;
+    words[count++] = word;
+  }
+  return count;
+}
+
+// Resolves a path named in a layout file relative to the layout's directory.
+static void resolve_path(char* out, size_t out_size, const char* layout_path,
+    const char* path) {
+  const char* slash = strrchr(layout_path, '/');
+  if (path[0] == '/' || slash == NULL) {
+    snprintf(out, out_size, "%s", path);
+  } else {
+    snprintf(out, out_size, "%.*s/%s", (int)(slash - layout_path),
+        layout_path, path);
+  }
+}
+
+// A line of the previous layout, and the measurement after replaying it.
+//
+// Layouts that start with the same lines (e.g. instances of one enclave that
+// only differ in their last pages) share a measurement prefix, so each layout
+// only replays the lines after the prefix it shares with the previous one.
+typedef struct {
+  char* key;  // The line's words, with FILE resolved.
+  enclave_hash_checkpoint_t checkpoint;
+} layout_step_t;
+
+static layout_step_t* g_steps;
+static size_t g_step_count;
+static size_t g_step_capacity;
+
+static void truncate_steps(size_t count) {
+  for (size_t i = count; i < g_step_count; ++i)
+    free(g_steps[i].key);
+  if (count < g_step_count)
+    g_step_count = count;
+}
+
+static void append_step(const char* key, enclave_info_t* enclave_info) {
+  if (g_step_count == g_step_capacity) {
+    g_step_capacity = g_step_capacity ? 2 * g_step_capacity : 64;
+    g_steps = realloc(g_steps, g_step_capacity * sizeof(layout_step_t));
+    if (!g_steps)
+      die("out of memory");
+  }
+  layout_step_t* step = &g_steps[g_step_count++];
+  step->key = strdup(key);
+  save_enclave_hash_checkpoint(enclave_info, &step->checkpoint);
+}
+
+// Replays one layout file through the monitor's measurement code.
+static void measure_enclave_layout(const char* layout_path, uint8_t* hash) {
+  static enclave_info_t enclave_info;
+  static uint8_t scratch_page[4096];
+
+  FILE* layout = fopen(layout_path, "r");
+  if (!layout)
+    die("cannot open %s", layout_path);
+
+  bool created = false;
+  char line[MAX_LINE];
+  char path[MAX_LINE];
+  char key[2 * MAX_LINE];
+  char* w[8];
+  size_t line_number = 0;
+  // Number of steps at the start of this layout that match the previous one.
+  size_t step = 0;
+  bool matching = true;
+  while (fgets(line, sizeof(line), layout)) {
+    line_number += 1;
+    size_t n = split_words(line, w, 7);
+    if (n == 0)
+      continue;
+
+    bool has_file = n >= 4 && (strcmp(w[0], "load_page") == 0 ||
+        strcmp(w[0], "load_pages") == 0);
+    if (has_file) {
+      resolve_path(path, sizeof(path), layout_path, w[3]);
+      w[3] = path;
+    }
+    size_t key_length = 0;
+    for (size_t i = 0; i < n; ++i) {
+      key_length += snprintf(key + key_length, sizeof(key) - key_length,
+          "%s%s", (i == 0) ? "" : " ", w[i]);
+      if (key_length >= sizeof(key))
+        die("line too long in %s", layout_path);
+    }
+
+    // create_enclave is always replayed, as it sets up the hash.
+    if (matching && created && step < g_step_count &&
+        strcmp(g_steps[step].key, key) == 0) {
+      step += 1;
+      continue;
+    }
+    if (matching && created) {
+      restore_enclave_hash_checkpoint(&enclave_info,
+          &g_steps[step - 1].checkpoint);
+      truncate_steps(step);
+      matching = false;
+    }
+
+    if (strcmp(w[0], "create_enclave") == 0 && n == 5) {
+      if (created)
+        die("%s: create_enclave must come first, and only once", layout_path);
+      init_enclave_hash(&enclave_info, parse_number(w[1]),
+          parse_number(w[2]), parse_number(w[3]), parse_number(w[4]) != 0);
+      created = true;
+      if (step < g_step_count && strcmp(g_steps[step].key, key) == 0) {
+        step += 1;
+        continue;
+      }
+      truncate_steps(0);
+      matching = false;
+      append_step(key, &enclave_info);
+      continue;
+    }
+    if (!created)
+      die("%s: create_enclave must come first", layout_path);
+
+    if (strcmp(w[0], "load_page_table") == 0 && n == 4) {
+      extend_enclave_hash_with_page_table(&enclave_info, parse_number(w[1]),
+          parse_number(w[2]), parse_number(w[3]));
+    } else if ((strcmp(w[0], "load_page") == 0 && (n == 4 || n == 5)) ||
+        (strcmp(w[0], "load_pages") == 0 && n >= 4 && n <= 6)) {
+      uintptr_t virtual_addr = parse_number(w[1]);
+      uintptr_t acl = parse_number(w[2]);
+      const mapped_file_t* file = map_file(path);
+      uint64_t offset = (n >= 5) ? parse_number(w[4]) : 0;
+      uint64_t length = page_size();
+      if (w[0][9] == 's') {  // load_pages
+        length = (n == 6) ? parse_number(w[5]) :
+            ((offset < file->size) ? file->size - offset : 0);
+      }
+      for (uint64_t done = 0; done < length; done += page_size()) {
+        const uint8_t* page = file_bytes(file, offset + done, page_size(),
+            scratch_page);
+        extend_enclave_hash_with_page(&enclave_info, virtual_addr + done, acl,
+            (uintptr_t)page);
+      }
+    } else if (strcmp(w[0], "load_thread") == 0 && n == 5) {
+      extend_enclave_hash_with_thread(&enclave_info, parse_number(w[1]),
+          parse_number(w[2]), parse_number(w[3]), parse_number(w[4]));
+    } else {
+      fprintf(stderr, "sanctum_measure: %s:%zu: ", layout_path, line_number);
+      die("invalid line starting with %s", w[0]);
+    }
+    append_step(key, &enclave_info);
+  }
+  if (ferror(layout))
+    die("cannot read %s", layout_path);
+  fclose(layout);
+  if (!created)
+    die("%s: no create_enclave line", layout_path);
+  if (matching) {
+    // This layout is a prefix of the previous one.
+    restore_enclave_hash_checkpoint(&enclave_info,
+        &g_steps[step - 1].checkpoint);
+    truncate_steps(step);
+  }
+
+  finalize_enclave_hash(&enclave_info);
+  memcpy(hash, &enclave_info.hash, hash_result_size);
+  unmap_files();
+}
+
+static int measure_enclaves(int argc, char** argv) {
+  if (argc < 2)
+    usage();
+  for (int i = 1; i < argc; ++i) {
+    uint8_t hash[hash_result_size];
+    measure_enclave_layout(argv[i], hash);
+    print_hex(hash, sizeof(hash), argv[i]);
+  }
+  truncate_steps(0);
+  free(g_steps);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2)
+    usage();
+  if (strcmp(argv[1], "bootloader") == 0)
+    return measure_bootloader(argc - 1, argv + 1);
+  if (strcmp(argv[1], "sm") == 0)
+    return measure_sm(argc - 1, argv + 1);
+  if (strcmp(argv[1], "enclave") == 0)
+    return measure_enclaves(argc - 1, argv + 1);
+  usage();
+  return 2;
+}
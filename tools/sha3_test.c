@@ -0,0 +1,360 @@
+// Host test for the SHA-3 code in common/sha3.
+//
+// Checks Keccak-f[1600] against the permutation of the all-zero state, and
+// SHA3-224/256/384/512 against the NIST example digests of the empty message,
+// "abc", the 1600-bit message of 0xA3 bytes, and one million "a" bytes.
+// The 0xA3 message is also fed to sha3_update() from every byte alignment,
+// split in two at every offset and in many random pieces, to cover the
+// lane-wise fast path and the bytewise paths around it.
+//
+// The multi-buffer API is checked against the single-stream code: the
+// interleaved Keccak-f against sha3_keccakf() on random states, and
+// sha3_multi() and sha3_multi_update() against sha3() for 1 to 4 streams of
+// unequal, empty and misaligned messages:
+//
+//   sha3_test
+//
+// Prints the failing cases and exits with status 1 on any mismatch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha3/sha3.h"
+
+// Keccak-f[1600] applied once to the all-zero state.
+static const uint64_t keccakf_zero_state[25] = {
+  0xF1258F7940E1DDE7ULL, 0x84D5CCF933C0478AULL, 0xD598261EA65AA9EEULL,
+  0xBD1547306F80494DULL, 0x8B284E056253D057ULL, 0xFF97A42D7F8E6FD4ULL,
+  0x90FEE5A0A44647C4ULL, 0x8C5BDA0CD6192E76ULL, 0xAD30A6F71B19059CULL,
+  0x30935AB7D08FFC64ULL, 0xEB5AA93F2317D635ULL, 0xA9A6E6260D712103ULL,
+  0x81A57C16DBCF555FULL, 0x43B831CD0347C826ULL, 0x01F22F1A11A5569FULL,
+  0x05E5635A21D9AE61ULL, 0x64BEFEF28CC970F2ULL, 0x613670957BC46611ULL,
+  0xB87C5A554FD00ECBULL, 0x8C3EE88A1CCF32C8ULL, 0x940C7922AE3A2614ULL,
+  0x1841F924A2C509E4ULL, 0x16F53526E70465C2ULL, 0x75F644E97F30A13BULL,
+  0xEAF1FF7B5CECA249ULL,
+};
+
+// The first lane after a second permutation.
+#define keccakf_zero_state_twice_lane0 0x2D5C954DF96ECB3CULL
+
+typedef enum {
+  message_empty,
+  message_abc,
+  message_a3,
+  message_million_a,
+} message_kind_t;
+
+static const char* const message_names[] = {
+  "\"\"",
+  "\"abc\"",
+  "0xA3 x 200",
+  "\"a\" x 1000000",
+};
+
+typedef struct {
+  message_kind_t message;
+  int mdlen;
+  const char* digest;
+} sha3_vector_t;
+
+static const sha3_vector_t sha3_vectors[] = {
+  { message_empty, 28,
+    "6b4e03423667dbb73b6e15454f0eb1abd4597f9a1b078e3f5b5a6bc7" },
+  { message_empty, 32,
+    "a7ffc6f8bf1ed76651c14756a061d662f580ff4de43b49fa82d80a4b80f8434a" },
+  { message_empty, 48,
+    "0c63a75b845e4f7d01107d852e4c2485c51a50aaaa94fc61995e71bbee983a2a"
+    "c3713831264adb47fb6bd1e058d5f004" },
+  { message_empty, 64,
+    "a69f73cca23a9ac5c8b567dc185a756e97c982164fe25859e0d1dcc1475c80a6"
+    "15b2123af1f5f94c11e3e9402c3ac558f500199d95b6d3e301758586281dcd26" },
+  { message_abc, 28,
+    "e642824c3f8cf24ad09234ee7d3c766fc9a3a5168d0c94ad73b46fdf" },
+  { message_abc, 32,
+    "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532" },
+  { message_abc, 48,
+    "ec01498288516fc926459f58e2c6ad8df9b473cb0fc08c2596da7cf0e49be4b2"
+    "98d88cea927ac7f539f1edf228376d25" },
+  { message_abc, 64,
+    "b751850b1a57168a5693cd924b6b096e08f621827444f70d884f5d0240d2712e"
+    "10e116e9192af3c91a7ec57647e3934057340b4cf408d5a56592f8274eec53f0" },
+  { message_a3, 28,
+    "9376816aba503f72f96ce7eb65ac095deee3be4bf9bbc2a1cb7e11e0" },
+  { message_a3, 32,
+    "79f38adec5c20307a98ef76e8324afbfd46cfd81b22e3973c65fa1bd9de31787" },
+  { message_a3, 48,
+    "1881de2ca7e41ef95dc4732b8f5f002b189cc1e42b74168ed1732649ce1dbcdd"
+    "76197a31fd55ee989f2d7050dd473e8f" },
+  { message_a3, 64,
+    "e76dfad22084a8b1467fcf2ffa58361bec7628edf5f3fdc0e4805dc48caeeca8"
+    "1b7c13c30adf52a3659584739a2df46be589c51ca1a4a8416df6545a1ce8ba00" },
+  { message_million_a, 32,
+    "5c8875ae474a3634ba4fd55ec85bffd661f32aca75c6d699d0cdcb6c115891c1" },
+  { message_million_a, 64,
+    "3c3a876da14034ab60627c077bb98f7e120a2a5370212dffb3385a18d4f38859"
+    "ed311d0a9d5141ce9cc5c66ee689b266a8aa18ace8282a0e0db596c90b0a7b87" },
+};
+
+#define a3_message_size 200
+#define million_a_size 1000000
+
+// The bytes of a test message. Returns NULL if out of memory.
+static uint8_t* make_message(message_kind_t kind, size_t* size) {
+  static const size_t sizes[] = { 0, 3, a3_message_size, million_a_size };
+  *size = sizes[kind];
+  uint8_t* message = malloc(*size + 1);
+  if (message == NULL)
+    return NULL;
+  if (kind == message_abc)
+    memcpy(message, "abc", 3);
+  else
+    memset(message, (kind == message_a3) ? 0xA3 : 'a', *size);
+  return message;
+}
+
+// Formats a digest as lowercase hex.
+static void format_digest(char* hex, const uint8_t* digest, int mdlen) {
+  for (int i = 0; i < mdlen; ++i)
+    sprintf(hex + 2 * i, "%02x", digest[i]);
+}
+
+// Hashes `message`, fed to sha3_update() in pieces ending at `splits`.
+static void hash_in_pieces(uint8_t* digest, int mdlen, const uint8_t* message,
+    size_t size, const size_t* splits, size_t split_count) {
+  sha3_ctx_t ctx;
+  sha3_init(&ctx, mdlen);
+  size_t offset = 0;
+  for (size_t i = 0; i < split_count; ++i) {
+    sha3_update(&ctx, message + offset, splits[i] - offset);
+    offset = splits[i];
+  }
+  sha3_update(&ctx, message + offset, size - offset);
+  sha3_final(digest, &ctx);
+}
+
+// Checks one permutation, and a second one, of the all-zero state.
+static int check_keccakf() {
+  uint64_t st[25];
+  memset(st, 0, sizeof(st));
+  sha3_keccakf(st);
+  if (memcmp(st, keccakf_zero_state, sizeof(st)) != 0)
+    return 0;
+  sha3_keccakf(st);
+  return st[0] == keccakf_zero_state_twice_lane0;
+}
+
+// Checks a vector with sha3(), and with sha3_update() over pieces of the
+// message at every byte alignment. Returns the number of failures.
+static int check_vector(const sha3_vector_t* vector) {
+  const char* name = message_names[vector->message];
+  int failures = 0;
+
+  size_t size;
+  uint8_t* message = make_message(vector->message, &size);
+  uint8_t* shifted = malloc(size + 8);
+  if (message == NULL || shifted == NULL) {
+    fprintf(stderr, "sha3_test: out of memory\n");
+    exit(1);
+  }
+
+  uint8_t digest[64];
+  char hex[129];
+  sha3(message, size, digest, vector->mdlen);
+  format_digest(hex, digest, vector->mdlen);
+  if (strcmp(hex, vector->digest) != 0) {
+    fprintf(stderr, "sha3_test: SHA3-%d(%s) is %s\n", vector->mdlen * 8,
+        name, hex);
+    ++failures;
+  }
+
+  // The other checks cover the same paths for every message, so only the
+  // short ones go through them.
+  if (size > a3_message_size) {
+    free(shifted);
+    free(message);
+    return failures;
+  }
+
+  for (size_t alignment = 0; alignment < 8; ++alignment) {
+    uint8_t* input = shifted + alignment;
+    memcpy(input, message, size);
+
+    for (size_t split = 0; split <= size; ++split) {
+      hash_in_pieces(digest, vector->mdlen, input, size, &split, 1);
+      format_digest(hex, digest, vector->mdlen);
+      if (strcmp(hex, vector->digest) != 0) {
+        fprintf(stderr, "sha3_test: SHA3-%d(%s) at alignment %zu, split at "
+            "%zu is %s\n", vector->mdlen * 8, name, alignment, split, hex);
+        ++failures;
+      }
+    }
+
+    for (unsigned seed = 1; seed <= 64; ++seed) {
+      size_t splits[a3_message_size + 1];
+      size_t split_count = 0;
+      srand(seed);
+      for (size_t offset = 0; size != 0;) {
+        offset += 1 + rand() % 24;
+        if (offset >= size)
+          break;
+        splits[split_count++] = offset;
+      }
+      hash_in_pieces(digest, vector->mdlen, input, size, splits, split_count);
+      format_digest(hex, digest, vector->mdlen);
+      if (strcmp(hex, vector->digest) != 0) {
+        fprintf(stderr, "sha3_test: SHA3-%d(%s) at alignment %zu, in %zu "
+            "random pieces (seed %u) is %s\n", vector->mdlen * 8, name,
+            alignment, split_count + 1, seed, hex);
+        ++failures;
+      }
+    }
+  }
+
+  free(shifted);
+  free(message);
+  return failures;
+}
+
+// Checks sha3_keccakf_x2() and sha3_keccakf_x4() against sha3_keccakf() on
+// random states.
+static int check_keccakf_multi() {
+  srand(1);
+  for (int round = 0; round < 16; ++round) {
+    uint64_t st[4][25];
+    uint64_t expected[4][25];
+    for (int way = 0; way < 4; ++way) {
+      for (int i = 0; i < 25; ++i) {
+        st[way][i] = ((uint64_t)rand() << 40) ^ ((uint64_t)rand() << 20) ^
+            (uint64_t)rand();
+      }
+      memcpy(expected[way], st[way], sizeof(st[way]));
+      sha3_keccakf(expected[way]);
+    }
+    sha3_keccakf_x4(st[0], st[1], st[2], st[3]);
+    if (memcmp(st, expected, sizeof(st)) != 0)
+      return 0;
+    sha3_keccakf_x2(st[0], st[1]);
+    sha3_keccakf(expected[0]);
+    sha3_keccakf(expected[1]);
+    if (memcmp(st, expected, sizeof(st)) != 0)
+      return 0;
+  }
+  return 1;
+}
+
+#define multi_max_size 700
+
+// Message lengths for the multi-buffer checks: empty, around the SHA3-512
+// (72 bytes) and SHA3-256 (136 bytes) rates, and unequal across streams.
+static const size_t multi_sizes[][4] = {
+  { 0, 0, 0, 0 },
+  { 72, 72, 72, 72 },
+  { 136, 136, 136, 136 },
+  { 0, 71, 72, 73 },
+  { 135, 136, 137, 0 },
+  { 3, 200, 0, 575 },
+  { 700, 1, 288, 144 },
+  { 500, 500, 0, 500 },
+};
+
+// Checks sha3_multi(), and sha3_multi_update() fed in random pieces, against
+// sha3() for each stream. Returns the number of failures.
+static int check_multi() {
+  static uint8_t buffers[4][multi_max_size + 8];
+  srand(2);
+  for (int way = 0; way < 4; ++way) {
+    for (size_t i = 0; i < sizeof(buffers[way]); ++i)
+      buffers[way][i] = (uint8_t)rand();
+  }
+
+  static const int mdlens[] = { 28, 32, 48, 64 };
+  const size_t size_count = sizeof(multi_sizes) / sizeof(multi_sizes[0]);
+  int failures = 0;
+  for (int n = 1; n <= 4; ++n) {
+    for (size_t m = 0; m < sizeof(mdlens) / sizeof(mdlens[0]); ++m) {
+      for (size_t k = 0; k < size_count; ++k) {
+        const int mdlen = mdlens[m];
+        const void* in[4];
+        uint8_t digests[4][64];
+        void* md[4];
+        uint8_t expected[4][64];
+        for (int way = 0; way < n; ++way) {
+          // Each stream starts at a different byte alignment.
+          in[way] = buffers[way] + (way + k) % 8;
+          md[way] = digests[way];
+          sha3(in[way], multi_sizes[k][way], expected[way], mdlen);
+        }
+
+        sha3_multi(in, multi_sizes[k], md, n, mdlen);
+        for (int way = 0; way < n; ++way) {
+          if (memcmp(digests[way], expected[way], mdlen) != 0) {
+            fprintf(stderr, "sha3_test: sha3_multi with %d streams, "
+                "SHA3-%d, sizes #%zu, stream %d is wrong\n", n, mdlen * 8, k,
+                way);
+            ++failures;
+          }
+        }
+
+        sha3_multi_ctx_t ctx;
+        size_t offsets[4] = { 0, 0, 0, 0 };
+        sha3_multi_init(&ctx, n, mdlen);
+        for (int done = 0; !done;) {
+          const void* data[4];
+          size_t len[4];
+          done = 1;
+          for (int way = 0; way < n; ++way) {
+            size_t left = multi_sizes[k][way] - offsets[way];
+            len[way] = (size_t)rand() % 160;
+            if (len[way] > left)
+              len[way] = left;
+            data[way] = (const uint8_t*)in[way] + offsets[way];
+            offsets[way] += len[way];
+            if (offsets[way] != multi_sizes[k][way])
+              done = 0;
+          }
+          sha3_multi_update(&ctx, data, len);
+        }
+        sha3_multi_final(md, &ctx);
+        for (int way = 0; way < n; ++way) {
+          if (memcmp(digests[way], expected[way], mdlen) != 0) {
+            fprintf(stderr, "sha3_test: sha3_multi_update with %d streams, "
+                "SHA3-%d, sizes #%zu, stream %d is wrong\n", n, mdlen * 8, k,
+                way);
+            ++failures;
+          }
+        }
+      }
+    }
+  }
+  return failures;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 1) {
+    fprintf(stderr, "usage: sha3_test\n");
+    return 1;
+  }
+
+  int failures = 0;
+  if (!check_keccakf()) {
+    fprintf(stderr, "sha3_test: Keccak-f[1600] of the zero state is wrong\n");
+    ++failures;
+  }
+  const size_t vector_count = sizeof(sha3_vectors) / sizeof(sha3_vectors[0]);
+  for (size_t i = 0; i < vector_count; ++i)
+    failures += check_vector(&sha3_vectors[i]);
+  if (!check_keccakf_multi()) {
+    fprintf(stderr, "sha3_test: interleaved Keccak-f[1600] is wrong\n");
+    ++failures;
+  }
+  failures += check_multi();
+
+  if (failures != 0) {
+    fprintf(stderr, "sha3_test: %d failures\n", failures);
+    return 1;
+  }
+  printf("sha3_test: Keccak-f[1600], %zu SHA-3 vectors and sha3_multi ok\n",
+      vector_count);
+  return 0;
+}